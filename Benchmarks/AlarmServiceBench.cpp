@@ -0,0 +1,261 @@
+// Microbenchmarks of AlarmService commands, response serialization, state
+// persistence and Logger::Info, at zone counts from 10 to 1,000,000.
+// Results are printed as a table and, with --json, written as JSON so runs
+// can be diffed or fed to a regression check.
+//
+// Usage: AlarmServiceBench [--sizes 10,100,...] [--min-ms 200] [--filter text] [--json out.json]
+//
+// Build: the AlarmServiceBench target of the top-level CMakeLists.txt
+//   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target AlarmServiceBench
+// It runs in a scratch directory under the system temp directory, since
+// InitializeZones and the JSON state functions use fixed file names.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "AlarmService.h"
+#include "CommandParser.h"
+#include "JsonWriter.h"
+#include "LatencyHistogram.h"
+#include "Logger.h"
+#include "MotionSenzor.h"
+#include "ResponseWriter.h"
+
+using json = nlohmann::json;
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	struct BenchResult {
+		std::string name;
+		size_t zones = 0;		// 0 for benchmarks that do not depend on the site
+		uint64_t iterations = 0;
+		double meanNs = 0.0;
+		uint64_t p50Ns = 0;
+		uint64_t p99Ns = 0;
+		uint64_t maxNs = 0;
+	};
+
+	struct Options {
+		std::vector<size_t> sizes{ 10, 100, 1000, 10000, 100000, 1000000 };
+		uint64_t minMs = 200;
+		uint64_t maxIterations = 2000000;
+		std::string filter;
+		std::string jsonPath;
+	};
+
+	Options options;
+	std::vector<BenchResult> results;
+	volatile size_t sink = 0;
+
+	// Runs body until minMs has passed (at least once), timing every call;
+	// prepare runs untimed before each call to put the state back
+	void Measure(const std::string& name, size_t zones, const std::function<void()>& body,
+		const std::function<void()>& prepare = {})
+	{
+		if (!options.filter.empty() && name.find(options.filter) == std::string::npos) return;
+		LatencyHistogram histogram;
+		auto budget = std::chrono::milliseconds(options.minMs);
+		Clock::duration spent{};
+		while (histogram.Count() == 0 || (spent < budget && histogram.Count() < options.maxIterations)) {
+			if (prepare) prepare();
+			auto start = Clock::now();
+			body();
+			auto elapsed = Clock::now() - start;
+			spent += elapsed;
+			histogram.Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+		}
+
+		BenchResult result;
+		result.name = name;
+		result.zones = zones;
+		result.iterations = histogram.Count();
+		result.meanNs = histogram.Mean();
+		result.p50Ns = histogram.Percentile(50.0);
+		result.p99Ns = histogram.Percentile(99.0);
+		result.maxNs = histogram.Max();
+		std::printf("%-28s %9zu %10llu %14.1f %12llu %12llu %12llu\n", name.c_str(), zones,
+			static_cast<unsigned long long>(result.iterations), result.meanNs,
+			static_cast<unsigned long long>(result.p50Ns), static_cast<unsigned long long>(result.p99Ns),
+			static_cast<unsigned long long>(result.maxNs));
+		std::fflush(stdout);
+		results.push_back(result);
+	}
+
+	// Same line format as the bundled zones.csv; zones alternate between
+	// the two partitions InitializeZones creates
+	void WriteZonesCsv(size_t zoneCount)
+	{
+		static const char* types[] = { "Motion Sensor", "Door Contact", "Generic" };
+		std::string text;
+		text.reserve(zoneCount * 40);
+		for (size_t i = 1; i <= zoneCount; i++) {
+			text += std::to_string(i);
+			text += ';';
+			text += types[i % 3];
+			text += ";Zone ";
+			text += std::to_string(i);
+			text += ';';
+			text += std::to_string(1 + i % 2);
+			text += '\n';
+		}
+		std::ofstream("zones.csv", std::ios::binary).write(text.data(), text.size());
+	}
+
+	void BenchSite(size_t zoneCount)
+	{
+		WriteZonesCsv(zoneCount);
+		AlarmService service;
+		Measure("InitializeZones", zoneCount, [&] { service.InitializeZones(); });
+		if (service.GetZoneById(1) == nullptr) service.InitializeZones();
+
+		std::mt19937 random(42);
+		std::uniform_int_distribution<int> zonePick(1, static_cast<int>(zoneCount));
+		Measure("GetZoneById", zoneCount, [&] { sink = sink + (service.GetZoneById(zonePick(random)) != nullptr); });
+
+		int partitionId = 1;
+		Measure("ArmPartition", zoneCount,
+			[&] { sink = sink + service.ArmPartition(partitionId).size(); },
+			[&] { partitionId = 3 - partitionId; service.DisarmPartition(partitionId); });
+		Measure("DisarmPartition", zoneCount,
+			[&] { sink = sink + service.DisarmPartition(partitionId).size(); },
+			[&] { partitionId = 3 - partitionId; service.ArmPartition(partitionId); });
+
+		// A mixed site for the listings: partition 1 armed, every 10th zone
+		// bypassed, every 100th armed zone alarming
+		service.DisarmPartition(1);
+		service.DisarmPartition(2);
+		for (size_t id = 10; id <= zoneCount; id += 10) {
+			service.BypassZone(static_cast<int>(id), true);
+		}
+		service.ArmPartition(1);
+		for (size_t id = 1; id <= zoneCount; id += 100) {
+			service.TriggerZone(static_cast<int>(id));
+		}
+		Measure("ListAllZones", zoneCount, [&] { sink = sink + service.ListAllZones().size(); });
+		Measure("ListArmedZones", zoneCount, [&] { sink = sink + service.ListArmedZones().size(); });
+		Measure("ListDisarmedZones", zoneCount, [&] { sink = sink + service.ListDisarmedZones().size(); });
+		Measure("ListBypassedZones", zoneCount, [&] { sink = sink + service.ListBypassedZones().size(); });
+		Measure("ListAlarmingZones", zoneCount, [&] { sink = sink + service.ListAlarmingZones().size(); });
+
+		Measure("SaveStateToJson", zoneCount, [&] { service.SaveStateToJson(); });
+		Measure("LoadStateFromJson", zoneCount, [&] { service.LoadStateFromJson(); });
+	}
+
+	void BenchSerialization()
+	{
+		// CreateResponse forwards to ResponseWriter::Response, and zone
+		// listings are written with ResponseWriter::WriteZone
+		Measure("ResponseWriter::Response", 0, [] {
+			sink = sink + ResponseWriter::Response("SUCCESS", "Zone armed", 42, "ARMED").size();
+		});
+		MotionSenzor zone(42, "Hallway motion", 1);
+		std::string out;
+		Measure("ResponseWriter::WriteZone", 0, [&] {
+			out.clear();
+			JsonWriter writer(out);
+			ResponseWriter::WriteZone(writer, zone);
+			sink = sink + out.size();
+		});
+	}
+
+	void BenchLogger()
+	{
+		int id = 0;
+		std::string name = "Hallway motion";
+		Measure("Logger::Info(text)", 0, [&] { Logger::Info("Zone " + std::to_string(++id) + " (" + name + ") is armed."); });
+		Measure("Logger::Info<ZONE_ARMED>", 0, [&] { Logger::Info<LogFormat::ZONE_ARMED>(++id, name); });
+	}
+
+	bool ParseOptions(int argc, char* argv[])
+	{
+		for (int i = 1; i < argc; i++) {
+			std::string argument = argv[i];
+			bool hasValue = i + 1 < argc;
+			if (argument == "--sizes" && hasValue) {
+				std::vector<int> sizes;
+				if (!CommandParser::ParseIdList(argv[++i], sizes, 64)) return false;
+				options.sizes.assign(sizes.begin(), sizes.end());
+			}
+			else if (argument == "--min-ms" && hasValue) options.minMs = std::strtoull(argv[++i], nullptr, 10);
+			else if (argument == "--filter" && hasValue) options.filter = argv[++i];
+			else if (argument == "--json" && hasValue) options.jsonPath = argv[++i];
+			else return false;
+		}
+		return true;
+	}
+
+	bool WriteJson(const std::string& path)
+	{
+		json out;
+		std::time_t now = std::time(nullptr);
+		char date[32];
+		std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+		out["context"] = {
+			{ "date", date },
+			{ "hardwareThreads", std::thread::hardware_concurrency() },
+#ifdef NDEBUG
+			{ "build", "release" },
+#else
+			{ "build", "debug" },
+#endif
+			{ "minMs", options.minMs }
+		};
+		json benchmarks = json::array();
+		for (const auto& result : results) {
+			benchmarks.push_back({
+				{ "name", result.name },
+				{ "zones", result.zones },
+				{ "iterations", result.iterations },
+				{ "meanNs", result.meanNs },
+				{ "p50Ns", result.p50Ns },
+				{ "p99Ns", result.p99Ns },
+				{ "maxNs", result.maxNs }
+			});
+		}
+		out["benchmarks"] = benchmarks;
+		std::ofstream file(path);
+		file << out.dump(2) << "\n";
+		return file.good();
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (!ParseOptions(argc, argv)) {
+		std::fprintf(stderr, "Usage: AlarmServiceBench [--sizes 10,100,...] [--min-ms 200] [--filter text] [--json out.json]\n");
+		return 2;
+	}
+	// Resolve the output path before leaving the current directory
+	if (!options.jsonPath.empty()) options.jsonPath = std::filesystem::absolute(options.jsonPath).string();
+	auto scratch = std::filesystem::temp_directory_path() / "hik_alarm_bench";
+	std::filesystem::create_directories(scratch);
+	std::filesystem::current_path(scratch);
+
+	Logger::Init("bench.log", false);
+	// Measure sustained logging cost, not how fast messages can be dropped
+	Logger::SetOverflowPolicy(LogOverflowPolicy::BLOCK);
+
+	std::printf("%-28s %9s %10s %14s %12s %12s %12s\n", "Benchmark", "Zones", "Iterations", "Mean ns", "p50 ns", "p99 ns", "Max ns");
+	BenchSerialization();
+	BenchLogger();
+	for (size_t zoneCount : options.sizes) {
+		BenchSite(zoneCount);
+	}
+	Logger::Shutdown();
+
+	if (!options.jsonPath.empty() && !WriteJson(options.jsonPath)) {
+		std::fprintf(stderr, "Failed to write %s\n", options.jsonPath.c_str());
+		return 1;
+	}
+	return 0;
+}
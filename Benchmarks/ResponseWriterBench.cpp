@@ -0,0 +1,105 @@
+// Allocations and time per response: nlohmann::json DOM vs ResponseWriter.
+//
+// Build: the ResponseWriterBench target of the top-level CMakeLists.txt
+//   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target ResponseWriterBench
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <nlohmann/json.hpp>
+#include "MotionSenzor.h"
+#include "ResponseWriter.h"
+
+using json = nlohmann::json;
+
+namespace {
+	std::atomic<uint64_t> allocationCount{ 0 };
+}
+
+void* operator new(size_t size)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	if (void* block = std::malloc(size ? size : 1)) return block;
+	throw std::bad_alloc();
+}
+void operator delete(void* block) noexcept { std::free(block); }
+void operator delete(void* block, size_t) noexcept { std::free(block); }
+
+namespace {
+	constexpr int kIterations = 200000;
+	volatile size_t sink = 0;
+
+	// The pre-ResponseWriter implementations, kept verbatim for comparison
+	std::string DomResponse(const std::string& status, const std::string& message, int id, const std::string& state)
+	{
+		json responseJson;
+		responseJson["status"] = status;
+		responseJson["message"] = message;
+		if (id != -1) responseJson["id"] = id;
+		if (!state.empty()) responseJson["newState"] = state;
+		return responseJson.dump();
+	}
+	std::string DomZone(Zone& zone)
+	{
+		json jZone;
+		jZone["id"] = zone.id;
+		jZone["name"] = zone.name;
+		jZone["type"] = zone.GetType();
+		jZone["armed"] = zone.isArmed;
+		jZone["bypassed"] = zone.isBypassed;
+		jZone["alarming"] = zone.isAlarming;
+		jZone["active"] = zone.isActive;
+		jZone["tampered"] = zone.isTampered;
+		jZone["faulted"] = zone.isFaulted;
+		jZone["partitionId"] = zone.partitionId;
+		return jZone.dump();
+	}
+
+	template <typename Body>
+	void Measure(const char* name, Body&& body)
+	{
+		body(); // warm-up, lets reused buffers reach their final capacity
+		uint64_t allocationsBefore = allocationCount.load();
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < kIterations; i++) {
+			body();
+		}
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		uint64_t allocations = allocationCount.load() - allocationsBefore;
+		double nanoseconds = std::chrono::duration<double, std::nano>(elapsed).count() / kIterations;
+		std::printf("%-34s %8.2f allocs/op %9.1f ns/op\n", name, static_cast<double>(allocations) / kIterations, nanoseconds);
+	}
+}
+
+int main()
+{
+	MotionSenzor zone(42, "Nappali Mozgas", 2);
+	zone.isArmed = true;
+
+	const std::string message = "Zone 42 armed successfully";
+	std::string buffer;
+
+	Measure("response / nlohmann DOM", [&] {
+		sink = sink + DomResponse("SUCCESS", message, 42, "ARMED").size();
+	});
+	Measure("response / ResponseWriter", [&] {
+		sink = sink + ResponseWriter::Response("SUCCESS", message, 42, "ARMED").size();
+	});
+	Measure("response / ResponseWriter reused", [&] {
+		buffer.clear();
+		ResponseWriter::WriteResponse(buffer, "SUCCESS", message, 42, "ARMED");
+		sink = sink + buffer.size();
+	});
+	Measure("zone / nlohmann DOM", [&] {
+		sink = sink + DomZone(zone).size();
+	});
+	Measure("zone / ResponseWriter reused", [&] {
+		buffer.clear();
+		JsonWriter writer(buffer);
+		ResponseWriter::WriteZone(writer, zone);
+		sink = sink + buffer.size();
+	});
+	return 0;
+}
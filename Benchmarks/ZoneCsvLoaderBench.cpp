@@ -0,0 +1,128 @@
+// zones.csv load time: the original getline/stringstream/stoi loop vs
+// ZoneCsvLoader on one thread and on every hardware thread.
+//
+// Usage: ZoneCsvLoaderBench [lines, default 500000]
+//
+// Build: the ZoneCsvLoaderBench target of the top-level CMakeLists.txt
+//   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target ZoneCsvLoaderBench
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "DoorContact.h"
+#include "MotionSenzor.h"
+#include "ZoneCsvLoader.h"
+
+namespace {
+	constexpr const char* kFile = "zones_bench.csv";
+	constexpr int kRuns = 5;
+
+	void WriteInput(size_t lineCount)
+	{
+		static const char* types[] = { "Motion Sensor", "Door Contact", "Generic" };
+		std::string text;
+		text.reserve(lineCount * 40);
+		for (size_t i = 1; i <= lineCount; i++) {
+			text += std::to_string(i);
+			text += ';';
+			text += types[i % 3];
+			text += ";Zone ";
+			text += std::to_string(i);
+			text += ';';
+			text += std::to_string(1 + i % 2);
+			text += '\n';
+		}
+		std::ofstream(kFile, std::ios::binary).write(text.data(), text.size());
+	}
+
+	// The pre-ZoneCsvLoader parsing loop of AlarmService::InitializeZones,
+	// without its per-zone log line
+	std::vector<std::shared_ptr<Zone>> LoadWithGetline()
+	{
+		std::vector<std::shared_ptr<Zone>> zones;
+		std::ifstream file(kFile);
+		std::string line;
+		while (std::getline(file, line)) {
+			if (line.empty()) continue;
+			std::stringstream ss(line);
+			std::string segment;
+			std::vector<std::string> parts;
+			while (std::getline(ss, segment, ';')) {
+				parts.push_back(segment);
+			}
+			if (parts.size() < 3) continue;
+			int zoneId = std::stoi(parts[0]);
+			int zonePartitionId = parts.size() >= 4 ? std::stoi(parts[3]) : -1;
+			if (parts[1] == "Motion Sensor") {
+				zones.push_back(std::make_shared<MotionSenzor>(zoneId, parts[2], zonePartitionId));
+			}
+			else if (parts[1] == "Door Contact") {
+				zones.push_back(std::make_shared<DoorContact>(zoneId, parts[2], zonePartitionId));
+			}
+			else {
+				zones.push_back(std::make_shared<Zone>(zoneId, parts[2], zonePartitionId));
+			}
+		}
+		return zones;
+	}
+
+	// Best of kRuns, in milliseconds
+	template <typename Body>
+	double Measure(Body&& body)
+	{
+		double best = 1e300;
+		for (int run = 0; run < kRuns; run++) {
+			auto start = std::chrono::steady_clock::now();
+			body();
+			double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			if (elapsed < best) best = elapsed;
+		}
+		return best;
+	}
+
+	bool SameZones(const std::vector<std::shared_ptr<Zone>>& a, const std::vector<std::shared_ptr<Zone>>& b)
+	{
+		if (a.size() != b.size()) return false;
+		for (size_t i = 0; i < a.size(); i++) {
+			if (a[i]->id != b[i]->id || a[i]->name != b[i]->name
+				|| a[i]->partitionId != b[i]->partitionId || a[i]->GetType() != b[i]->GetType()) return false;
+		}
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	size_t lineCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500000;
+	WriteInput(lineCount);
+	size_t threads = std::thread::hardware_concurrency();
+
+	// Every variant must produce the same zones before any timing counts
+	auto reference = LoadWithGetline();
+	ZoneCsvResult single = ZoneCsvLoader::Load(kFile, 1);
+	ZoneCsvResult parallel = ZoneCsvLoader::Load(kFile);
+	// An odd chunk count exercises the merge even on a small machine
+	ZoneCsvResult sevenChunks = ZoneCsvLoader::Load(kFile, 7);
+	if (!SameZones(reference, single.zones) || !SameZones(reference, parallel.zones)
+		|| !SameZones(reference, sevenChunks.zones) || sevenChunks.lineCount != lineCount
+		|| !single.skipped.empty() || !parallel.skipped.empty()) {
+		std::printf("MISMATCH: loaders disagree\n");
+		return 1;
+	}
+
+	std::printf("%zu lines, %zu hardware threads, %zu chunks\n", lineCount, threads, parallel.chunkCount);
+	double getlineMs = Measure([] { LoadWithGetline(); });
+	double singleMs = Measure([] { ZoneCsvLoader::Load(kFile, 1); });
+	double parallelMs = Measure([] { ZoneCsvLoader::Load(kFile); });
+	std::printf("%-30s %9.1f ms\n", "getline + stringstream + stoi", getlineMs);
+	std::printf("%-30s %9.1f ms  (%.1fx)\n", "ZoneCsvLoader, 1 thread", singleMs, getlineMs / singleMs);
+	std::printf("%-30s %9.1f ms  (%.1fx)\n", "ZoneCsvLoader, all threads", parallelMs, getlineMs / parallelMs);
+
+	std::remove(kFile);
+	return 0;
+}
@@ -1,335 +1,850 @@
 #include "AlarmService.h"
-#include "MotionSenzor.h"
-#include "DoorContact.h"
 #include "Zone.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <nlohmann/json.hpp>
 #include "Logger.h"	
+#include "ResponseWriter.h"
+#include "FileApi.h"
+#include "MappedFile.h"
+#include "ZoneCsvLoader.h"
+#include "ZoneFactory.h"
+#include "CommandParser.h"
+#include "Tracer.h"
 
-AlarmService::AlarmService() {}
-AlarmService::~AlarmService() {}
+AlarmService::AlarmService()
+	: changeSequence(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count()))
+{
+}
+AlarmService::~AlarmService() {
+	timers.Stop();
+	sensors.Stop();
+	snapshotTask.Stop();
+	journal.Close();
+}
 using json = nlohmann::json;
 
+namespace {
+	constexpr const char* kZonesFile = "zones.csv";
+	constexpr const char* kStateFile = "system_state.json";
+	constexpr const char* kSnapshotFile = "system_state.snap";
+	constexpr const char* kJournalFile = "state_journal.bin";
+	// Fold the journal into a snapshot once it holds this many records
+	constexpr size_t kJournalCompactionRecords = 50000;
+	constexpr auto kSnapshotInterval = std::chrono::minutes(5);
+}
+
 // Initialize zones from zones.csv
 void AlarmService::InitializeZones()
 {
+	Logger::Info<LogFormat::ZONES_LOADING>();
+	auto start = std::chrono::steady_clock::now();
+	// Parsed before taking the lock; only the swap-in is exclusive
+	ZoneCsvResult loaded = ZoneCsvLoader::Load(kZonesFile);
+
+	std::unique_lock<std::shared_mutex> structureLock(structureMutex);
+
 	// Temporary partitions for test
 	partitions.clear();
 	partitions.push_back(std::make_shared<Partition>(1, "Default Partition"));
 	partitions.push_back(std::make_shared<Partition>(2, "Garage Partition"));
-	Logger::Info("Initialized 2 dummy partitions.");
+	Logger::Info<LogFormat::PARTITIONS_INITIALIZED>();
 
-	Logger::Info("Initializing zones from zones.csv");
 	zones.clear();
-	std::ifstream file("zones.csv");
-	if (!file.is_open())
+	if (!loaded.opened)
 	{
-		Logger::Error("Failed to open zones.csv");
+		Logger::Error<LogFormat::ZONES_OPEN_FAILED>();
+		RebuildIndexes();
 		return;
 	}
-	std::string line;
-
-	while (std::getline(file, line)) {
-		if (line.empty()) continue;
-
-		std::stringstream ss(line);
-		std::string segment;
-		std::vector<std::string> parts;
-
-		while (std::getline(ss, segment, ';')) {
-			parts.push_back(segment);
-		}
-		if (parts.size() >= 3)
-		{
-			int zoneId = std::stoi(parts[0]);
-			std::string zoneType = parts[1];
-			std::string zoneName = parts[2];
-			int zonePartitionId = -1;
-
-			if (parts.size() >= 4) 
-			{
-				try
-				{
-					zonePartitionId = std::stoi(parts[3]);
-
-				}
-				catch (const std::exception&)
-				{
-					Logger::Error("Error while reading partition data for zone " + std::to_string(zoneId));
-				}
-			}
-
-			std::shared_ptr<Zone> newZone;
-			if (zoneType == "Motion Sensor")
-			{
-				newZone = std::make_shared<MotionSenzor>(zoneId, zoneName, zonePartitionId);
-			}
-			else if (zoneType == "Door Contact")
-			{
-				newZone = std::make_shared<DoorContact>(zoneId, zoneName, zonePartitionId);
-			}
-			else
-			{
-				newZone = std::make_shared<Zone>(zoneId, zoneName, zonePartitionId);
-			}
-			zones.push_back(newZone);
-			Logger::Info("Added zone: ID=" + std::to_string(zoneId) + ", Name=" + zoneName + ", Type=" + zoneType);
-		}
-		else {
-			Logger::Error("Invalid line in zones.csv: " + line);
-		}
-
+	std::vector<int> partitionIds;
+	for (const auto& partition : partitions) {
+		partitionIds.push_back(partition->id);
 	}
-	file.close();
-	Logger::Info(std::to_string(zones.size()) + " zones initialized.");
+	ZoneCsvLoader::Validate(loaded, partitionIds);
+	if (!loaded.skipped.empty()) {
+		Logger::Error<LogFormat::ZONES_LINES_SKIPPED>(loaded.skipped.size(), ZoneCsvLoader::Summarize(loaded.skipped));
+	}
+	if (!loaded.warnings.empty()) {
+		Logger::Warning<LogFormat::ZONES_LINE_WARNINGS>(loaded.warnings.size(), ZoneCsvLoader::Summarize(loaded.warnings));
+	}
+	zones = std::move(loaded.zones);
+	RebuildIndexes();
 
+	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+	Logger::Info<LogFormat::ZONES_INITIALIZED>(zones.size(), loaded.lineCount, elapsed, loaded.chunkCount);
 }
 std::string AlarmService::ArmZone(int zoneId)
 {
-	auto zone = GetZoneById(zoneId);
+	return ToJson(ArmZoneResult(zoneId));
+}
+std::string AlarmService::DisarmZone(int zoneId) {
+	return ToJson(DisarmZoneResult(zoneId));
+}
+std::string AlarmService::BypassZone(int zoneId, bool active) {
+	return ToJson(BypassZoneResult(zoneId, active));
+}
+std::string AlarmService::GetZoneStatus(int zoneId)
+{
+	return ToJson(ZoneStatusResult(zoneId));
+}
+std::string AlarmService::TriggerZone(int zoneId)
+{
+	return ToJson(TriggerZoneResult(zoneId));
+}
+CommandResult AlarmService::ArmZoneResult(int zoneId)
+{
+	HIK_TRACE_SCOPE("service", "ArmZone");
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	auto zone = FindZone(zoneId);
 
 	if (!zone) {
-		Logger::Warning("Arm failed: Zone " + std::to_string(zoneId) + " not found.");
-		return CreateResponse("ERROR", "Zone not found", zoneId);
-	}
-	if (zone->isArmed) {
-		Logger::Info("Arm request: Zone " + std::to_string(zoneId) + " already armed.");
-		return CreateResponse("IGNORED", "Zone is already armed", zoneId, "ARMED");
-	}
-	if (zone->isBypassed) {
-		Logger::Info("Arm failed: Zone " + std::to_string(zoneId) + " is bypassed.");
-		return CreateResponse("INFO", "Zone is bypassed, failed to arm", zoneId, "BYPASSED");
+		Logger::Warning<LogFormat::ARM_ZONE_NOT_FOUND>(zoneId);
+		return ZoneNotFound(zoneId);
 	}
-
-	zone->Arm();
-	return CreateResponse("SUCCESS", "Zone " + std::to_string(zoneId) + " armed successfully", zoneId, "ARMED");
+	std::unique_lock<std::shared_mutex> shardLock(ShardFor(zone->partitionId));
+	return ApplyZoneOperation(ZoneOperation::ARM, zoneIndex.Find(zoneId), true);
 }
-std::string AlarmService::DisarmZone(int zoneId) {
-	auto zone = GetZoneById(zoneId);
+CommandResult AlarmService::DisarmZoneResult(int zoneId) {
+	HIK_TRACE_SCOPE("service", "DisarmZone");
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	auto zone = FindZone(zoneId);
 
 	if (!zone) {
-		Logger::Info("Disarm failed: Zone " + std::to_string(zoneId) + " not found.");
-		return CreateResponse("ERROR", "Zone not found", zoneId);
-	}
-	if (!zone->isArmed) {
-		Logger::Info("Disarm request: Zone " + std::to_string(zoneId) + " already disarmed.");
-		return CreateResponse("IGNORED", "Zone is already disarmed", zoneId, "DISARMED");
+		Logger::Info<LogFormat::DISARM_ZONE_NOT_FOUND>(zoneId);
+		return ZoneNotFound(zoneId);
 	}
-
-	zone->Disarm();
-	return CreateResponse("SUCCESS", "Zone " + std::to_string(zoneId) + " disarmed successfully", zoneId, "DISARMED");
+	std::unique_lock<std::shared_mutex> shardLock(ShardFor(zone->partitionId));
+	return ApplyZoneOperation(ZoneOperation::DISARM, zoneIndex.Find(zoneId), true);
 }
-std::string AlarmService::BypassZone(int zoneId, bool active) {
-	auto zone = GetZoneById(zoneId);
+CommandResult AlarmService::BypassZoneResult(int zoneId, bool active) {
+	HIK_TRACE_SCOPE("service", "BypassZone");
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	auto zone = FindZone(zoneId);
 	if (!zone) {
-		Logger::Info("Bypass failed: Zone " + std::to_string(zoneId) + " not found.");
-		return CreateResponse("ERROR", "Zone not found", zoneId);
+		Logger::Info<LogFormat::BYPASS_ZONE_NOT_FOUND>(zoneId);
+		return ZoneNotFound(zoneId);
 	}
-	zone->SetBypass(active);
-	std::string state = active ? "BYPASSED" : "UNBYPASSED";
-	std::string msg = active ? "bypassed" : "unbypassed";
-
-	return CreateResponse("SUCCESS", "Zone " + std::to_string(zoneId) + " " + msg, zoneId, state);
+	std::unique_lock<std::shared_mutex> shardLock(ShardFor(zone->partitionId));
+	return ApplyZoneOperation(active ? ZoneOperation::BYPASS : ZoneOperation::UNBYPASS, zoneIndex.Find(zoneId), true);
 }
-std::string AlarmService::GetZoneStatus(int zoneId)
+CommandResult AlarmService::ZoneStatusResult(int zoneId)
 {
-	auto zone = GetZoneById(zoneId);
-	if (!zone) return CreateResponse("ERROR", "Zone not found", zoneId);
-
-	std::string statusStr;
-	if (zone->isBypassed) statusStr = "BYPASSED";
-	else if (zone->isAlarming) statusStr = "ALARMING";
-	else if (zone->isArmed) statusStr = "ARMED";
-	else statusStr = "DISARMED";
-
-	return CreateResponse("SUCCESS", "Status query", zoneId, statusStr);
+	HIK_TRACE_SCOPE("service", "ZoneStatus");
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	auto zone = FindZone(zoneId);
+	if (!zone) return ZoneNotFound(zoneId);
+	std::shared_lock<std::shared_mutex> shardLock(ShardFor(zone->partitionId));
+	return ApplyZoneOperation(ZoneOperation::STATUS, zoneIndex.Find(zoneId), true);
 }
-std::string AlarmService::TriggerZone(int zoneId)
+CommandResult AlarmService::TriggerZoneResult(int zoneId)
 {
-	auto zone = GetZoneById(zoneId);
+	HIK_TRACE_SCOPE("service", "TriggerZone");
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	auto zone = FindZone(zoneId);
 	if (!zone)
 	{
-		Logger::Info("Trigger failed " + std::to_string(zoneId) + " not found.");
-		return CreateResponse("ERROR", "Zone not found", zoneId);
+		Logger::Info<LogFormat::TRIGGER_ZONE_NOT_FOUND>(zoneId);
+		return ZoneNotFound(zoneId);
 	}
-	if (zone->isBypassed) {
-		Logger::Info("Trigger ignored: Zone " + std::to_string(zoneId) + " is bypassed.");
-		return CreateResponse("IGNORED", "Zone is bypassed", zoneId, "BYPASSED");
+	std::unique_lock<std::shared_mutex> shardLock(ShardFor(zone->partitionId));
+	return ApplyZoneOperation(ZoneOperation::TRIGGER, zoneIndex.Find(zoneId), true);
+}
+// Caller holds the zone's stripe (shared is enough for STATUS)
+CommandResult AlarmService::ApplyZoneOperation(ZoneOperation operation, uint32_t zoneSlot, bool logDetails)
+{
+	Zone& zone = *zones[zoneSlot];
+	int zoneId = zone.id;
+	switch (operation) {
+	case ZoneOperation::ARM:
+		if (zone.isArmed) {
+			if (logDetails) Logger::Info<LogFormat::ARM_ZONE_ALREADY_ARMED>(zoneId);
+			return MakeResult(CommandStatus::IGNORED, "Zone is already armed", zone, "ARMED");
+		}
+		if (zone.isBypassed) {
+			if (logDetails) Logger::Info<LogFormat::ARM_ZONE_BYPASSED>(zoneId);
+			return MakeResult(CommandStatus::INFO, "Zone is bypassed, failed to arm", zone, "BYPASSED");
+		}
+		zone.Arm(logDetails);
+		ZoneStateChanged(zoneSlot);
+		return MakeResult(CommandStatus::SUCCESS, "Zone " + std::to_string(zoneId) + " armed successfully", zone, "ARMED");
+	case ZoneOperation::DISARM:
+		if (!zone.isArmed) {
+			if (logDetails) Logger::Info<LogFormat::DISARM_ZONE_ALREADY_DISARMED>(zoneId);
+			return MakeResult(CommandStatus::IGNORED, "Zone is already disarmed", zone, "DISARMED");
+		}
+		zone.Disarm(logDetails);
+		ZoneStateChanged(zoneSlot);
+		return MakeResult(CommandStatus::SUCCESS, "Zone " + std::to_string(zoneId) + " disarmed successfully", zone, "DISARMED");
+	case ZoneOperation::BYPASS:
+	case ZoneOperation::UNBYPASS: {
+		bool active = operation == ZoneOperation::BYPASS;
+		zone.SetBypass(active, logDetails);
+		ZoneStateChanged(zoneSlot);
+		std::string state = active ? "BYPASSED" : "UNBYPASSED";
+		std::string msg = active ? "bypassed" : "unbypassed";
+
+		return MakeResult(CommandStatus::SUCCESS, "Zone " + std::to_string(zoneId) + " " + msg, zone, state);
 	}
-	if (zone->isArmed)
-	{
-		zone->isAlarming = true;
-		Logger::Warning("ALARM TRIGGERED on Zone " + std::to_string(zoneId));
-		return CreateResponse("ALARM", "Zone is triggered " + std::to_string(zoneId), zoneId, "ALARMING");
+	case ZoneOperation::TRIGGER:
+		if (zone.isBypassed) {
+			if (logDetails) Logger::Info<LogFormat::TRIGGER_ZONE_BYPASSED>(zoneId);
+			return MakeResult(CommandStatus::IGNORED, "Zone is bypassed", zone, "BYPASSED");
+		}
+		if (zone.isArmed && !zone.isAlarming && zoneTimers[zoneSlot].entryDelayMs > 0) {
+			if (zoneTimers[zoneSlot].entryTimer != 0) {
+				return MakeResult(CommandStatus::IGNORED, "Entry delay already running", zone, "ENTRY_DELAY");
+			}
+			StartEntryDelay(zoneSlot);
+			return MakeResult(CommandStatus::INFO, "Entry delay started for zone " + std::to_string(zoneId), zone, "ENTRY_DELAY");
+		}
+		if (zone.isArmed)
+		{
+			zone.isAlarming = true;
+			ZoneStateChanged(zoneSlot);
+			if (logDetails) Logger::Warning<LogFormat::ZONE_ALARM_TRIGGERED>(zoneId);
+			return MakeResult(CommandStatus::ALARM, "Zone is triggered " + std::to_string(zoneId), zone, "ALARMING");
+		}
+		if (logDetails) Logger::Info<LogFormat::TRIGGER_ZONE_DISARMED>(zoneId);
+		return MakeResult(CommandStatus::IGNORED, "Zone is disarmed", zone, "DISARMED");
+	default: {
+		std::string statusStr;
+		if (zone.isBypassed) statusStr = "BYPASSED";
+		else if (zone.isAlarming) statusStr = "ALARMING";
+		else if (zone.isArmed) statusStr = "ARMED";
+		else statusStr = "DISARMED";
+
+		return MakeResult(CommandStatus::SUCCESS, "Status query", zone, statusStr);
 	}
-	else {
-		Logger::Info("Trigger ignored: Zone " + std::to_string(zoneId) + " is disarmed.");
-		return CreateResponse("IGNORED", "Zone is disarmed", zoneId, "DISARMED");
 	}
 }
+// One operation over many zones. The structure lock and every stripe the
+// zones live on are taken once, in index order, for the whole batch; zones
+// are then processed in request order and logged as one summary line.
+std::vector<CommandResult> AlarmService::ZoneBatchResult(ZoneOperation operation, const std::vector<int>& zoneIds)
+{
+	HIK_TRACE_SCOPE("service", "ZoneBatch");
+	std::vector<CommandResult> results;
+	results.reserve(zoneIds.size());
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+
+	std::vector<uint32_t> slots(zoneIds.size());
+	for (size_t i = 0; i < zoneIds.size(); i++) {
+		slots[i] = zoneIndex.Find(zoneIds[i]);
+	}
+	ShardLocks locks;
+	LockShardsOf(slots, operation != ZoneOperation::STATUS, locks);
+
+	size_t succeeded = 0;
+	for (size_t i = 0; i < zoneIds.size(); i++) {
+		if (slots[i] == IdIndex::kNotFound) {
+			results.push_back(ZoneNotFound(zoneIds[i]));
+			continue;
+		}
+		results.push_back(ApplyZoneOperation(operation, slots[i], false));
+		if (results.back().status == CommandStatus::SUCCESS || results.back().status == CommandStatus::ALARM) succeeded++;
+	}
+	Logger::Info<LogFormat::ZONE_BATCH_DONE>(ZoneOperationName(operation), zoneIds.size(), succeeded, locks.Count());
+	return results;
+}
+// Sensor changes arrive debounced and batched; only those that differ from
+// the zone's current state are applied (and logged by the zone)
+void AlarmService::ApplySensorChanges(const std::vector<SensorEvent>& changes)
+{
+	HIK_TRACE_SCOPE("service", "ApplySensorChanges");
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	std::vector<uint32_t> slots(changes.size());
+	for (size_t i = 0; i < changes.size(); i++) {
+		slots[i] = zoneIndex.Find(changes[i].zoneId);
+	}
+	ShardLocks locks;
+	LockShardsOf(slots, true, locks);
+
+	size_t unknown = 0;
+	int firstUnknown = 0;
+	for (size_t i = 0; i < changes.size(); i++) {
+		if (slots[i] == IdIndex::kNotFound) {
+			if (unknown++ == 0) firstUnknown = changes[i].zoneId;
+			continue;
+		}
+		Zone& zone = *zones[slots[i]];
+		bool value = changes[i].value;
+		switch (changes[i].input) {
+		case SensorInput::ACTIVE:
+			if (zone.isActive == value) continue;
+			if (value && zone.isArmed && !zone.isBypassed && !zone.isAlarming && zoneTimers[slots[i]].entryDelayMs > 0) {
+				// Alarms only if the entry delay runs out before a disarm
+				zone.SetActive(true, false);
+				if (zoneTimers[slots[i]].entryTimer == 0) StartEntryDelay(slots[i]);
+			}
+			else {
+				zone.SetActive(value);
+			}
+			break;
+		case SensorInput::TAMPER:
+			if (zone.isTampered == value) continue;
+			zone.SetTampered(value);
+			break;
+		case SensorInput::FAULT:
+			if (zone.isFaulted == value) continue;
+			zone.SetFaulted(value);
+			break;
+		}
+		ZoneStateChanged(slots[i]);
+	}
+	if (unknown > 0) Logger::Warning<LogFormat::SENSOR_UNKNOWN_ZONES>(unknown, firstUnknown);
+}
+std::string AlarmService::ZoneBatch(ZoneOperation operation, const std::vector<int>& zoneIds, CommandStatus& status)
+{
+	std::vector<CommandResult> results = ZoneBatchResult(operation, zoneIds);
+	status = BatchStatus(results);
+	HIK_TRACE_SCOPE("json", "WriteBatch");
+	std::string out;
+	ResponseWriter::WriteBatch(out, ZoneOperationName(operation), results);
+	return out;
+}
 std::string AlarmService::ListAllZones()
 {
-	Logger::Info("Listing all zones: ");
+	HIK_TRACE_SCOPE("service", "ListAllZones");
+	Logger::Info<LogFormat::LIST_ALL_STARTED>();
 
-	json jArray = json::array();
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	auto shardLocks = LockAllShardsShared();
+	std::lock_guard<std::mutex> cacheLock(jsonCacheMutex);
 
-	for (const auto& zone : zones)
-	{
-		json jZone = CreateZoneJson(zone);
-		jArray.push_back(jZone);
+	// Writers are excluded by the stripes, so an unchanged generation means
+	// the cached payload is exactly what a fresh serialization would produce
+	uint64_t generation = zoneJsonGeneration.load(std::memory_order_acquire);
+	if (allZonesGeneration != generation) {
+		allZonesJson.clear();
+		allZonesJson.push_back('[');
+		for (uint32_t slot = 0; slot < zones.size(); slot++)
+		{
+			if (slot > 0) allZonesJson.push_back(',');
+			allZonesJson += ZoneJsonFragment(slot);
+		}
+		allZonesJson.push_back(']');
+		allZonesGeneration = generation;
 	}
 	if (zones.empty())
 	{
-		Logger::Info("No zones available to list.");
-		return jArray.dump();
+		Logger::Info<LogFormat::LIST_EMPTY>();
 	}
 	else {
-		Logger::Info("All zones listed");
-		return jArray.dump();
+		Logger::Info<LogFormat::LIST_ALL_DONE>();
 	}
+	return allZonesJson;
 }
-std::string AlarmService::ListOneZone(int zoneId)
+std::string AlarmService::ListOneZone(int zoneId, CommandStatus& status)
 {
-	Logger::Info("Listing chosen zone:");
+	HIK_TRACE_SCOPE("service", "ListOneZone");
+	Logger::Info<LogFormat::LIST_ONE_STARTED>();
 
-	auto zone = GetZoneById(zoneId);
-	json jZone;
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	auto zone = FindZone(zoneId);
 
 	if (!zone) {
-		Logger::Warning("ListOneZone: Zone " + std::to_string(zoneId) + " not found.");
+		Logger::Warning<LogFormat::LIST_ONE_NOT_FOUND>(zoneId);
+		status = CommandStatus::FAILURE;
 		return CreateResponse("ERROR", "Zone not found", zoneId);
 	}
 	else {
-		jZone = CreateZoneJson(zone);
-		jZone["status"] = "SUCCESS";
+		std::shared_lock<std::shared_mutex> shardLock(ShardFor(zone->partitionId));
+		std::string out;
+		JsonWriter writer(out);
+		ResponseWriter::WriteZone(writer, *zone, "SUCCESS");
+		status = CommandStatus::SUCCESS;
 
-		Logger::Info("Chosen zone listed");
-		return jZone.dump();
+		Logger::Info<LogFormat::LIST_ONE_DONE>();
+		return out;
 	}
 }
 std::string AlarmService::ListArmedZones()
 {
-	Logger::Info("Listing armed zones:");
-	json jArray = json::array();
+	Logger::Info<LogFormat::LIST_ARMED_STARTED>();
+	static const ZoneFilter armedFilter = MakeFilter("armed");
+	return ListZonesMatching(armedFilter, "armed");
+}
+std::string AlarmService::ListBypassedZones()
+{
+	Logger::Info<LogFormat::LIST_BYPASSED_STARTED>();
+	static const ZoneFilter bypassedFilter = MakeFilter("bypassed");
+	return ListZonesMatching(bypassedFilter, "bypassed");
+}
+std::string AlarmService::ListDisarmedZones()
+{
+	Logger::Info<LogFormat::LIST_DISARMED_STARTED>();
+	static const ZoneFilter disarmedFilter = MakeFilter("disarmed");
+	return ListZonesMatching(disarmedFilter, "disarmed");
+}
+std::string AlarmService::ListAlarmingZones()
+{
+	Logger::Info<LogFormat::LIST_ALARMING_STARTED>();
+	static const ZoneFilter alarmingFilter = MakeFilter("alarming");
+	return ListZonesMatching(alarmingFilter, "alarming");
+}
+// LIST_ZONES:<filter>, e.g. "armed&!bypassed&partition=2"
+std::string AlarmService::ListZones(const std::string& filterText, CommandStatus& status)
+{
+	Logger::Info<LogFormat::LIST_FILTER_STARTED>(filterText);
+	ZoneFilter filter;
+	std::string error;
+	if (!ZoneFilter::Parse(filterText, filter, error)) {
+		Logger::Warning<LogFormat::FILTER_INVALID>("ListZones", filterText, error);
+		status = CommandStatus::FAILURE;
+		return CreateResponse("ERROR", "Invalid filter: " + error);
+	}
+	status = CommandStatus::SUCCESS;
+	return ListZonesMatching(filter, "matching");
+}
+// COUNT_ZONES:<filter>; answered from the bit columns without touching zones
+std::string AlarmService::CountZones(const std::string& filterText, CommandStatus& status)
+{
+	ZoneFilter filter;
+	std::string error;
+	if (!ZoneFilter::Parse(filterText, filter, error)) {
+		Logger::Warning<LogFormat::FILTER_INVALID>("CountZones", filterText, error);
+		status = CommandStatus::FAILURE;
+		return CreateResponse("ERROR", "Invalid filter: " + error);
+	}
+	size_t count = CountZonesMatching(filter);
+	status = CommandStatus::SUCCESS;
 
-	for (const auto& zone : zones)
-	{
-		if (zone->isArmed)
-		{
-			json jZone = CreateZoneJson(zone);
-			jArray.push_back(jZone);
-		}
+	std::string out;
+	JsonWriter writer(out);
+	writer.BeginObject();
+	writer.Field("count", static_cast<int64_t>(count));
+	writer.Field("filter", filterText);
+	writer.Field("message", "Zone count");
+	writer.Field("status", "SUCCESS");
+	writer.EndObject();
+	return out;
+}
+bool AlarmService::CountZonesMatching(const std::string& filterText, size_t& count)
+{
+	ZoneFilter filter;
+	std::string error;
+	if (!ZoneFilter::Parse(filterText, filter, error)) {
+		Logger::Warning<LogFormat::FILTER_INVALID>("CountZonesMatching", filterText, error);
+		return false;
 	}
-	if (zones.empty())
-	{
-		Logger::Info("No zones available to list.");
-		return jArray.dump();
+	count = CountZonesMatching(filter);
+	return true;
+}
+size_t AlarmService::CountZonesMatching(ZoneFilter filter)
+{
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	ResolvePartitions(filter);
+	auto shardLocks = LockAllShardsShared();
+	return stateIndex.Count(filter);
+}
+std::string AlarmService::ListChangesSince(uint64_t sequence)
+{
+	HIK_TRACE_SCOPE("service", "ListChangesSince");
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	auto shardLocks = LockAllShardsShared();
+	// Every writer bumps the sequence under its stripe, so with all stripes
+	// held the current value covers exactly the changes listed below
+	uint64_t current = changeSequence.load(std::memory_order_relaxed);
+	// A sequence from the future (another instance, a clock step back)
+	// cannot be trusted; answer with everything
+	if (sequence > current) sequence = 0;
+
+	std::string payload;
+	JsonWriter writer(payload);
+	size_t partitionCount = 0;
+	size_t zoneCount = 0;
+	writer.BeginObject();
+	writer.Key("partitions");
+	writer.BeginArray();
+	for (uint32_t slot = 0; slot < partitions.size(); slot++) {
+		if (partitionChangeSequence[slot] <= sequence) continue;
+		writer.BeginObject();
+		writer.Field("armed", partitions[slot]->isArmed);
+		writer.Field("id", partitions[slot]->id);
+		writer.Field("name", partitions[slot]->name);
+		writer.EndObject();
+		partitionCount++;
 	}
-	else {
-		Logger::Info("All armed zones listed");
-		return jArray.dump();
+	writer.EndArray();
+	writer.Field("sequence", static_cast<int64_t>(current));
+	writer.Field("status", "SUCCESS");
+	writer.Key("zones");
+	writer.BeginArray();
+	{
+		std::lock_guard<std::mutex> cacheLock(jsonCacheMutex);
+		for (uint32_t slot = 0; slot < zones.size(); slot++) {
+			if (zoneChangeSequence[slot] <= sequence) continue;
+			writer.Raw(ZoneJsonFragment(slot));
+			zoneCount++;
+		}
 	}
+	writer.EndArray();
+	writer.EndObject();
+	Logger::Info<LogFormat::LIST_CHANGES_DONE>(zoneCount, partitionCount, sequence);
+	return payload;
 }
-std::string AlarmService::ListBypassedZones()
+std::string AlarmService::ListZonesMatching(ZoneFilter filter, const std::string& description)
 {
-	Logger::Info("Listing bypassed zones:");
+	HIK_TRACE_SCOPE("service", "ListZones");
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	ResolvePartitions(filter);
+	auto shardLocks = LockAllShardsShared();
 
-	json jArray = json::array();
+	std::vector<uint32_t> slots;
+	stateIndex.Select(filter, slots);
 
-	for (const auto& zone : zones)
+	std::string payload = "[";
 	{
-		if (zone->isBypassed)
+		std::lock_guard<std::mutex> cacheLock(jsonCacheMutex);
+		for (size_t i = 0; i < slots.size(); i++)
 		{
-			json jZone = CreateZoneJson(zone);
-			jArray.push_back(jZone);
+			if (i > 0) payload.push_back(',');
+			payload += ZoneJsonFragment(slots[i]);
 		}
 	}
+	payload.push_back(']');
 	if (zones.empty())
 	{
-		Logger::Info("No zones available to list.");
-		return jArray.dump();
+		Logger::Info<LogFormat::LIST_EMPTY>();
 	}
 	else {
-		Logger::Info("All bypassed zones listed");
-		return jArray.dump();
+		Logger::Info<LogFormat::LIST_FILTER_DONE>(description);
 	}
+	return payload;
 }
-std::string AlarmService::ListDisarmedZones()
+ZoneFilter AlarmService::MakeFilter(const std::string& filterText)
 {
-	Logger::Info("Listing disarmed zones:");
+	ZoneFilter filter;
+	std::string error;
+	ZoneFilter::Parse(filterText, filter, error);
+	return filter;
+}
+// Map the partition ids in a filter to partition slots; caller holds structureMutex
+void AlarmService::ResolvePartitions(ZoneFilter& filter) const
+{
+	for (auto& clause : filter.clauses) {
+		for (auto& literal : clause) {
+			if (literal.isPartition) literal.partitionSlot = partitionIndex.Find(literal.partitionId);
+		}
+	}
+}
+// Keep the bit columns in step with a zone's fields, journal the change and
+// publish it to subscribers; caller holds the zone's stripe
+void AlarmService::ZoneStateChanged(uint32_t zoneSlot)
+{
+	if (zoneSlot == IdIndex::kNotFound) return;
+	const Zone& zone = *zones[zoneSlot];
+	uint16_t flags = ZoneFlags(zone);
+	stateIndex.SyncZone(zoneSlot, zone);
+	zoneJsonDirty[zoneSlot] = 1;
+	zoneJsonGeneration.fetch_add(1, std::memory_order_release);
+	journal.Append({ JournalRecordKind::ZONE_STATE, zone.id, flags });
 
-	json jArray = json::array();
+	uint64_t sequence = changeSequence.fetch_add(1, std::memory_order_relaxed) + 1;
+	zoneChangeSequence[zoneSlot] = sequence;
 
-	for (const auto& zone : zones)
-	{
-		if (!zone->isArmed)
-		{
-			json jZone = CreateZoneJson(zone);
-			jArray.push_back(jZone);
-		}
+	UpdateZoneTimers(zoneSlot, publishedFlags[zoneSlot], flags);
+	uint16_t changed = flags ^ publishedFlags[zoneSlot];
+	publishedFlags[zoneSlot] = flags;
+	if (changed != 0) events.Publish({ StateEventKind::ZONE, zone.id, zone.partitionId, flags, changed, sequence });
+}
+// Caller holds the partition's stripe
+void AlarmService::PartitionStateChanged(const Partition& partition)
+{
+	uint16_t flags = partition.isArmed ? ZONE_ARMED : 0;
+	journal.Append({ JournalRecordKind::PARTITION_STATE, partition.id, flags });
+	uint64_t sequence = changeSequence.fetch_add(1, std::memory_order_relaxed) + 1;
+	uint32_t partitionSlot = partitionIndex.Find(partition.id);
+	if (partitionSlot != IdIndex::kNotFound) partitionChangeSequence[partitionSlot] = sequence;
+	events.Publish({ StateEventKind::PARTITION, partition.id, partition.id, flags, ZONE_ARMED, sequence });
+}
+uint64_t AlarmService::StartTimer(TimerKind kind, int id, uint32_t milliseconds)
+{
+	uint64_t payload = static_cast<uint64_t>(kind) << 32 | static_cast<uint32_t>(id);
+	return timers.Schedule(std::chrono::milliseconds(milliseconds), payload);
+}
+void AlarmService::StopTimer(uint64_t& timerId)
+{
+	if (timerId == 0) return;
+	timers.Cancel(timerId);
+	timerId = 0;
+}
+// Caller holds the zone's stripe
+void AlarmService::StartEntryDelay(uint32_t zoneSlot)
+{
+	ZoneTimers& timing = zoneTimers[zoneSlot];
+	timing.entryTimer = StartTimer(TimerKind::ENTRY_DELAY, zones[zoneSlot]->id, timing.entryDelayMs);
+	Logger::Info<LogFormat::ENTRY_DELAY_STARTED>(zones[zoneSlot]->id, timing.entryDelayMs);
+}
+// Start and stop the zone's timers on flag edges; caller holds its stripe
+void AlarmService::UpdateZoneTimers(uint32_t zoneSlot, uint16_t previousFlags, uint16_t flags)
+{
+	ZoneTimers& timing = zoneTimers[zoneSlot];
+	// Disarming, bypassing or an alarm from elsewhere ends an entry delay
+	if (timing.entryTimer != 0 && ((flags & ZONE_ARMED) == 0 || (flags & (ZONE_BYPASSED | ZONE_ALARMING)) != 0)) {
+		StopTimer(timing.entryTimer);
 	}
-	if (zones.empty())
-	{
-		Logger::Info("No zones available to list.");
-		return jArray.dump();
+	uint16_t rising = flags & ~previousFlags;
+	uint16_t falling = previousFlags & ~flags;
+	if (rising & ZONE_ALARMING) {
+		uint32_t partitionSlot = partitionIndex.Find(zones[zoneSlot]->partitionId);
+		uint32_t sirenMs = partitionSlot == IdIndex::kNotFound ? 0 : partitionTimers[partitionSlot].sirenTimeoutMs;
+		if (sirenMs > 0) {
+			StopTimer(timing.sirenTimer);
+			timing.sirenTimer = StartTimer(TimerKind::SIREN_TIMEOUT, zones[zoneSlot]->id, sirenMs);
+		}
 	}
-	else {
-		Logger::Info("All disarmed zones listed");
-		return jArray.dump();
+	if (falling & ZONE_ALARMING) StopTimer(timing.sirenTimer);
+	if ((rising & ZONE_ACTIVE) && timing.restoreMs > 0) {
+		StopTimer(timing.restoreTimer);
+		timing.restoreTimer = StartTimer(TimerKind::ACTIVE_RESTORE, zones[zoneSlot]->id, timing.restoreMs);
 	}
+	if (falling & ZONE_ACTIVE) StopTimer(timing.restoreTimer);
 }
-std::string AlarmService::ListAlarmingZones()
+// Runs on the timer thread. A timer only acts if it is still the one
+// recorded for its zone or partition; a cancel or a newer timer wins.
+void AlarmService::TimersExpired(const std::vector<ExpiredTimer>& expired)
 {
-	Logger::Info("Listing alarming zones:");
+	HIK_TRACE_SCOPE("service", "TimersExpired");
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	for (const auto& timer : expired) {
+		TimerKind kind = static_cast<TimerKind>(timer.payload >> 32);
+		int id = static_cast<int>(static_cast<uint32_t>(timer.payload));
 
-	json jArray = json::array();
+		if (kind == TimerKind::EXIT_DELAY) {
+			uint32_t partitionSlot = partitionIndex.Find(id);
+			if (partitionSlot == IdIndex::kNotFound) continue;
+			std::unique_lock<std::shared_mutex> shardLock(ShardFor(id));
+			PartitionTimers& timing = partitionTimers[partitionSlot];
+			if (timing.exitTimer != timer.timerId) continue;
+			timing.exitTimer = 0;
+			if (partitions[partitionSlot]->isArmed) continue;
 
-	for (const auto& zone : zones)
-	{
-		if (zone->isAlarming)
-		{
-			json jZone = CreateZoneJson(zone);
-			jArray.push_back(jZone);
+			CommandResult result;
+			std::vector<uint32_t> zonesToArm;
+			if (!CheckPartitionReady(partitionSlot, result, zonesToArm)) {
+				Logger::Warning<LogFormat::EXIT_DELAY_NOT_READY>(id);
+				continue;
+			}
+			Logger::Info<LogFormat::EXIT_DELAY_ARMED>(id, ArmPartitionZones(partitionSlot, zonesToArm));
+			continue;
+		}
+
+		uint32_t zoneSlot = zoneIndex.Find(id);
+		if (zoneSlot == IdIndex::kNotFound) continue;
+		Zone& zone = *zones[zoneSlot];
+		std::unique_lock<std::shared_mutex> shardLock(ShardFor(zone.partitionId));
+		ZoneTimers& timing = zoneTimers[zoneSlot];
+		switch (kind) {
+		case TimerKind::ENTRY_DELAY:
+			if (timing.entryTimer != timer.timerId) break;
+			timing.entryTimer = 0;
+			if (zone.isArmed && !zone.isBypassed && !zone.isAlarming) {
+				zone.isAlarming = true;
+				Logger::Warning<LogFormat::ENTRY_DELAY_EXPIRED>(id);
+				ZoneStateChanged(zoneSlot);
+			}
+			break;
+		case TimerKind::SIREN_TIMEOUT:
+			if (timing.sirenTimer != timer.timerId) break;
+			timing.sirenTimer = 0;
+			if (zone.isAlarming) {
+				zone.isAlarming = false;
+				Logger::Info<LogFormat::SIREN_TIMEOUT>(id);
+				ZoneStateChanged(zoneSlot);
+			}
+			break;
+		case TimerKind::ACTIVE_RESTORE:
+			if (timing.restoreTimer != timer.timerId) break;
+			timing.restoreTimer = 0;
+			if (zone.isActive) {
+				zone.SetActive(false);
+				ZoneStateChanged(zoneSlot);
+			}
+			break;
+		default:
+			break;
 		}
 	}
-	if (zones.empty())
-	{
-		Logger::Info("No zones available to list.");
-		return jArray.dump();
+}
+bool AlarmService::ParseDelayKind(std::string_view name, DelayKind& kind)
+{
+	if (CommandParser::EqualsIgnoreCase(name, "EXIT")) kind = DelayKind::EXIT;
+	else if (CommandParser::EqualsIgnoreCase(name, "ENTRY")) kind = DelayKind::ENTRY;
+	else if (CommandParser::EqualsIgnoreCase(name, "SIREN")) kind = DelayKind::SIREN;
+	else if (CommandParser::EqualsIgnoreCase(name, "RESTORE")) kind = DelayKind::RESTORE;
+	else return false;
+	return true;
+}
+const char* AlarmService::DelayKindName(DelayKind kind)
+{
+	switch (kind) {
+	case DelayKind::EXIT: return "Exit delay";
+	case DelayKind::ENTRY: return "Entry delay";
+	case DelayKind::SIREN: return "Siren timeout";
+	default: return "Active restore";
+	}
+}
+std::string AlarmService::SetDelay(DelayKind kind, const std::vector<int>& ids, uint32_t milliseconds, CommandStatus& status)
+{
+	bool perPartition = kind == DelayKind::EXIT || kind == DelayKind::SIREN;
+	size_t applied = 0;
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	if (perPartition) {
+		for (int id : ids) {
+			uint32_t partitionSlot = partitionIndex.Find(id);
+			if (partitionSlot == IdIndex::kNotFound) continue;
+			std::unique_lock<std::shared_mutex> shardLock(ShardFor(id));
+			PartitionTimers& timing = partitionTimers[partitionSlot];
+			(kind == DelayKind::EXIT ? timing.exitDelayMs : timing.sirenTimeoutMs) = milliseconds;
+			applied++;
+		}
 	}
 	else {
-		Logger::Info("All alarming zones listed");
-		return jArray.dump();
+		std::vector<uint32_t> slots(ids.size());
+		for (size_t i = 0; i < ids.size(); i++) {
+			slots[i] = zoneIndex.Find(ids[i]);
+		}
+		ShardLocks locks;
+		LockShardsOf(slots, true, locks);
+		for (uint32_t zoneSlot : slots) {
+			if (zoneSlot == IdIndex::kNotFound) continue;
+			ZoneTimers& timing = zoneTimers[zoneSlot];
+			(kind == DelayKind::ENTRY ? timing.entryDelayMs : timing.restoreMs) = milliseconds;
+			applied++;
+		}
 	}
+	Logger::Info<LogFormat::DELAY_SET>(DelayKindName(kind), milliseconds, applied, ids.size());
+	std::string target = perPartition ? " partitions" : " zones";
+	if (applied == 0) {
+		status = CommandStatus::FAILURE;
+		return ResponseWriter::Response("ERROR", "No matching" + target);
+	}
+	std::string message = std::string(DelayKindName(kind)) + " set to " + std::to_string(milliseconds) + " ms for "
+		+ std::to_string(applied) + target;
+	if (applied < ids.size()) message += " (" + std::to_string(ids.size() - applied) + " not found)";
+	status = CommandStatus::SUCCESS;
+	return ResponseWriter::Response("SUCCESS", message);
 }
-std::shared_ptr<Zone> AlarmService::GetZoneById(int zoneId)
+std::string AlarmService::TimerStatus()
 {
-	for (const auto& zone : zones)
-	{
-		if (zone->id == zoneId)
-		{
-			return zone;
-		}
+	std::string out;
+	ResponseWriter::WriteTimerStats(out, TimerStatistics());
+	return out;
+}
+// Mark every fragment stale; caller holds structureMutex exclusively
+void AlarmService::ResetJsonCache()
+{
+	std::lock_guard<std::mutex> cacheLock(jsonCacheMutex);
+	zoneJsonFragments.assign(zones.size(), std::string());
+	zoneJsonDirty.assign(zones.size(), 1);
+	zoneJsonGeneration.fetch_add(1, std::memory_order_release);
+}
+// Cached serialization of one zone; caller holds jsonCacheMutex and every stripe
+const std::string& AlarmService::ZoneJsonFragment(uint32_t zoneSlot)
+{
+	if (zoneJsonDirty[zoneSlot]) {
+		std::string& fragment = zoneJsonFragments[zoneSlot];
+		fragment.clear();
+		JsonWriter writer(fragment);
+		ResponseWriter::WriteZone(writer, *zones[zoneSlot]);
+		zoneJsonDirty[zoneSlot] = 0;
 	}
-	return nullptr;
+	return zoneJsonFragments[zoneSlot];
+}
+std::shared_ptr<Zone> AlarmService::GetZoneById(int zoneId)
+{
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	return FindZone(zoneId);
 }
 std::shared_ptr<Partition> AlarmService::GetPartitionById(int partitionId)
 {
-	for (const auto& part : partitions)
-	{
-		if (part->id == partitionId)
-		{
-			return part;
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	return FindPartition(partitionId);
+}
+std::shared_ptr<Zone> AlarmService::FindZone(int zoneId) const
+{
+	uint32_t slot = zoneIndex.Find(zoneId);
+	return slot == IdIndex::kNotFound ? nullptr : zones[slot];
+}
+std::shared_ptr<Partition> AlarmService::FindPartition(int partitionId) const
+{
+	uint32_t slot = partitionIndex.Find(partitionId);
+	return slot == IdIndex::kNotFound ? nullptr : partitions[slot];
+}
+// Rebuild the id lookups and the partition -> zones membership lists.
+// Caller holds structureMutex exclusively.
+void AlarmService::RebuildIndexes()
+{
+	partitionIndex.Clear();
+	partitionIndex.Reserve(partitions.size());
+	for (uint32_t slot = 0; slot < partitions.size(); slot++) {
+		if (!partitionIndex.Insert(partitions[slot]->id, slot)) {
+			Logger::Warning<LogFormat::DUPLICATE_PARTITION>(partitions[slot]->id);
+		}
+	}
+	zoneIndex.Clear();
+	zoneIndex.Reserve(zones.size());
+	partitionMembers.assign(partitions.size(), {});
+	stateIndex.Reset(zones.size(), partitions.size());
+	ResetJsonCache();
+	publishedFlags.resize(zones.size());
+	// Delay settings are runtime state; timers still pending no longer match
+	// and are ignored when they fire
+	zoneTimers.assign(zones.size(), ZoneTimers());
+	partitionTimers.assign(partitions.size(), PartitionTimers());
+	// Everything counts as changed after a (re)load
+	uint64_t sequence = changeSequence.fetch_add(1, std::memory_order_relaxed) + 1;
+	zoneChangeSequence.assign(zones.size(), sequence);
+	partitionChangeSequence.assign(partitions.size(), sequence);
+	for (uint32_t slot = 0; slot < zones.size(); slot++) {
+		stateIndex.SyncZone(slot, *zones[slot]);
+		publishedFlags[slot] = ZoneFlags(*zones[slot]);
+		if (!zoneIndex.Insert(zones[slot]->id, slot)) {
+			Logger::Warning<LogFormat::DUPLICATE_ZONE>(zones[slot]->id);
+			continue;
+		}
+		uint32_t partitionSlot = partitionIndex.Find(zones[slot]->partitionId);
+		if (partitionSlot != IdIndex::kNotFound) {
+			partitionMembers[partitionSlot].push_back(slot);
+			stateIndex.SetPartitionMember(partitionSlot, slot, true);
 		}
 	}
-	return nullptr;
+}
+// Reassign a zone and keep the membership index in sync.
+// Caller holds structureMutex exclusively.
+void AlarmService::MoveZoneToPartition(const std::shared_ptr<Zone>& zone, int newPartitionId)
+{
+	if (zone->partitionId == newPartitionId) return;
+
+	uint32_t zoneSlot = zoneIndex.Find(zone->id);
+	uint32_t oldPartitionSlot = partitionIndex.Find(zone->partitionId);
+	if (oldPartitionSlot != IdIndex::kNotFound) {
+		auto& members = partitionMembers[oldPartitionSlot];
+		members.erase(std::remove(members.begin(), members.end(), zoneSlot), members.end());
+		stateIndex.SetPartitionMember(oldPartitionSlot, zoneSlot, false);
+	}
+	zone->SetPartitionId(newPartitionId);
+
+	uint32_t newPartitionSlot = partitionIndex.Find(newPartitionId);
+	if (newPartitionSlot != IdIndex::kNotFound) {
+		auto& members = partitionMembers[newPartitionSlot];
+		members.insert(std::lower_bound(members.begin(), members.end(), zoneSlot), zoneSlot);
+		stateIndex.SetPartitionMember(newPartitionSlot, zoneSlot, true);
+	}
 }
 void AlarmService::SaveStateToTxt() {
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	auto shardLocks = LockAllShardsShared();
 	std::ofstream file("zone_state.txt");
 	if (!file.is_open()) {
-		Logger::Error("Could not save state to zone_state.txt");
+		Logger::Error<LogFormat::STATE_TXT_SAVE_FAILED>();
 		return;
 	}
 	for (const auto& zone : zones) {
@@ -338,12 +853,13 @@ void AlarmService::SaveStateToTxt() {
 			<< (zone->isBypassed ? "1" : "0") << "\n";
 	}
 	file.close();
-	Logger::Info("Zone states saved successfully to zone_state.txt");
+	Logger::Info<LogFormat::STATE_TXT_SAVED>();
 }
 void AlarmService::LoadStateFromTxt() {
+	std::unique_lock<std::shared_mutex> structureLock(structureMutex);
 	std::ifstream file("zone_state.txt");
 	if (!file.is_open()) {
-		Logger::Warning("No saved state found (zone_state.txt)");
+		Logger::Warning<LogFormat::STATE_TXT_MISSING>();
 		return;
 	}
 	std::string line;
@@ -363,7 +879,7 @@ void AlarmService::LoadStateFromTxt() {
 				int zoneId = std::stoi(parts[0]);
 				bool isArmed = (parts[1] == "1");
 				bool isBypassed = (parts[2] == "1");
-				auto zone = GetZoneById(zoneId);
+				auto zone = FindZone(zoneId);
 				if (zone) {
 					zone->isArmed = isArmed;
 					zone->isBypassed = isBypassed;
@@ -371,46 +887,203 @@ void AlarmService::LoadStateFromTxt() {
 			}
 			catch (const std::exception&)
 			{
-				Logger::Error("Corrupt data in state file.");
+				Logger::Error<LogFormat::STATE_TXT_CORRUPT>();
 			}
 		}
 	}
 	file.close();
-	Logger::Info("Previous zone states loaded from zone_state.txt");
+	RebuildIndexes();
+	Logger::Info<LogFormat::STATE_TXT_LOADED>();
+}
+// Caller holds structureMutex shared. Names, types and partition membership
+// only change under structureMutex held exclusively, so only the state bits
+// have to be copied while every stripe is held. Rotating the journal at that
+// same instant makes the copy cover exactly the records before the rotation.
+void AlarmService::CopyState(StateCopy& copy, bool rotateJournal)
+{
+	copy.zoneStates.resize(zones.size());
+	copy.partitionStates.resize(partitions.size());
+	auto shardLocks = LockAllShardsShared();
+	for (size_t slot = 0; slot < zones.size(); slot++) {
+		copy.zoneStates[slot] = ZoneFlags(*zones[slot]);
+	}
+	for (size_t slot = 0; slot < partitions.size(); slot++) {
+		copy.partitionStates[slot] = partitions[slot]->isArmed ? 1 : 0;
+	}
+	if (rotateJournal) copy.rotation = journal.Rotate();
 }
 void AlarmService::SaveStateToJson() {
-	json jSystem;
+	HIK_TRACE_SCOPE("persistence", "stateJsonSave");
+	auto start = std::chrono::steady_clock::now();
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	StateCopy copy;
+	CopyState(copy, false);
 
-	json jPartitions = json::array();
-	for (const auto& partition : partitions) {
-		json jPart;
-		jPart["id"] = partition->id;
-		jPart["name"] = partition->name;
-		jPart["armed"] = partition->isArmed;
-		jPartitions.push_back(jPart);
+	std::string data;
+	data.reserve(64 + zones.size() * 192);
+	JsonWriter writer(data);
+	writer.BeginObject();
+	writer.Key("partitions");
+	writer.BeginArray();
+	for (size_t slot = 0; slot < partitions.size(); slot++) {
+		writer.BeginObject();
+		writer.Field("armed", copy.partitionStates[slot] != 0);
+		writer.Field("id", partitions[slot]->id);
+		writer.Field("name", partitions[slot]->name);
+		writer.EndObject();
+	}
+	writer.EndArray();
+	writer.Key("zones");
+	writer.BeginArray();
+	for (size_t slot = 0; slot < zones.size(); slot++) {
+		ResponseWriter::WriteZoneState(writer, *zones[slot], copy.zoneStates[slot]);
 	}
-	jSystem["partitions"] = jPartitions;
+	writer.EndArray();
+	writer.EndObject();
 
-	json jZones = json::array();
-	for (const auto& zone : zones) {
-		jZones.push_back(CreateZoneJson(zone));
+	if (FileApi::WriteAtomically(kStateFile, data)) {
+		Metrics::RecordPersistence(PersistenceMetric::STATE_JSON_SAVE,
+			std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+		Logger::Info<LogFormat::STATE_JSON_SAVED>(kStateFile);
+	}
+	else {
+		Logger::Error<LogFormat::STATE_JSON_SAVE_FAILED>();
 	}
-	jSystem["zones"] = jZones;
+}
+// Point-in-time snapshot without stalling commands: stripes are held only
+// while the state bits are copied, serialization runs after they are released
+SnapshotStats AlarmService::SaveSnapshot() {
+	std::lock_guard<std::mutex> snapshotLock(snapshotMutex);
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	SnapshotStats stats;
+	stats.zoneCount = zones.size();
+
+	auto copyStart = std::chrono::steady_clock::now();
+	StateCopy copy;
+	{
+		HIK_TRACE_SCOPE("persistence", "snapshotCopy");
+		CopyState(copy, true);
+	}
+	auto writeStart = std::chrono::steady_clock::now();
+	HIK_TRACE_SCOPE("persistence", "snapshotWrite");
+	stats.copyMicros = std::chrono::duration_cast<std::chrono::microseconds>(writeStart - copyStart).count();
+	Metrics::RecordPersistence(PersistenceMetric::SNAPSHOT_COPY,
+		std::chrono::duration_cast<std::chrono::nanoseconds>(writeStart - copyStart).count());
+
+	std::string data;
+	data.reserve(sizeof(StateSnapshot::Header) + partitions.size() * 48 + zones.size() * 48);
+	StateSnapshot::Write(data, StateSnapshot::FingerprintOf(kZonesFile),
+		partitions, copy.partitionStates, zones, copy.zoneStates);
+	stats.bytes = data.size();
 
-	std::ofstream file("system_state.json");
-	if (file.is_open()) {
-		file << jSystem.dump(4);
-		file.close();
-		Logger::Info("System state (Partitions and Zones) saved successfully to JSON.");
+	// Written to a temporary file and renamed, so a crash never leaves a
+	// half-written snapshot behind
+	stats.saved = FileApi::WriteAtomically(kSnapshotFile, data);
+	if (stats.saved) {
+		if (copy.rotation != 0) journal.DiscardRotated(copy.rotation);
+	}
+	auto writeEnd = std::chrono::steady_clock::now();
+	stats.writeMillis = std::chrono::duration_cast<std::chrono::milliseconds>(writeEnd - writeStart).count();
+	Metrics::RecordPersistence(PersistenceMetric::SNAPSHOT_WRITE,
+		std::chrono::duration_cast<std::chrono::nanoseconds>(writeEnd - writeStart).count());
+
+	if (stats.saved) {
+		Logger::Info<LogFormat::SNAPSHOT_SAVED>(stats.zoneCount, stats.bytes, stats.copyMicros, stats.writeMillis);
 	}
 	else {
-		Logger::Error("Could not save state to system_state.json");
+		Logger::Error<LogFormat::SNAPSHOT_SAVE_FAILED>(kSnapshotFile);
+	}
+	lastSnapshot = stats;
+	return stats;
+}
+// Rebuild partitions and zones straight from the mapped snapshot. Returns
+// false, leaving the service untouched, when the snapshot is missing or
+// damaged or a JSON import is pending; RecoverState then falls back to
+// zones.csv and system_state.json.
+bool AlarmService::LoadSnapshot()
+{
+	auto start = std::chrono::steady_clock::now();
+	MappedFile file;
+	if (!file.Open(kSnapshotFile)) return false;
+
+	StateSnapshot snapshot;
+	std::string error;
+	if (!snapshot.Validate(file.Data(), file.Size(), error)) {
+		Logger::Warning<LogFormat::SNAPSHOT_INVALID>(kSnapshotFile, error);
+		return false;
+	}
+	// A system_state.json newer than the snapshot was put there to be imported
+	std::error_code jsonError;
+	std::error_code snapshotError;
+	auto jsonTime = std::filesystem::last_write_time(kStateFile, jsonError);
+	auto snapshotTime = std::filesystem::last_write_time(kSnapshotFile, snapshotError);
+	if (!jsonError && !snapshotError && jsonTime > snapshotTime) {
+		Logger::Info<LogFormat::SNAPSHOT_JSON_NEWER>(kStateFile);
+		return false;
+	}
+	// zones.csv was edited: it defines the zones, the snapshot still holds
+	// the latest state of the ones that remain
+	if (!(snapshot.Config() == StateSnapshot::FingerprintOf(kZonesFile))) {
+		Logger::Info<LogFormat::SNAPSHOT_CONFIG_CHANGED>(kZonesFile);
+		InitializeZones();
+		std::unique_lock<std::shared_mutex> structureLock(structureMutex);
+		for (size_t i = 0; i < snapshot.PartitionCount(); i++) {
+			StateSnapshot::PartitionEntry entry = snapshot.GetPartition(i);
+			auto partition = FindPartition(entry.id);
+			if (partition) partition->isArmed = entry.armed != 0;
+		}
+		for (size_t i = 0; i < snapshot.ZoneCount(); i++) {
+			StateSnapshot::ZoneEntry entry = snapshot.GetZone(i);
+			auto zone = FindZone(entry.id);
+			if (zone) ApplyZoneFlags(*zone, entry.stateBits);
+		}
+		RebuildIndexes();
+		return true;
 	}
+
+	std::unique_lock<std::shared_mutex> structureLock(structureMutex);
+	partitions.clear();
+	partitions.reserve(snapshot.PartitionCount());
+	for (size_t i = 0; i < snapshot.PartitionCount(); i++) {
+		StateSnapshot::PartitionEntry entry = snapshot.GetPartition(i);
+		auto partition = std::make_shared<Partition>(entry.id, std::string(snapshot.Name(entry.nameOffset, entry.nameLength)));
+		partition->isArmed = entry.armed != 0;
+		partitions.push_back(std::move(partition));
+	}
+	zones.clear();
+	zones.reserve(snapshot.ZoneCount());
+	for (size_t i = 0; i < snapshot.ZoneCount(); i++) {
+		StateSnapshot::ZoneEntry entry = snapshot.GetZone(i);
+		auto zone = ZoneFactory::Create(static_cast<ZoneKind>(entry.kind), entry.id,
+			std::string(snapshot.Name(entry.nameOffset, entry.nameLength)), entry.partitionId);
+		ApplyZoneFlags(*zone, entry.stateBits);
+		zones.push_back(std::move(zone));
+	}
+	RebuildIndexes();
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+	Logger::Info<LogFormat::SNAPSHOT_LOADED>(zones.size(), kSnapshotFile, elapsed);
+	return true;
+}
+void AlarmService::ApplyZoneFlags(Zone& zone, uint16_t flags)
+{
+	zone.isArmed = (flags & ZONE_ARMED) != 0;
+	zone.isBypassed = (flags & ZONE_BYPASSED) != 0;
+	zone.isAlarming = (flags & ZONE_ALARMING) != 0;
+	zone.isActive = (flags & ZONE_ACTIVE) != 0;
+	zone.isTampered = (flags & ZONE_TAMPERED) != 0;
+	zone.isFaulted = (flags & ZONE_FAULTED) != 0;
+}
+SnapshotStats AlarmService::TakeSnapshot() {
+	if (!snapshotTask.RunAndWait()) return SaveSnapshot();
+	std::lock_guard<std::mutex> snapshotLock(snapshotMutex);
+	return lastSnapshot;
 }
 void AlarmService::LoadStateFromJson() {
-	std::ifstream file("system_state.json");
+	std::unique_lock<std::shared_mutex> structureLock(structureMutex);
+	std::ifstream file(kStateFile);
 	if (!file.is_open()) {
-		Logger::Warning("No saved JSON state found (system_state.json). Using default states.");
+		Logger::Warning<LogFormat::STATE_JSON_MISSING>();
 		return;
 	}
 
@@ -422,7 +1095,7 @@ void AlarmService::LoadStateFromJson() {
 			for (const auto& jPart : jSystem["partitions"]) {
 				if (jPart.contains("id")) {
 					int pId = jPart["id"];
-					auto partition = GetPartitionById(pId);
+					auto partition = FindPartition(pId);
 
 					if (partition) {
 						if (jPart.contains("armed")) partition->isArmed = jPart["armed"];
@@ -433,21 +1106,22 @@ void AlarmService::LoadStateFromJson() {
 						auto newPart = std::make_shared<Partition>(pId, pName);
 						if (jPart.contains("armed")) newPart->isArmed = jPart["armed"];
 						partitions.push_back(newPart);
+						RebuildIndexes();
 					}
 				}
 			}
-			Logger::Info("Partition data loaded from JSON backup.");
+			Logger::Info<LogFormat::STATE_JSON_PARTITIONS_LOADED>();
 		}
 
 		if (jSystem.contains("zones") && jSystem["zones"].is_array()) {
 			for (const auto& jZone : jSystem["zones"]) {
 				if (jZone.contains("id")) {
 					int zoneId = jZone["id"];
-					auto zone = GetZoneById(zoneId);
+					auto zone = FindZone(zoneId);
 
 					if (zone) {
 						if (jZone.contains("name")) zone->name = jZone["name"];
-						if (jZone.contains("partitionId")) zone->partitionId = jZone["partitionId"];
+						if (jZone.contains("partitionId")) MoveZoneToPartition(zone, jZone["partitionId"]);
 
 						if (jZone.contains("armed")) zone->isArmed = jZone["armed"];
 						if (jZone.contains("bypassed")) zone->isBypassed = jZone["bypassed"];
@@ -461,143 +1135,403 @@ void AlarmService::LoadStateFromJson() {
 					}
 					else {
 						//Future function for full backup
-						Logger::Warning("Zone " + std::to_string(zoneId) + " found in backup but not in CSV. Skipping.");
+						Logger::Warning<LogFormat::STATE_JSON_UNKNOWN_ZONE>(zoneId);
 					}
 				}
 			}
-			Logger::Info("Zone data loaded from JSON backup.");
+			RebuildIndexes();
+			Logger::Info<LogFormat::STATE_JSON_ZONES_LOADED>();
 		}
 	}
 	catch (const json::parse_error& e) {
-		Logger::Error("JSON parse error while loading state: " + std::string(e.what()));
+		Logger::Error<LogFormat::STATE_JSON_PARSE_ERROR>(e.what());
 	}
 	catch (const std::exception& e) {
-		Logger::Error("Exception while loading JSON state: " + std::string(e.what()));
+		Logger::Error<LogFormat::STATE_JSON_LOAD_ERROR>(e.what());
 	}
 	file.close();
-}std::string AlarmService::CreateResponse(const std::string& status, const std::string& message, int id, const std::string& state) {
-	json responseJson;
-	responseJson["status"] = status;
-	responseJson["message"] = message;
-	if (id != -1) responseJson["id"] = id;
-	if (!state.empty()) responseJson["newState"] = state;
-	return responseJson.dump();
+}
+void AlarmService::RecoverState()
+{
+	if (!LoadSnapshot()) {
+		InitializeZones();
+		LoadStateFromJson();
+	}
+
+	std::unique_lock<std::shared_mutex> structureLock(structureMutex);
+	journal.SetCompactionHandler(kJournalCompactionRecords, [this]() { snapshotTask.Request(); });
+	size_t replayed = journal.Open(kJournalFile,
+		[this](const JournalRecord& record) { ApplyJournalRecord(record); });
+	if (replayed > 0) {
+		RebuildIndexes();
+		Logger::Info<LogFormat::JOURNAL_REPLAYED>(replayed, kJournalFile);
+	}
+	structureLock.unlock();
 
+	snapshotTask.Start(kSnapshotInterval, [this]() { SaveSnapshot(); });
+	sensors.Start([this](const std::vector<SensorEvent>& changes) { ApplySensorChanges(changes); });
+	timers.Start([this](const std::vector<ExpiredTimer>& expired) { TimersExpired(expired); });
+}
+void AlarmService::LoadSyntheticSite(size_t zoneCount, size_t partitionCount, const std::string& journalPath)
+{
+	constexpr ZoneKind kKinds[] = { ZoneKind::DOOR_CONTACT, ZoneKind::MOTION_SENSOR, ZoneKind::GENERIC };
+	std::unique_lock<std::shared_mutex> structureLock(structureMutex);
+	partitions.clear();
+	partitions.reserve(partitionCount);
+	for (size_t i = 1; i <= partitionCount; i++) {
+		partitions.push_back(std::make_shared<Partition>(static_cast<int>(i), "Partition " + std::to_string(i)));
+	}
+	zones.clear();
+	zones.reserve(zoneCount);
+	for (size_t i = 1; i <= zoneCount; i++) {
+		int partitionId = static_cast<int>((i - 1) % partitionCount) + 1;
+		zones.push_back(ZoneFactory::Create(kKinds[i % 3], static_cast<int>(i), "Zone " + std::to_string(i), partitionId));
+	}
+	RebuildIndexes();
+	if (!journalPath.empty()) {
+		std::error_code error;
+		std::filesystem::remove(journalPath, error);
+		journal.Open(journalPath, [](const JournalRecord&) {});
+	}
+	structureLock.unlock();
+	Logger::Info<LogFormat::SYNTHETIC_SITE_CREATED>(zoneCount, partitionCount);
+
+	sensors.Start([this](const std::vector<SensorEvent>& changes) { ApplySensorChanges(changes); });
+	timers.Start([this](const std::vector<ExpiredTimer>& expired) { TimersExpired(expired); });
+}
+// Caller holds structureMutex exclusively and rebuilds the indexes afterwards
+void AlarmService::ApplyJournalRecord(const JournalRecord& record)
+{
+	if (record.kind == JournalRecordKind::PARTITION_STATE) {
+		auto partition = FindPartition(record.id);
+		if (partition) partition->isArmed = record.value != 0;
+		return;
+	}
+	auto zone = FindZone(record.id);
+	if (zone) ApplyZoneFlags(*zone, record.value);
+}
+void AlarmService::Shutdown()
+{
+	timers.Stop();
+	sensors.Stop();
+	snapshotTask.Stop();
+	// Snapshot last, so it is the newer file and wins on the next start
+	SaveStateToJson();
+	SaveSnapshot();
+}
+void AlarmService::SyncJournal()
+{
+	HIK_TRACE_SCOPE("persistence", "journalWait");
+	auto start = std::chrono::steady_clock::now();
+	journal.WaitDurable(journal.LastSequence());
+	Metrics::RecordPersistence(PersistenceMetric::JOURNAL_WAIT,
+		std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+void AlarmService::SyncJournalSince(uint64_t sequence)
+{
+	if (journal.LastSequence() == sequence) return;
+	SyncJournal();
+}
+std::vector<PartitionGauge> AlarmService::PartitionGauges()
+{
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	auto shardLocks = LockAllShardsShared();
+	std::vector<PartitionGauge> gauges(partitions.size());
+	for (size_t slot = 0; slot < partitions.size(); slot++) {
+		gauges[slot].partitionId = partitions[slot]->id;
+	}
+	for (const auto& zone : zones) {
+		uint32_t slot = partitionIndex.Find(zone->partitionId);
+		if (slot == IdIndex::kNotFound) continue;
+		PartitionGauge& gauge = gauges[slot];
+		gauge.zones++;
+		if (zone->isArmed) gauge.armed++;
+		if (zone->isAlarming) gauge.alarming++;
+		if (zone->isBypassed) gauge.bypassed++;
+	}
+	return gauges;
+}
+std::string AlarmService::CreateResponse(const std::string& status, const std::string& message, int id, const std::string& state) {
+	return ResponseWriter::Response(status, message, id, state);
 }
 std::string AlarmService::ArmPartition(int partitionId)
 {
-	Logger::Info("Request to ARM Partition: " + std::to_string(partitionId));
+	return ToJson(ArmPartitionResult(partitionId));
+}
+std::string AlarmService::DisarmPartition(int partitionId)
+{
+	return ToJson(DisarmPartitionResult(partitionId));
+}
+CommandResult AlarmService::ArmPartitionResult(int partitionId)
+{
+	HIK_TRACE_SCOPE("service", "ArmPartition");
+	Logger::Info<LogFormat::ARM_PARTITION_REQUEST>(partitionId);
 
-	auto partition = GetPartitionById(partitionId);
-	if (!partition)
+	CommandResult result;
+	result.id = partitionId;
+
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	uint32_t partitionSlot = partitionIndex.Find(partitionId);
+	if (partitionSlot == IdIndex::kNotFound)
 	{
-		Logger::Warning("ArmPartition failed: Partition " + std::to_string(partitionId) + " does not exist.");
-		return CreateResponse("ERROR", "Partition not found", partitionId);
+		Logger::Warning<LogFormat::ARM_PARTITION_NOT_FOUND>(partitionId);
+		return PartitionNotFound(partitionId);
 	}
+	auto& partition = partitions[partitionSlot];
+	std::unique_lock<std::shared_mutex> shardLock(ShardFor(partitionId));
 	if (partition->isArmed) 
 	{
-		Logger::Info("Partition " + std::to_string(partitionId) + " already armed.");
-		return CreateResponse("IGNORED", "Partition already armed", partitionId, "ARMED");
+		Logger::Info<LogFormat::PARTITION_ALREADY_ARMED>(partitionId);
+		result.status = CommandStatus::IGNORED;
+		result.message = "Partition already armed";
+		result.state = "ARMED";
+		return result;
 	}
 
-	json errorList = json::array();
-	std::vector<std::shared_ptr<Zone>> zonesToArm;
+	PartitionTimers& timing = partitionTimers[partitionSlot];
+	if (timing.exitTimer != 0)
+	{
+		result.status = CommandStatus::IGNORED;
+		result.message = "Partition is already arming";
+		result.state = "ARMING";
+		return result;
+	}
 
-	for (auto& zone : zones) {
-		if (zone->partitionId == partitionId) {
+	std::vector<uint32_t> zonesToArm;
+	if (!CheckPartitionReady(partitionSlot, result, zonesToArm)) {
+		return result;
+	}
+	if (timing.exitDelayMs > 0) {
+		// Readiness is checked again when the exit delay is over
+		timing.exitTimer = StartTimer(TimerKind::EXIT_DELAY, partitionId, timing.exitDelayMs);
+		Logger::Info<LogFormat::EXIT_DELAY_STARTED>(partitionId, timing.exitDelayMs);
+		result.message = "Partition arming, exit delay " + std::to_string(timing.exitDelayMs) + " ms";
+		result.state = "ARMING";
+		return result;
+	}
+	int armedCount = ArmPartitionZones(partitionSlot, zonesToArm);
+	result.message = "Partition with " + std::to_string(armedCount) + " zones, armed successfully";
+	result.state = "ARMED";
+	return result;
+}
+// Caller holds the partition's stripe. Collects the zones to arm, or fills
+// result with the zones that keep the partition from arming.
+bool AlarmService::CheckPartitionReady(uint32_t partitionSlot, CommandResult& result, std::vector<uint32_t>& zonesToArm)
+{
+	for (uint32_t zoneSlot : partitionMembers[partitionSlot]) {
+		auto& zone = zones[zoneSlot];
 
-			if (zone->isBypassed) {
-				zonesToArm.push_back(zone);
-				Logger::Info("Zone " + std::to_string(zone->id) + " is bypassed. Ignoring status checks.");
-				continue; 
-			}
-			if (zone->isTampered) {
-				json errorItem;
-				errorItem["id"] = zone->id;
-				errorItem["name"] = zone->name;
-				errorItem["bypassed"] = zone->isBypassed;
-				errorItem["reason"] = "ZONE_TAMPERED";
-				errorList.push_back(errorItem);
-			}
-			else if (zone->isFaulted) {
-				json errorItem;
-				errorItem["id"] = zone->id;
-				errorItem["name"] = zone->name;
-				errorItem["bypassed"] = zone->isBypassed;
-				errorItem["reason"] = "ZONE_FAULTED";
-				errorList.push_back(errorItem);
-			}
-			else if (zone->isActive) {
-				json errorItem;
-				errorItem["id"] = zone->id;
-				errorItem["name"] = zone->name;
-				errorItem["bypassed"] = zone->isBypassed;
-				errorItem["reason"] = "ZONE_ACTIVE";
-				errorList.push_back(errorItem);
-			}
-			else {
-				zonesToArm.push_back(zone);
-			}
+		if (zone->isBypassed) {
+			zonesToArm.push_back(zoneSlot);
+			Logger::Info<LogFormat::ARM_PARTITION_ZONE_BYPASSED>(zone->id);
+			continue; 
+		}
+		if (zone->isTampered) {
+			result.faults.push_back({ zone->id, zone->name, zone->isBypassed, FaultReason::TAMPERED });
+		}
+		else if (zone->isFaulted) {
+			result.faults.push_back({ zone->id, zone->name, zone->isBypassed, FaultReason::FAULTED });
+		}
+		else if (zone->isActive) {
+			result.faults.push_back({ zone->id, zone->name, zone->isBypassed, FaultReason::ACTIVE });
+		}
+		else {
+			zonesToArm.push_back(zoneSlot);
 		}
 	}
-	if (!errorList.empty()) {
-		json response;
-		response["status"] = "ERROR";
-		response["message"] = "Partition not ready";
-		response["partitionId"] = partitionId;
-		response["faultedZones"] = errorList;
-
-		Logger::Warning("Arming Partition " + std::to_string(partitionId) + " failed due to active/faulted zones.");
-		return response.dump();
+	if (!result.faults.empty()) {
+		Logger::Warning<LogFormat::ARM_PARTITION_NOT_READY>(partitions[partitionSlot]->id);
+		result.status = CommandStatus::FAILURE;
+		result.error = CommandError::NOT_READY;
+		result.message = "Partition not ready";
+		return false;
 	}
+	return true;
+}
+// Caller holds the partition's stripe; returns how many zones were armed
+int AlarmService::ArmPartitionZones(uint32_t partitionSlot, const std::vector<uint32_t>& zonesToArm)
+{
 	int armedCount = 0;
-	for (auto& zone : zonesToArm) {
+	for (uint32_t zoneSlot : zonesToArm) {
+		auto& zone = zones[zoneSlot];
 
 		if (!zone->isArmed) {
 			zone->Arm();
+			ZoneStateChanged(zoneSlot);
 
 			if (zone->isArmed) {
 				armedCount++;
 			}
 		}
 	}
-	partition->isArmed = true;
-	return CreateResponse("SUCCESS", "Partition with "+ std::to_string(armedCount) + " zones, armed successfully", partitionId, "ARMED");
+	partitions[partitionSlot]->isArmed = true;
+	PartitionStateChanged(*partitions[partitionSlot]);
+	return armedCount;
 }
-std::string AlarmService::DisarmPartition(int partitionId)
+CommandResult AlarmService::DisarmPartitionResult(int partitionId)
 {
-	Logger::Info("Request to DISARM Partition: " + std::to_string(partitionId));
+	HIK_TRACE_SCOPE("service", "DisarmPartition");
+	Logger::Info<LogFormat::DISARM_PARTITION_REQUEST>(partitionId);
+
+	CommandResult result;
+	result.id = partitionId;
 
-	auto partition = GetPartitionById(partitionId);
-	if (!partition) {
-		return CreateResponse("ERROR", "Partition not found", partitionId);
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	uint32_t partitionSlot = partitionIndex.Find(partitionId);
+	if (partitionSlot == IdIndex::kNotFound) {
+		return PartitionNotFound(partitionId);
+	}
+	auto& partition = partitions[partitionSlot];
+	std::unique_lock<std::shared_mutex> shardLock(ShardFor(partitionId));
+	PartitionTimers& timing = partitionTimers[partitionSlot];
+	if (timing.exitTimer != 0) {
+		StopTimer(timing.exitTimer);
+		Logger::Info<LogFormat::EXIT_DELAY_CANCELLED>(partitionId);
+		if (!partition->isArmed) {
+			result.message = "Partition arming cancelled";
+			result.state = "DISARMED";
+			return result;
+		}
 	}
 	if (!partition->isArmed)
 	{
-		Logger::Info("Partition " + std::to_string(partitionId) + " already armed.");
-		return CreateResponse("IGNORED", "Partition already disarmed", partitionId, "DISARMED");
+		Logger::Info<LogFormat::PARTITION_ALREADY_ARMED>(partitionId);
+		result.status = CommandStatus::IGNORED;
+		result.message = "Partition already disarmed";
+		result.state = "DISARMED";
+		return result;
 	}
 
-	for (auto& zone : zones) {
-		if (zone->partitionId == partitionId) {
-			zone->Disarm();
-		}
+	for (uint32_t zoneSlot : partitionMembers[partitionSlot]) {
+		zones[zoneSlot]->Disarm();
+		ZoneStateChanged(zoneSlot);
 	}
 	partition->isArmed = false;
-	return CreateResponse("SUCCESS", "Partition disarmed", partitionId, "DISARMED");
-}
-json AlarmService::CreateZoneJson(const std::shared_ptr<Zone>& zone)
-{
-	json jZone; 
-	jZone["id"] = zone->id; 
-	jZone["name"] = zone->name; 
-	jZone["type"] = zone->GetType(); 
-	jZone["armed"] = zone->isArmed; 
-	jZone["bypassed"] = zone->isBypassed; 
-	jZone["alarming"] = zone->isAlarming; 
-	jZone["active"] = zone->isActive;
-	jZone["tampered"] = zone->isTampered;
-	jZone["faulted"] = zone->isFaulted;
-	jZone["partitionId"] = zone->partitionId;
-	return jZone;
+	PartitionStateChanged(*partition);
+	result.message = "Partition disarmed";
+	result.state = "DISARMED";
+	return result;
+}
+// Fixed-width snapshots of the zones matching a filter, for the binary protocol
+bool AlarmService::SelectZoneRecords(const std::string& filterText, std::vector<ZoneRecord>& records)
+{
+	records.clear();
+	ZoneFilter filter;
+	std::string error;
+	if (!ZoneFilter::Parse(filterText, filter, error)) {
+		Logger::Warning<LogFormat::FILTER_INVALID>("SelectZoneRecords", filterText, error);
+		return false;
+	}
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	ResolvePartitions(filter);
+	auto shardLocks = LockAllShardsShared();
+
+	std::vector<uint32_t> slots;
+	stateIndex.Select(filter, slots);
+	records.reserve(slots.size());
+	for (uint32_t slot : slots) {
+		const Zone& zone = *zones[slot];
+		records.push_back({ zone.id, zone.partitionId, ZoneFlags(zone) });
+	}
+	return true;
+}
+bool AlarmService::GetZoneRecord(int zoneId, ZoneRecord& record)
+{
+	std::shared_lock<std::shared_mutex> structureLock(structureMutex);
+	auto zone = FindZone(zoneId);
+	if (!zone) return false;
+	std::shared_lock<std::shared_mutex> shardLock(ShardFor(zone->partitionId));
+	record = { zone->id, zone->partitionId, ZoneFlags(*zone) };
+	return true;
+}
+// Render a command result in the text protocol's JSON shape
+std::string AlarmService::ToJson(const CommandResult& result)
+{
+	HIK_TRACE_SCOPE("json", "ToJson");
+	if (result.faults.empty()) {
+		return CreateResponse(CommandStatusName(result.status), result.message, result.id, result.state);
+	}
+	std::string out;
+	JsonWriter writer(out);
+	writer.BeginObject();
+	writer.Key("faultedZones");
+	writer.BeginArray();
+	for (const auto& fault : result.faults) {
+		ResponseWriter::WriteZoneFault(writer, fault.id, fault.name, fault.bypassed, FaultReasonName(fault.reason));
+	}
+	writer.EndArray();
+	writer.Field("message", result.message);
+	writer.Field("partitionId", result.id);
+	writer.Field("status", CommandStatusName(result.status));
+	writer.EndObject();
+	return out;
+}
+CommandResult AlarmService::MakeResult(CommandStatus status, const std::string& message, const Zone& zone, const std::string& state)
+{
+	CommandResult result;
+	result.status = status;
+	result.id = zone.id;
+	result.message = message;
+	result.state = state;
+	result.zoneFlags = ZoneFlags(zone);
+	return result;
+}
+CommandResult AlarmService::ZoneNotFound(int zoneId)
+{
+	CommandResult result;
+	result.status = CommandStatus::FAILURE;
+	result.error = CommandError::NOT_FOUND;
+	result.id = zoneId;
+	result.message = "Zone not found";
+	return result;
+}
+CommandResult AlarmService::PartitionNotFound(int partitionId)
+{
+	CommandResult result;
+	result.status = CommandStatus::FAILURE;
+	result.error = CommandError::NOT_FOUND;
+	result.id = partitionId;
+	result.message = "Partition not found";
+	return result;
+}
+uint16_t AlarmService::ZoneFlags(const Zone& zone)
+{
+	uint16_t flags = 0;
+	if (zone.isArmed) flags |= ZONE_ARMED;
+	if (zone.isBypassed) flags |= ZONE_BYPASSED;
+	if (zone.isAlarming) flags |= ZONE_ALARMING;
+	if (zone.isActive) flags |= ZONE_ACTIVE;
+	if (zone.isTampered) flags |= ZONE_TAMPERED;
+	if (zone.isFaulted) flags |= ZONE_FAULTED;
+	return flags;
+}
+// Stripe that guards the state of a partition and all of its zones
+size_t AlarmService::ShardIndex(int partitionId)
+{
+	return static_cast<unsigned int>(partitionId) % kLockShards;
+}
+std::shared_mutex& AlarmService::ShardFor(int partitionId) const
+{
+	return shardMutexes[ShardIndex(partitionId)];
+}
+void AlarmService::LockShardsOf(const std::vector<uint32_t>& zoneSlots, bool exclusive, ShardLocks& locks) const
+{
+	std::array<bool, kLockShards> used{};
+	for (uint32_t slot : zoneSlots) {
+		if (slot != IdIndex::kNotFound) used[ShardIndex(zones[slot]->partitionId)] = true;
+	}
+	for (size_t shard = 0; shard < kLockShards; shard++) {
+		if (!used[shard]) continue;
+		if (exclusive) locks.exclusive.emplace_back(shardMutexes[shard]);
+		else locks.shared.emplace_back(shardMutexes[shard]);
+	}
+}
+std::vector<std::shared_lock<std::shared_mutex>> AlarmService::LockAllShardsShared() const
+{
+	std::vector<std::shared_lock<std::shared_mutex>> locks;
+	locks.reserve(kLockShards);
+	for (auto& shard : shardMutexes) {
+		locks.emplace_back(shard);
+	}
+	return locks;
 }
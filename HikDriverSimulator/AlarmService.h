@@ -1,30 +1,188 @@
 #pragma once
 #include <vector>
 #include <memory>
-#include <nlohmann/json.hpp>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
 #include "Zone.h"
 #include "Partition.h"
+#include "IdIndex.h"
+#include "ZoneStateIndex.h"
+#include "CommandResult.h"
+#include "StateJournal.h"
+#include "BackgroundTask.h"
+#include "StateSnapshot.h"
+#include "EventHub.h"
+#include "SensorPipeline.h"
+#include "TimerScheduler.h"
+#include "Metrics.h"
 
 
 
+// Outcome of one snapshot of system_state.snap
+struct SnapshotStats {
+	bool saved = false;
+	size_t zoneCount = 0;
+	size_t bytes = 0;
+	int64_t copyMicros = 0;		// how long every stripe was held
+	int64_t writeMillis = 0;	// serialization and the atomic write
+};
+
+// Delay settings for DELAY; entry and restore are per zone, exit and siren
+// per partition
+enum class DelayKind : uint8_t {
+	EXIT,
+	ENTRY,
+	SIREN,
+	RESTORE
+};
+
+// Concurrency model:
+//  - structureMutex guards the zone/partition containers and every zone's
+//    partitionId. Commands take it shared; loading/reloading takes it exclusive.
+//  - Zone and partition state is guarded by a striped lock chosen by partition
+//    id. A zone command locks only its own partition's stripe, ArmPartition /
+//    DisarmPartition lock only their stripe, so independent partitions run in
+//    parallel. Whole-system reads take every stripe shared, in index order.
+//  - Delayed transitions (exit/entry delay, siren timeout, active restore)
+//    are timers on one TimerScheduler. Their settings and pending timer ids
+//    are guarded by the same stripe as the zone or partition they belong to.
+//  - Every state change is appended to the journal and published to the
+//    EventHub while its stripe is held, so journal and event order match the
+//    order changes were applied.
 class AlarmService
 {
 private:
+	static constexpr size_t kLockShards = 32;
+
 	std::vector<std::shared_ptr<Zone>> zones;
 	std::vector<std::shared_ptr<Partition>> partitions;
+	// O(1) id -> slot lookups and, per partition slot, the slots of its zones
+	IdIndex zoneIndex;
+	IdIndex partitionIndex;
+	std::vector<std::vector<uint32_t>> partitionMembers;
+	// Packed flag/membership bit columns for filtered list and count queries
+	ZoneStateIndex stateIndex;
+	// Serialized JSON per zone slot, re-encoded only when the zone changed.
+	// Dirty flags are bytes (not vector<bool>) so writers on different
+	// stripes never share a memory location; readers hold every stripe.
+	std::vector<std::string> zoneJsonFragments;
+	std::vector<uint8_t> zoneJsonDirty;
+	// Flags of each zone slot as last published, to tell subscribers what changed
+	std::vector<uint16_t> publishedFlags;
+	// Bumped by every state change and recorded per zone and partition slot.
+	// Starts at the wall clock in microseconds, so it keeps growing across
+	// restarts and a poller's old sequence never skips changes.
+	std::atomic<uint64_t> changeSequence;
+	std::vector<uint64_t> zoneChangeSequence;
+	std::vector<uint64_t> partitionChangeSequence;
+	std::atomic<uint64_t> zoneJsonGeneration{ 1 };
+	// LIST_ALL_ZONES payload and the generation it was built at
+	std::string allZonesJson;
+	uint64_t allZonesGeneration = 0;
+	std::mutex jsonCacheMutex;
+	mutable std::shared_mutex structureMutex;
+	mutable std::array<std::shared_mutex, kLockShards> shardMutexes;
+	// Snapshots run on snapshotTask, one at a time under snapshotMutex
+	std::mutex snapshotMutex;
+	SnapshotStats lastSnapshot;
+	// Zone and partition state bits copied at one instant
+	struct StateCopy {
+		std::vector<uint16_t> zoneStates;
+		std::vector<uint8_t> partitionStates;
+		uint64_t rotation = 0;
+	};
+	StateJournal journal;
+	BackgroundTask snapshotTask;
+	EventHub events;
+	SensorPipeline sensors;
+
+	enum class TimerKind : uint8_t {
+		EXIT_DELAY,
+		ENTRY_DELAY,
+		SIREN_TIMEOUT,
+		ACTIVE_RESTORE
+	};
+	// Delay settings (0 = off) and pending timers, per zone / partition slot
+	struct ZoneTimers {
+		uint32_t entryDelayMs = 0;
+		uint32_t restoreMs = 0;
+		uint64_t entryTimer = 0;
+		uint64_t sirenTimer = 0;
+		uint64_t restoreTimer = 0;
+	};
+	struct PartitionTimers {
+		uint32_t exitDelayMs = 0;
+		uint32_t sirenTimeoutMs = 0;
+		uint64_t exitTimer = 0;
+	};
+	std::vector<ZoneTimers> zoneTimers;
+	std::vector<PartitionTimers> partitionTimers;
+	TimerScheduler timers;
+
+	static size_t ShardIndex(int partitionId);
+	std::shared_mutex& ShardFor(int partitionId) const;
+	std::vector<std::shared_lock<std::shared_mutex>> LockAllShardsShared() const;
+	// Stripes held by a command that touches many zones
+	struct ShardLocks {
+		std::vector<std::unique_lock<std::shared_mutex>> exclusive;
+		std::vector<std::shared_lock<std::shared_mutex>> shared;
+		size_t Count() const { return exclusive.size() + shared.size(); }
+	};
+	// Lock every stripe the given zone slots live on, in index order;
+	// caller holds structureMutex
+	void LockShardsOf(const std::vector<uint32_t>& zoneSlots, bool exclusive, ShardLocks& locks) const;
+	// Lookups without locking; callers hold structureMutex
+	std::shared_ptr<Zone> FindZone(int zoneId) const;
+	std::shared_ptr<Partition> FindPartition(int partitionId) const;
+	void RebuildIndexes();
+	void MoveZoneToPartition(const std::shared_ptr<Zone>& zone, int newPartitionId);
+	void ZoneStateChanged(uint32_t zoneSlot);
+	void PartitionStateChanged(const Partition& partition);
+	uint64_t StartTimer(TimerKind kind, int id, uint32_t milliseconds);
+	void StopTimer(uint64_t& timerId);
+	void StartEntryDelay(uint32_t zoneSlot);
+	void UpdateZoneTimers(uint32_t zoneSlot, uint16_t previousFlags, uint16_t flags);
+	void TimersExpired(const std::vector<ExpiredTimer>& expired);
+	bool CheckPartitionReady(uint32_t partitionSlot, CommandResult& result, std::vector<uint32_t>& zonesToArm);
+	int ArmPartitionZones(uint32_t partitionSlot, const std::vector<uint32_t>& zonesToArm);
+	void ApplyJournalRecord(const JournalRecord& record);
+	void CopyState(StateCopy& copy, bool rotateJournal);
+	SnapshotStats SaveSnapshot();
+	bool LoadSnapshot();
+	static void ApplyZoneFlags(Zone& zone, uint16_t flags);
+	void ResetJsonCache();
+	const std::string& ZoneJsonFragment(uint32_t zoneSlot);
+	void ResolvePartitions(ZoneFilter& filter) const;
+	std::string ListZonesMatching(ZoneFilter filter, const std::string& description);
+	size_t CountZonesMatching(ZoneFilter filter);
+	static ZoneFilter MakeFilter(const std::string& filterText);
+	static CommandResult MakeResult(CommandStatus status, const std::string& message, const Zone& zone, const std::string& state);
+	static CommandResult ZoneNotFound(int zoneId);
+	// Apply debounced sensor changes; runs on the sensor pipeline thread
+	void ApplySensorChanges(const std::vector<SensorEvent>& changes);
+	// Zone command body shared by the single and batch forms
+	CommandResult ApplyZoneOperation(ZoneOperation operation, uint32_t zoneSlot, bool logDetails);
+	static CommandResult PartitionNotFound(int partitionId);
+	static uint16_t ZoneFlags(const Zone& zone);
 	std::string CreateResponse(const std::string& status, const std::string& message, int id = -1, const std::string& state = "");
-	nlohmann::json CreateZoneJson(const std::shared_ptr<Zone>& zone);
 
 public:
 	AlarmService();
 	~AlarmService();
 	void InitializeZones();
 	std::string ListAllZones();
-	std::string ListOneZone(int zoneId);
+	// The listing methods that can fail report it through status
+	std::string ListOneZone(int zoneId, CommandStatus& status);
 	std::string ListArmedZones();
 	std::string ListBypassedZones();
 	std::string ListDisarmedZones();
 	std::string ListAlarmingZones();
+	std::string ListZones(const std::string& filterText, CommandStatus& status);
+	// Zones and partitions changed after sequence, plus the current sequence
+	std::string ListChangesSince(uint64_t sequence);
+	std::string CountZones(const std::string& filterText, CommandStatus& status);
 	std::string GetZoneStatus(int zoneId);
 	std::shared_ptr<Zone> GetZoneById(int zoneId);
 	std::shared_ptr<Partition> GetPartitionById(int partitionId);
@@ -34,9 +192,63 @@ public:
 	std::string TriggerZone(int zoneId);
 	std::string ArmPartition(int partitionId);
 	std::string DisarmPartition(int partitionId);
+
+	// Structured variants shared by the text and binary protocols
+	CommandResult ArmZoneResult(int zoneId);
+	CommandResult DisarmZoneResult(int zoneId);
+	CommandResult BypassZoneResult(int zoneId, bool active);
+	CommandResult ZoneStatusResult(int zoneId);
+	CommandResult TriggerZoneResult(int zoneId);
+	CommandResult ArmPartitionResult(int partitionId);
+	CommandResult DisarmPartitionResult(int partitionId);
+	// Render a result in the text protocol's JSON shape
+	std::string ToJson(const CommandResult& result);
+	// Batch form of a zone command: one result per id, in request order
+	std::vector<CommandResult> ZoneBatchResult(ZoneOperation operation, const std::vector<int>& zoneIds);
+	// status is FAILURE when every id failed
+	std::string ZoneBatch(ZoneOperation operation, const std::vector<int>& zoneIds, CommandStatus& status);
+	bool SelectZoneRecords(const std::string& filterText, std::vector<ZoneRecord>& records);
+	bool GetZoneRecord(int zoneId, ZoneRecord& record);
+	bool CountZonesMatching(const std::string& filterText, size_t& count);
+
 	void SaveStateToTxt();
 	void LoadStateFromTxt();
+	// system_state.json is the import/export format; the binary snapshot is
+	// what a restart loads
 	void SaveStateToJson();
 	void LoadStateFromJson();
+	// Load system_state.snap (or, failing that, zones.csv and
+	// system_state.json), replay the journal on top, keep journaling and
+	// start periodic background snapshots, sensor ingestion and timers
+	void RecoverState();
+	// Replace the site with a synthetic one for the traffic simulator and
+	// start sensor ingestion and timers; the usual state files are not read
+	// or written. A non-empty journalPath gets a fresh journal.
+	void LoadSyntheticSite(size_t zoneCount, size_t partitionCount, const std::string& journalPath);
+	// Snapshot on the background thread and wait for it
+	SnapshotStats TakeSnapshot();
+	// Stop timers, sensor ingestion and background snapshots, then export
+	// JSON and save a final snapshot on the calling thread. Pending delays
+	// are dropped.
+	void Shutdown();
+	// Block until every state change made so far is on disk
+	void SyncJournal();
+	// Sequence of the last journal record, for SyncJournalSince
+	uint64_t JournalSequence() const { return journal.LastSequence(); }
+	// SyncJournal, skipped when nothing was journaled after sequence
+	void SyncJournalSince(uint64_t sequence);
+	// State change events, published while the changed zone's stripe is held
+	EventHub& Events() { return events; }
+	// Raw sensor input (SENSOR command), applied after debouncing
+	SensorPipeline& Sensors() { return sensors; }
+	// DELAY: set a delay for zones or partitions (0 turns it off)
+	std::string SetDelay(DelayKind kind, const std::vector<int>& ids, uint32_t milliseconds, CommandStatus& status);
+	static bool ParseDelayKind(std::string_view name, DelayKind& kind);
+	static const char* DelayKindName(DelayKind kind);
+	// TIMERS: pending timers per wheel level and how late they fire
+	std::string TimerStatus();
+	TimerStats TimerStatistics() const { return timers.Stats(); }
+	// Zone counts per partition for METRICS and the Prometheus exporter
+	std::vector<PartitionGauge> PartitionGauges();
 
 	};
@@ -0,0 +1,67 @@
+#include "BackgroundTask.h"
+#include "Tracer.h"
+
+BackgroundTask::~BackgroundTask()
+{
+	Stop();
+}
+void BackgroundTask::Start(std::chrono::milliseconds runInterval, std::function<void()> task)
+{
+	Stop();
+	std::lock_guard<std::mutex> lock(mutex);
+	job = std::move(task);
+	interval = runInterval;
+	running = true;
+	stopping = false;
+	thread = std::thread(&BackgroundTask::Loop, this);
+}
+void BackgroundTask::Request()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!running) return;
+		requestedRuns++;
+	}
+	requestCondition.notify_one();
+}
+bool BackgroundTask::RunAndWait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	if (!running || stopping) return false;
+	uint64_t ticket = ++requestedRuns;
+	requestCondition.notify_one();
+	doneCondition.wait(lock, [this, ticket] { return completedRuns >= ticket || !running; });
+	return completedRuns >= ticket;
+}
+void BackgroundTask::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!running) return;
+		stopping = true;
+	}
+	requestCondition.notify_one();
+	if (thread.joinable()) thread.join();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	running = false;
+	doneCondition.notify_all();
+}
+void BackgroundTask::Loop()
+{
+	Tracer::NameThread("background-task");
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!stopping) {
+		// Returns false on timeout, which is the periodic run
+		requestCondition.wait_for(lock, interval, [this] { return stopping || requestedRuns > completedRuns; });
+		if (stopping) break;
+
+		// Everything requested up to here is served by this run
+		uint64_t serving = requestedRuns;
+		lock.unlock();
+		job();
+		lock.lock();
+		completedRuns = serving;
+		doneCondition.notify_all();
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Runs one job on its own thread, every interval and whenever requested.
+// Requests that arrive while the job runs are folded into a single rerun.
+class BackgroundTask
+{
+private:
+	std::function<void()> job;
+	std::chrono::milliseconds interval{ 0 };
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable requestCondition;
+	std::condition_variable doneCondition;
+	uint64_t requestedRuns = 0;
+	uint64_t completedRuns = 0;
+	bool running = false;
+	bool stopping = false;
+
+	void Loop();
+
+public:
+	BackgroundTask() = default;
+	~BackgroundTask();
+	BackgroundTask(const BackgroundTask&) = delete;
+	BackgroundTask& operator=(const BackgroundTask&) = delete;
+
+	void Start(std::chrono::milliseconds runInterval, std::function<void()> task);
+	// Schedule a run without waiting for it
+	void Request();
+	// Schedule a run and wait until it has finished; false if not started
+	bool RunAndWait();
+	void Stop();
+};
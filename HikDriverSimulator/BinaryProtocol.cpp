@@ -0,0 +1,196 @@
+#include "BinaryProtocol.h"
+#include <algorithm>
+#include <vector>
+#include "Logger.h"
+
+namespace {
+	constexpr size_t kRequestHeader = 5;
+	static_assert(BinaryProtocol::kMaxFaults <= std::numeric_limits<uint16_t>::max(), "the fault count field is a u16");
+
+	uint32_t ReadU32(const char* data) {
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+		return static_cast<uint32_t>(bytes[0])
+			| static_cast<uint32_t>(bytes[1]) << 8
+			| static_cast<uint32_t>(bytes[2]) << 16
+			| static_cast<uint32_t>(bytes[3]) << 24;
+	}
+	void WriteU8(std::string& out, uint8_t value) {
+		out.push_back(static_cast<char>(value));
+	}
+	void WriteU16(std::string& out, uint16_t value) {
+		char bytes[2] = { static_cast<char>(value), static_cast<char>(value >> 8) };
+		out.append(bytes, sizeof(bytes));
+	}
+	void WriteU32(std::string& out, uint32_t value) {
+		char bytes[4] = { static_cast<char>(value), static_cast<char>(value >> 8),
+			static_cast<char>(value >> 16), static_cast<char>(value >> 24) };
+		out.append(bytes, sizeof(bytes));
+	}
+
+	// Write a zero length prefix (patched by EndResponse) and the response header
+	void BeginResponse(std::string& out, uint8_t opcode, uint32_t tag, CommandStatus status, CommandError error) {
+		WriteU32(out, 0);
+		WriteU8(out, opcode);
+		WriteU32(out, tag);
+		WriteU8(out, static_cast<uint8_t>(status));
+		WriteU8(out, static_cast<uint8_t>(error));
+	}
+	void EndResponse(std::string& out) {
+		uint32_t length = static_cast<uint32_t>(out.size() - BinaryProtocol::kLengthSize);
+		for (size_t i = 0; i < BinaryProtocol::kLengthSize; i++) {
+			out[i] = static_cast<char>(length >> (8 * i));
+		}
+	}
+
+	void WriteZoneResult(std::string& out, uint8_t opcode, uint32_t tag, const CommandResult& result) {
+		BeginResponse(out, opcode, tag, result.status, result.error);
+		WriteU32(out, static_cast<uint32_t>(result.id));
+		WriteU16(out, result.zoneFlags);
+	}
+	void WritePartitionResult(std::string& out, uint8_t opcode, uint32_t tag, const CommandResult& result) {
+		BeginResponse(out, opcode, tag, result.status, result.error);
+		WriteU32(out, static_cast<uint32_t>(result.id));
+		// A partition can hold more faulted zones than the count field can
+		// express; the count must match the entries that follow
+		size_t count = std::min(result.faults.size(), BinaryProtocol::kMaxFaults);
+		WriteU16(out, static_cast<uint16_t>(count));
+		for (size_t i = 0; i < count; i++) {
+			WriteU32(out, static_cast<uint32_t>(result.faults[i].id));
+			WriteU8(out, static_cast<uint8_t>(result.faults[i].reason));
+		}
+	}
+	void WriteRecords(std::string& out, const std::vector<ZoneRecord>& records) {
+		WriteU32(out, static_cast<uint32_t>(records.size()));
+		for (const auto& record : records) {
+			WriteU32(out, static_cast<uint32_t>(record.id));
+			WriteU32(out, static_cast<uint32_t>(record.partitionId));
+			WriteU16(out, record.flags);
+		}
+	}
+	void WriteError(std::string& out, uint8_t opcode, uint32_t tag, CommandError error) {
+		BeginResponse(out, opcode, tag, CommandStatus::FAILURE, error);
+	}
+}
+
+bool BinaryProtocol::PeekLength(std::string_view data, uint32_t& length)
+{
+	if (data.size() < kLengthSize) return false;
+	length = ReadU32(data.data());
+	return true;
+}
+std::string BinaryProtocol::Handle(AlarmService& alarmService, std::string_view payload)
+{
+	std::string out;
+	if (payload.size() < kRequestHeader) {
+		WriteError(out, 0, 0, CommandError::INVALID_ARGUMENT);
+		EndResponse(out);
+		return out;
+	}
+	uint8_t opcode = static_cast<uint8_t>(payload[0]);
+	uint32_t tag = ReadU32(payload.data() + 1);
+	std::string_view arguments = payload.substr(kRequestHeader);
+
+	// Commands that take a single u32 id
+	bool hasId = arguments.size() >= 4;
+	int id = hasId ? static_cast<int>(ReadU32(arguments.data())) : 0;
+
+	switch (static_cast<BinaryOpcode>(opcode)) {
+	case BinaryOpcode::ARM:
+	case BinaryOpcode::DISARM:
+	case BinaryOpcode::BYPASS:
+	case BinaryOpcode::UNBYPASS:
+	case BinaryOpcode::STATUS:
+	case BinaryOpcode::TRIGGER: {
+		if (!hasId) break;
+		CommandResult result;
+		switch (static_cast<BinaryOpcode>(opcode)) {
+		case BinaryOpcode::ARM: result = alarmService.ArmZoneResult(id); break;
+		case BinaryOpcode::DISARM: result = alarmService.DisarmZoneResult(id); break;
+		case BinaryOpcode::BYPASS: result = alarmService.BypassZoneResult(id, true); break;
+		case BinaryOpcode::UNBYPASS: result = alarmService.BypassZoneResult(id, false); break;
+		case BinaryOpcode::STATUS: result = alarmService.ZoneStatusResult(id); break;
+		default: result = alarmService.TriggerZoneResult(id); break;
+		}
+		WriteZoneResult(out, opcode, tag, result);
+		EndResponse(out);
+		return out;
+	}
+	case BinaryOpcode::ARM_PARTITION:
+	case BinaryOpcode::DISARM_PARTITION: {
+		if (!hasId) break;
+		CommandResult result = static_cast<BinaryOpcode>(opcode) == BinaryOpcode::ARM_PARTITION
+			? alarmService.ArmPartitionResult(id)
+			: alarmService.DisarmPartitionResult(id);
+		WritePartitionResult(out, opcode, tag, result);
+		EndResponse(out);
+		return out;
+	}
+	case BinaryOpcode::LIST_ONE_ZONE: {
+		if (!hasId) break;
+		std::vector<ZoneRecord> records(1);
+		if (!alarmService.GetZoneRecord(id, records[0])) {
+			WriteError(out, opcode, tag, CommandError::NOT_FOUND);
+			WriteRecords(out, {});
+		}
+		else {
+			BeginResponse(out, opcode, tag, CommandStatus::SUCCESS, CommandError::NONE);
+			WriteRecords(out, records);
+		}
+		EndResponse(out);
+		return out;
+	}
+	case BinaryOpcode::LIST_ALL_ZONES:
+	case BinaryOpcode::LIST_ARMED_ZONES:
+	case BinaryOpcode::LIST_BYPASSED_ZONES:
+	case BinaryOpcode::LIST_DISARMED_ZONES:
+	case BinaryOpcode::LIST_ALARMING_ZONES:
+	case BinaryOpcode::LIST_ZONES: {
+		std::string filter;
+		switch (static_cast<BinaryOpcode>(opcode)) {
+		case BinaryOpcode::LIST_ALL_ZONES: filter = "all"; break;
+		case BinaryOpcode::LIST_ARMED_ZONES: filter = "armed"; break;
+		case BinaryOpcode::LIST_BYPASSED_ZONES: filter = "bypassed"; break;
+		case BinaryOpcode::LIST_DISARMED_ZONES: filter = "disarmed"; break;
+		case BinaryOpcode::LIST_ALARMING_ZONES: filter = "alarming"; break;
+		default: filter.assign(arguments.data(), arguments.size()); break;
+		}
+		std::vector<ZoneRecord> records;
+		if (!alarmService.SelectZoneRecords(filter, records)) break;
+		BeginResponse(out, opcode, tag, CommandStatus::SUCCESS, CommandError::NONE);
+		WriteRecords(out, records);
+		EndResponse(out);
+		return out;
+	}
+	case BinaryOpcode::COUNT_ZONES: {
+		size_t count = 0;
+		if (!alarmService.CountZonesMatching(std::string(arguments), count)) break;
+		BeginResponse(out, opcode, tag, CommandStatus::SUCCESS, CommandError::NONE);
+		WriteU32(out, static_cast<uint32_t>(count));
+		EndResponse(out);
+		return out;
+	}
+	default:
+		Logger::Error("Unknown binary opcode: " + std::to_string(opcode));
+		WriteError(out, opcode, tag, CommandError::UNKNOWN_COMMAND);
+		EndResponse(out);
+		return out;
+	}
+	// Known opcode with missing or malformed arguments
+	WriteError(out, opcode, tag, CommandError::INVALID_ARGUMENT);
+	EndResponse(out);
+	return out;
+}
+bool BinaryProtocol::IsFailure(std::string_view frame)
+{
+	// The status byte follows the length prefix, opcode and tag
+	constexpr size_t statusOffset = kLengthSize + kRequestHeader;
+	return frame.size() > statusOffset
+		&& static_cast<CommandStatus>(frame[statusOffset]) == CommandStatus::FAILURE;
+}
+std::string BinaryProtocol::ErrorFrame(CommandError error)
+{
+	std::string out;
+	WriteError(out, 0, 0, error);
+	EndResponse(out);
+	return out;
+}
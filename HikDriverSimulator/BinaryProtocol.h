@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include "AlarmService.h"
+
+// Compact binary framing, negotiated per connection with the text command
+// "PROTOCOL:BINARY". After its JSON acknowledgement both directions carry
+// length-prefixed frames; all integers are little-endian.
+//
+//   frame    : u32 length | payload[length]
+//   request  : u8 opcode | u32 tag | arguments
+//   response : u8 opcode | u32 tag | u8 status | u8 error | body
+//
+// The tag is chosen by the client and echoed back. status and error are
+// CommandStatus and CommandError values. Arguments and bodies per opcode:
+//   zone commands      : u32 zoneId      -> u32 zoneId, u16 state bits
+//   partition commands : u32 partitionId -> u32 partitionId, u16 n,
+//                                           n x (u32 zoneId, u8 FaultReason)
+//                        (the first kMaxFaults faults only)
+//   list commands      : none / u32 zoneId / filter text
+//                                        -> u32 n, n x (u32 id, u32 partitionId, u16 state bits)
+//   COUNT_ZONES        : filter text     -> u32 count
+// State bits are the ZoneStateBit values.
+enum class BinaryOpcode : uint8_t {
+	ARM = 0x01,
+	DISARM = 0x02,
+	BYPASS = 0x03,
+	UNBYPASS = 0x04,
+	STATUS = 0x05,
+	TRIGGER = 0x06,
+	ARM_PARTITION = 0x10,
+	DISARM_PARTITION = 0x11,
+	LIST_ONE_ZONE = 0x20,
+	LIST_ALL_ZONES = 0x21,
+	LIST_ARMED_ZONES = 0x22,
+	LIST_BYPASSED_ZONES = 0x23,
+	LIST_DISARMED_ZONES = 0x24,
+	LIST_ALARMING_ZONES = 0x25,
+	LIST_ZONES = 0x26,
+	COUNT_ZONES = 0x27
+};
+
+class BinaryProtocol
+{
+public:
+	static constexpr size_t kLengthSize = 4;
+	// Largest accepted request payload
+	static constexpr size_t kMaxFrameLength = 64 * 1024;
+	// Faults listed in a partition reply; the rest are left out
+	static constexpr size_t kMaxFaults = std::numeric_limits<uint16_t>::max();
+
+	// Read the payload length of the frame starting at data, if it is complete
+	static bool PeekLength(std::string_view data, uint32_t& length);
+	// Execute one request payload and return the complete response frame
+	static std::string Handle(AlarmService& alarmService, std::string_view payload);
+	// Frame reporting an error that is not tied to a request (e.g. oversized frame)
+	static std::string ErrorFrame(CommandError error);
+	// Whether a response frame from Handle reports FAILURE
+	static bool IsFailure(std::string_view frame);
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32 (IEEE 802.3, as used by zip and PNG) for on-disk records.
+// Slicing-by-8: eight bytes per step through eight lookup tables, fast
+// enough to validate a multi-megabyte snapshot in a few milliseconds.
+class Checksum
+{
+private:
+	using Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+	static constexpr Tables BuildTables() {
+		Tables tables{};
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t value = i;
+			for (int bit = 0; bit < 8; bit++) {
+				value = (value & 1) ? (value >> 1) ^ 0xEDB88320u : value >> 1;
+			}
+			tables[0][i] = value;
+		}
+		for (uint32_t i = 0; i < 256; i++) {
+			for (size_t slice = 1; slice < 8; slice++) {
+				uint32_t previous = tables[slice - 1][i];
+				tables[slice][i] = (previous >> 8) ^ tables[0][previous & 0xFF];
+			}
+		}
+		return tables;
+	}
+
+public:
+	// Pass the previous result as crc to checksum data in pieces
+	static uint32_t Crc32(const void* data, size_t length, uint32_t crc = 0) {
+		static constexpr Tables kTables = BuildTables();
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		crc = ~crc;
+		while (length >= 8) {
+			uint32_t low = crc ^ (static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8
+				| static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24);
+			crc = kTables[7][low & 0xFF] ^ kTables[6][(low >> 8) & 0xFF]
+				^ kTables[5][(low >> 16) & 0xFF] ^ kTables[4][low >> 24]
+				^ kTables[3][bytes[4]] ^ kTables[2][bytes[5]]
+				^ kTables[1][bytes[6]] ^ kTables[0][bytes[7]];
+			bytes += 8;
+			length -= 8;
+		}
+		while (length-- > 0) {
+			crc = kTables[0][(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+		}
+		return ~crc;
+	}
+};
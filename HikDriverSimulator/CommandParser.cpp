@@ -0,0 +1,178 @@
+#include "CommandParser.h"
+#include <array>
+#include <charconv>
+#include <cstdint>
+
+namespace {
+	struct CommandName {
+		std::string_view name;
+		TextCommand command;
+	};
+
+	constexpr std::array<CommandName, 27> kCommands = { {
+		{ "ARM", TextCommand::ARM },
+		{ "DISARM", TextCommand::DISARM },
+		{ "BYPASS", TextCommand::BYPASS },
+		{ "UNBYPASS", TextCommand::UNBYPASS },
+		{ "STATUS", TextCommand::STATUS },
+		{ "TRIGGER", TextCommand::TRIGGER },
+		{ "LIST_ALL_ZONES", TextCommand::LIST_ALL_ZONES },
+		{ "LIST_ARMED_ZONES", TextCommand::LIST_ARMED_ZONES },
+		{ "LIST_BYPASSED_ZONES", TextCommand::LIST_BYPASSED_ZONES },
+		{ "LIST_DISARMED_ZONES", TextCommand::LIST_DISARMED_ZONES },
+		{ "LIST_ALARMING_ZONES", TextCommand::LIST_ALARMING_ZONES },
+		{ "LIST_ZONES", TextCommand::LIST_ZONES },
+		{ "COUNT_ZONES", TextCommand::COUNT_ZONES },
+		{ "LIST_ONE_ZONE", TextCommand::LIST_ONE_ZONE },
+		{ "DISARM_PARTITION", TextCommand::DISARM_PARTITION },
+		{ "ARM_PARTITION", TextCommand::ARM_PARTITION },
+		{ "PROTOCOL", TextCommand::PROTOCOL },
+		{ "SNAPSHOT", TextCommand::SNAPSHOT },
+		{ "SUBSCRIBE", TextCommand::SUBSCRIBE },
+		{ "UNSUBSCRIBE", TextCommand::UNSUBSCRIBE },
+		{ "LIST_CHANGES_SINCE", TextCommand::LIST_CHANGES_SINCE },
+		{ "SENSOR", TextCommand::SENSOR },
+		{ "DEBOUNCE", TextCommand::DEBOUNCE },
+		{ "DELAY", TextCommand::DELAY },
+		{ "TIMERS", TextCommand::TIMERS },
+		{ "METRICS", TextCommand::METRICS },
+		{ "TRACE", TextCommand::TRACE },
+	} };
+
+	// Table size is a power of two about 4x the command count, so a
+	// collision-free seed turns up after a handful of tries
+	constexpr size_t kTableSize = 64;
+	constexpr int8_t kEmptySlot = -1;
+
+	constexpr char ToUpper(char c) {
+		return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+	}
+	// Case-insensitive FNV-1a
+	constexpr uint32_t Hash(std::string_view text, uint32_t seed) {
+		uint32_t hash = 2166136261u ^ seed;
+		for (char c : text) {
+			hash ^= static_cast<unsigned char>(ToUpper(c));
+			hash *= 16777619u;
+		}
+		return hash ^ (hash >> 16);
+	}
+	constexpr bool IsPerfect(uint32_t seed) {
+		std::array<bool, kTableSize> used{};
+		for (const auto& entry : kCommands) {
+			size_t slot = Hash(entry.name, seed) & (kTableSize - 1);
+			if (used[slot]) return false;
+			used[slot] = true;
+		}
+		return true;
+	}
+	constexpr uint32_t FindSeed() {
+		for (uint32_t seed = 0; seed < 1000; seed++) {
+			if (IsPerfect(seed)) return seed;
+		}
+		return UINT32_MAX;
+	}
+	constexpr uint32_t kSeed = FindSeed();
+	static_assert(kSeed != UINT32_MAX, "no perfect hash seed for the command table");
+
+	constexpr std::array<int8_t, kTableSize> BuildTable() {
+		std::array<int8_t, kTableSize> table{};
+		for (auto& slot : table) slot = kEmptySlot;
+		for (size_t i = 0; i < kCommands.size(); i++) {
+			table[Hash(kCommands[i].name, kSeed) & (kTableSize - 1)] = static_cast<int8_t>(i);
+		}
+		return table;
+	}
+	constexpr std::array<int8_t, kTableSize> kTable = BuildTable();
+
+	std::string_view TrimBlanks(std::string_view text) {
+		while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+		while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+		return text;
+	}
+}
+
+bool CommandParser::EqualsIgnoreCase(std::string_view text, std::string_view upper)
+{
+	if (text.size() != upper.size()) return false;
+	for (size_t i = 0; i < text.size(); i++) {
+		if (ToUpper(text[i]) != upper[i]) return false;
+	}
+	return true;
+}
+TextCommand CommandParser::Lookup(std::string_view name)
+{
+	int8_t index = kTable[Hash(name, kSeed) & (kTableSize - 1)];
+	if (index == kEmptySlot || !EqualsIgnoreCase(name, kCommands[index].name)) {
+		return TextCommand::UNKNOWN;
+	}
+	return kCommands[index].command;
+}
+std::string_view CommandParser::Name(TextCommand command)
+{
+	for (const auto& entry : kCommands) {
+		if (entry.command == command) return entry.name;
+	}
+	return "UNKNOWN";
+}
+ParsedCommand CommandParser::Parse(std::string_view message)
+{
+	// Framing already removed the line terminator; tolerate stray ones
+	while (!message.empty() && (message.back() == '\n' || message.back() == '\r')) message.remove_suffix(1);
+
+	ParsedCommand parsed;
+	size_t delimiterPos = message.find(':');
+	if (delimiterPos != std::string_view::npos) {
+		parsed.name = message.substr(0, delimiterPos);
+		parsed.argument = message.substr(delimiterPos + 1);
+	}
+	else {
+		parsed.name = message;
+	}
+	parsed.command = Lookup(parsed.name);
+	return parsed;
+}
+bool CommandParser::ParseId(std::string_view text, int& id)
+{
+	text = TrimBlanks(text);
+	if (text.size() > 1 && text[0] == '+' && text[1] != '-') text.remove_prefix(1);
+	auto result = std::from_chars(text.data(), text.data() + text.size(), id);
+	return !text.empty() && result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+bool CommandParser::ParseUnsigned(std::string_view text, uint64_t& value)
+{
+	text = TrimBlanks(text);
+	auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+	return !text.empty() && result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+bool CommandParser::IsIdList(std::string_view text)
+{
+	text = TrimBlanks(text);
+	return text.find(',') != std::string_view::npos
+		|| (text.size() > 1 && text.find('-', 1) != std::string_view::npos);
+}
+bool CommandParser::ParseIdList(std::string_view text, std::vector<int>& ids, size_t maxIds)
+{
+	ids.clear();
+	while (true) {
+		size_t comma = text.find(',');
+		std::string_view item = TrimBlanks(text.substr(0, comma));
+		// A '-' past the first character separates a range; a leading one is a sign
+		size_t dash = item.size() > 1 ? item.find('-', 1) : std::string_view::npos;
+		if (dash == std::string_view::npos) {
+			int id = 0;
+			if (!ParseId(item, id) || ids.size() >= maxIds) return false;
+			ids.push_back(id);
+		}
+		else {
+			int first = 0;
+			int last = 0;
+			if (!ParseId(item.substr(0, dash), first) || !ParseId(item.substr(dash + 1), last) || first > last) return false;
+			if (static_cast<int64_t>(last) - first >= static_cast<int64_t>(maxIds - ids.size())) return false;
+			for (int64_t id = first; id <= last; id++) {
+				ids.push_back(static_cast<int>(id));
+			}
+		}
+		if (comma == std::string_view::npos) return true;
+		text.remove_prefix(comma + 1);
+	}
+}
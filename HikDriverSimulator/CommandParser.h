@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+enum class TextCommand : uint8_t {
+	ARM,
+	DISARM,
+	BYPASS,
+	UNBYPASS,
+	STATUS,
+	TRIGGER,
+	LIST_ALL_ZONES,
+	LIST_ARMED_ZONES,
+	LIST_BYPASSED_ZONES,
+	LIST_DISARMED_ZONES,
+	LIST_ALARMING_ZONES,
+	LIST_ZONES,
+	COUNT_ZONES,
+	LIST_ONE_ZONE,
+	DISARM_PARTITION,
+	ARM_PARTITION,
+	PROTOCOL,
+	SNAPSHOT,
+	SUBSCRIBE,
+	UNSUBSCRIBE,
+	LIST_CHANGES_SINCE,
+	SENSOR,
+	DEBOUNCE,
+	DELAY,
+	TIMERS,
+	METRICS,
+	TRACE,
+	UNKNOWN
+};
+
+// One text command split into its name and argument. Both views point into
+// the original line, so parsing never copies or allocates.
+struct ParsedCommand {
+	TextCommand command = TextCommand::UNKNOWN;
+	std::string_view name;
+	std::string_view argument;
+};
+
+// Allocation-free parser for the "COMMAND[:ARGUMENT]" text protocol.
+// Command names are matched case-insensitively through a perfect hash table
+// generated at compile time; nothing on this path throws.
+class CommandParser
+{
+public:
+	static ParsedCommand Parse(std::string_view message);
+	static TextCommand Lookup(std::string_view name);
+	// Canonical uppercase name; "UNKNOWN" for TextCommand::UNKNOWN
+	static std::string_view Name(TextCommand command);
+	// Decimal id with optional surrounding blanks; false on anything else
+	static bool ParseId(std::string_view text, int& id);
+	// Same for an unsigned 64-bit value such as a change sequence
+	static bool ParseUnsigned(std::string_view text, uint64_t& value);
+	// Batch argument such as "1,2,5-9": any comma, or a '-' after the first
+	// character (a lone "-3" is still a single id)
+	static bool IsIdList(std::string_view text);
+	// Comma-separated ids and inclusive ranges, expanded in order; false on a
+	// malformed item, a reversed range or more than maxIds ids
+	static bool ParseIdList(std::string_view text, std::vector<int>& ids, size_t maxIds);
+	static bool EqualsIgnoreCase(std::string_view text, std::string_view upper);
+};
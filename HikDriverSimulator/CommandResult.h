@@ -0,0 +1,116 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Protocol-neutral outcome of an AlarmService command. The text protocol
+// renders it as a JSON line, the binary protocol as a fixed-width frame.
+// FAILURE renders as "ERROR"; ERROR itself is a macro in the Windows headers
+enum class CommandStatus : uint8_t {
+	SUCCESS,
+	IGNORED,
+	INFO,
+	ALARM,
+	FAILURE
+};
+
+enum class CommandError : uint8_t {
+	NONE,
+	NOT_FOUND,
+	NOT_READY,
+	INVALID_ARGUMENT,
+	UNKNOWN_COMMAND,
+	FRAME_TOO_LARGE
+};
+
+// Zone commands that also come in a batch form (ARM:1,2,5-9)
+enum class ZoneOperation : uint8_t {
+	ARM,
+	DISARM,
+	BYPASS,
+	UNBYPASS,
+	STATUS,
+	TRIGGER
+};
+
+// Zone state as a bitfield, shared by ZoneRecord and the binary protocol
+enum ZoneStateBit : uint16_t {
+	ZONE_ARMED = 1 << 0,
+	ZONE_BYPASSED = 1 << 1,
+	ZONE_ALARMING = 1 << 2,
+	ZONE_ACTIVE = 1 << 3,
+	ZONE_TAMPERED = 1 << 4,
+	ZONE_FAULTED = 1 << 5
+};
+
+enum class FaultReason : uint8_t {
+	TAMPERED = 1,
+	FAULTED = 2,
+	ACTIVE = 3
+};
+
+// Fixed-width zone snapshot used by the binary list replies
+struct ZoneRecord {
+	int id;
+	int partitionId;
+	uint16_t flags;
+};
+
+// A zone that prevented a partition from arming
+struct ZoneFault {
+	int id;
+	std::string name;
+	bool bypassed;
+	FaultReason reason;
+};
+
+struct CommandResult {
+	CommandStatus status = CommandStatus::SUCCESS;
+	CommandError error = CommandError::NONE;
+	int id = -1;
+	// "newState" of the JSON reply, empty when the reply has none
+	std::string state;
+	std::string message;
+	// Zone state after the command (zone commands only)
+	uint16_t zoneFlags = 0;
+	// ArmPartition: zones that kept the partition from arming
+	std::vector<ZoneFault> faults;
+};
+
+inline const char* CommandStatusName(CommandStatus status)
+{
+	switch (status) {
+	case CommandStatus::SUCCESS: return "SUCCESS";
+	case CommandStatus::IGNORED: return "IGNORED";
+	case CommandStatus::INFO: return "INFO";
+	case CommandStatus::ALARM: return "ALARM";
+	default: return "ERROR";
+	}
+}
+inline const char* ZoneOperationName(ZoneOperation operation)
+{
+	switch (operation) {
+	case ZoneOperation::ARM: return "ARM";
+	case ZoneOperation::DISARM: return "DISARM";
+	case ZoneOperation::BYPASS: return "BYPASS";
+	case ZoneOperation::UNBYPASS: return "UNBYPASS";
+	case ZoneOperation::STATUS: return "STATUS";
+	default: return "TRIGGER";
+	}
+}
+// Overall status of a batch reply: FAILURE when every id failed
+inline CommandStatus BatchStatus(const std::vector<CommandResult>& results)
+{
+	for (const auto& result : results) {
+		if (result.status != CommandStatus::FAILURE) return CommandStatus::SUCCESS;
+	}
+	return results.empty() ? CommandStatus::SUCCESS : CommandStatus::FAILURE;
+}
+inline const char* FaultReasonName(FaultReason reason)
+{
+	switch (reason) {
+	case FaultReason::TAMPERED: return "ZONE_TAMPERED";
+	case FaultReason::FAULTED: return "ZONE_FAULTED";
+	default: return "ZONE_ACTIVE";
+	}
+}
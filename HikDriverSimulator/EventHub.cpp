@@ -0,0 +1,172 @@
+#include "EventHub.h"
+#include <algorithm>
+#include "CommandParser.h"
+#include "CommandResult.h"
+
+namespace {
+	struct EventName {
+		std::string_view name;
+		uint16_t flag;
+	};
+	constexpr EventName kEventNames[] = {
+		{ "ARMED", ZONE_ARMED },
+		{ "BYPASSED", ZONE_BYPASSED },
+		{ "ALARMING", ZONE_ALARMING },
+		{ "ACTIVE", ZONE_ACTIVE },
+		{ "TAMPERED", ZONE_TAMPERED },
+		{ "FAULTED", ZONE_FAULTED },
+	};
+
+	bool ParseIdList(std::string_view text, std::vector<int>& ids) {
+		while (true) {
+			size_t comma = text.find(',');
+			int id;
+			if (!CommandParser::ParseId(text.substr(0, comma), id)) return false;
+			ids.push_back(id);
+			if (comma == std::string_view::npos) return true;
+			text.remove_prefix(comma + 1);
+		}
+	}
+
+	bool ParseEventList(std::string_view text, SubscriptionFilter& filter) {
+		filter.zoneChanges = 0;
+		filter.partitionEvents = false;
+		while (true) {
+			size_t comma = text.find(',');
+			std::string_view name = text.substr(0, comma);
+			if (CommandParser::EqualsIgnoreCase(name, "PARTITION")) {
+				filter.partitionEvents = true;
+			}
+			else {
+				auto it = std::find_if(std::begin(kEventNames), std::end(kEventNames),
+					[name](const EventName& entry) { return CommandParser::EqualsIgnoreCase(name, entry.name); });
+				if (it == std::end(kEventNames)) return false;
+				filter.zoneChanges |= it->flag;
+			}
+			if (comma == std::string_view::npos) return true;
+			text.remove_prefix(comma + 1);
+		}
+	}
+
+	uint64_t PendingKey(const StateEvent& event) {
+		return (static_cast<uint64_t>(event.kind) << 32) | static_cast<uint32_t>(event.id);
+	}
+}
+
+bool SubscriptionFilter::Parse(std::string_view text, SubscriptionFilter& filter, std::string& error)
+{
+	filter = SubscriptionFilter();
+	while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+	while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+	if (text.empty() || CommandParser::EqualsIgnoreCase(text, "ALL")) return true;
+
+	while (true) {
+		size_t ampersand = text.find('&');
+		std::string_view part = text.substr(0, ampersand);
+		size_t equals = part.find('=');
+		std::string_view key = part.substr(0, equals);
+		std::string_view value = equals == std::string_view::npos ? std::string_view() : part.substr(equals + 1);
+
+		bool valid = false;
+		if (CommandParser::EqualsIgnoreCase(key, "PARTITION")) valid = ParseIdList(value, filter.partitionIds);
+		else if (CommandParser::EqualsIgnoreCase(key, "ZONE")) valid = ParseIdList(value, filter.zoneIds);
+		else if (CommandParser::EqualsIgnoreCase(key, "EVENTS")) valid = ParseEventList(value, filter);
+		if (!valid) {
+			error = "Invalid subscription filter part: " + std::string(part);
+			return false;
+		}
+		if (ampersand == std::string_view::npos) break;
+		text.remove_prefix(ampersand + 1);
+	}
+	if (!filter.zoneIds.empty()) filter.partitionEvents = false;
+	return true;
+}
+bool SubscriptionFilter::Matches(const StateEvent& event) const
+{
+	if (!partitionIds.empty()
+		&& std::find(partitionIds.begin(), partitionIds.end(), event.partitionId) == partitionIds.end()) {
+		return false;
+	}
+	if (event.kind == StateEventKind::PARTITION) return partitionEvents;
+	if (!zoneIds.empty() && std::find(zoneIds.begin(), zoneIds.end(), event.id) == zoneIds.end()) {
+		return false;
+	}
+	return (event.changed & zoneChanges) != 0;
+}
+
+Subscription::Subscription(SubscriptionFilter filter, std::function<void()> notify)
+	: filter(std::move(filter)), notify(std::move(notify))
+{
+}
+void Subscription::Push(const StateEvent& event)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (closed) return;
+
+	uint64_t key = PendingKey(event);
+	if (pending.size() >= kCoalesceAfter) {
+		auto it = pendingIndex.find(key);
+		if (it != pendingIndex.end()) {
+			StateEvent& queued = pending[it->second];
+			queued.flags = event.flags;
+			queued.partitionId = event.partitionId;
+			queued.changed |= event.changed;
+			queued.sequence = event.sequence;
+			return;
+		}
+		if (pending.size() >= kMaxPending) {
+			dropped++;
+			return;
+		}
+	}
+	pendingIndex[key] = pending.size();
+	pending.push_back(event);
+	if (pending.size() == 1 && notify) notify();
+}
+void Subscription::Drain(std::vector<StateEvent>& events, size_t& droppedEvents)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	events.swap(pending);
+	pending.clear();
+	pendingIndex.clear();
+	droppedEvents = dropped;
+	dropped = 0;
+}
+void Subscription::Close()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	closed = true;
+	notify = nullptr;
+	pending.clear();
+	pendingIndex.clear();
+}
+
+void EventHub::Add(const std::shared_ptr<Subscription>& subscription)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto updated = std::make_shared<SubscriberList>(*subscribers);
+	updated->push_back(subscription);
+	subscribers = std::move(updated);
+	subscriberCount.store(subscribers->size(), std::memory_order_relaxed);
+}
+void EventHub::Remove(const std::shared_ptr<Subscription>& subscription)
+{
+	subscription->Close();
+	std::lock_guard<std::mutex> lock(mutex);
+	auto updated = std::make_shared<SubscriberList>(*subscribers);
+	updated->erase(std::remove(updated->begin(), updated->end(), subscription), updated->end());
+	subscribers = std::move(updated);
+	subscriberCount.store(subscribers->size(), std::memory_order_relaxed);
+}
+void EventHub::Publish(const StateEvent& event)
+{
+	if (subscriberCount.load(std::memory_order_relaxed) == 0) return;
+	std::shared_ptr<const SubscriberList> current;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		current = subscribers;
+	}
+	for (const auto& subscription : *current) {
+		if (subscription->Filter().Matches(event)) subscription->Push(event);
+	}
+}
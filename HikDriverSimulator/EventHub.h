@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+enum class StateEventKind : uint8_t {
+	ZONE,
+	PARTITION
+};
+
+// One state change published by AlarmService. Zone flags are ZoneStateBit
+// values; a partition uses ZONE_ARMED for its armed state.
+struct StateEvent {
+	StateEventKind kind = StateEventKind::ZONE;
+	int id = 0;
+	int partitionId = -1;	// the zone's partition, or the partition itself
+	uint16_t flags = 0;
+	uint16_t changed = 0;	// flags that differ from the previous state
+	uint64_t sequence = 0;	// AlarmService change sequence, for LIST_CHANGES_SINCE
+};
+
+// Which events a subscriber receives. Syntax, every part optional:
+//   "partition=1,2&zone=5,7&events=alarming,tampered,partition"
+// Lists are OR-ed, parts are AND-ed. Event names are the zone flags
+// (armed, bypassed, alarming, active, tampered, faulted) plus "partition"
+// for partition arm/disarm. A zone list excludes partition events.
+struct SubscriptionFilter {
+	std::vector<int> partitionIds;
+	std::vector<int> zoneIds;
+	uint16_t zoneChanges = UINT16_MAX;
+	bool partitionEvents = true;
+
+	static bool Parse(std::string_view text, SubscriptionFilter& filter, std::string& error);
+	bool Matches(const StateEvent& event) const;
+};
+
+// Bounded, coalescing event queue of one subscriber. While the consumer
+// keeps up every change is queued in order. Past kCoalesceAfter queued
+// events, a zone or partition that changes again is folded into its latest
+// queued event (latest flags, every changed bit), so a slow consumer still
+// sees each object's final state. Once kMaxPending events are waiting,
+// changes to further objects are counted as dropped instead.
+class Subscription
+{
+public:
+	static constexpr size_t kCoalesceAfter = 256;
+	static constexpr size_t kMaxPending = 4096;
+
+	// notify runs, under the queue lock, when the queue becomes non-empty
+	Subscription(SubscriptionFilter filter, std::function<void()> notify);
+
+	const SubscriptionFilter& Filter() const { return filter; }
+	void Push(const StateEvent& event);
+	// Move out every queued event and the number dropped since the last drain
+	void Drain(std::vector<StateEvent>& events, size_t& dropped);
+	// Stop queueing and notifying; called when the subscriber goes away
+	void Close();
+
+private:
+	const SubscriptionFilter filter;
+	std::mutex mutex;
+	std::function<void()> notify;
+	std::vector<StateEvent> pending;
+	std::unordered_map<uint64_t, size_t> pendingIndex;
+	size_t dropped = 0;
+	bool closed = false;
+};
+
+// Fans state events out to subscribers. Publishers iterate an immutable
+// copy of the subscriber list, so adding or removing a subscriber never
+// blocks a publish for longer than a pointer copy, and with no subscribers
+// a publish is a single atomic load.
+class EventHub
+{
+public:
+	void Add(const std::shared_ptr<Subscription>& subscription);
+	void Remove(const std::shared_ptr<Subscription>& subscription);
+	void Publish(const StateEvent& event);
+	size_t SubscriberCount() const { return subscriberCount.load(std::memory_order_relaxed); }
+
+private:
+	using SubscriberList = std::vector<std::shared_ptr<Subscription>>;
+
+	std::mutex mutex;
+	std::shared_ptr<const SubscriberList> subscribers = std::make_shared<SubscriberList>();
+	std::atomic<size_t> subscriberCount{ 0 };
+};
@@ -0,0 +1,129 @@
+#include "FileApi.h"
+#include <cstdio>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+	HANDLE ToHandle(FileHandle file) {
+		return reinterpret_cast<HANDLE>(file);
+	}
+	FileHandle OpenNative(const std::string& path, DWORD disposition) {
+		HANDLE handle = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+			disposition, FILE_ATTRIBUTE_NORMAL, nullptr);
+		return handle == INVALID_HANDLE_VALUE ? kInvalidFile : reinterpret_cast<FileHandle>(handle);
+	}
+#else
+	FileHandle OpenNative(const std::string& path, int flags) {
+		int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | flags, 0644);
+		return fd < 0 ? kInvalidFile : fd;
+	}
+	// Make a rename in the directory of path durable
+	void SyncDirectory(const std::string& path) {
+		size_t slash = path.find_last_of('/');
+		std::string directory = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+		int fd = open(directory.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) return;
+		fsync(fd);
+		close(fd);
+	}
+#endif
+}
+
+FileHandle FileApi::OpenForAppend(const std::string& path)
+{
+#ifdef _WIN32
+	return OpenNative(path, OPEN_ALWAYS);
+#else
+	return OpenNative(path, O_APPEND);
+#endif
+}
+bool FileApi::Write(FileHandle file, const char* data, size_t length)
+{
+#ifdef _WIN32
+	// Always write at the end; the handle is shared by append and truncate
+	LARGE_INTEGER zero{};
+	if (!SetFilePointerEx(ToHandle(file), zero, nullptr, FILE_END)) return false;
+	while (length > 0) {
+		DWORD chunk = length > 0x40000000 ? 0x40000000 : static_cast<DWORD>(length);
+		DWORD written = 0;
+		if (!WriteFile(ToHandle(file), data, chunk, &written, nullptr)) return false;
+		data += written;
+		length -= written;
+	}
+#else
+	while (length > 0) {
+		ssize_t written = write(static_cast<int>(file), data, length);
+		if (written < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+		data += written;
+		length -= static_cast<size_t>(written);
+	}
+#endif
+	return true;
+}
+bool FileApi::Sync(FileHandle file)
+{
+#ifdef _WIN32
+	return FlushFileBuffers(ToHandle(file)) != 0;
+#else
+	return fsync(static_cast<int>(file)) == 0;
+#endif
+}
+bool FileApi::Truncate(FileHandle file, uint64_t length)
+{
+#ifdef _WIN32
+	LARGE_INTEGER position;
+	position.QuadPart = static_cast<LONGLONG>(length);
+	return SetFilePointerEx(ToHandle(file), position, nullptr, FILE_BEGIN) && SetEndOfFile(ToHandle(file));
+#else
+	return ftruncate(static_cast<int>(file), static_cast<off_t>(length)) == 0;
+#endif
+}
+void FileApi::Close(FileHandle file)
+{
+	if (file == kInvalidFile) return;
+#ifdef _WIN32
+	CloseHandle(ToHandle(file));
+#else
+	close(static_cast<int>(file));
+#endif
+}
+bool FileApi::WriteAtomically(const std::string& path, std::string_view data)
+{
+	std::string temporaryPath = path + ".tmp";
+#ifdef _WIN32
+	FileHandle file = OpenNative(temporaryPath, CREATE_ALWAYS);
+#else
+	FileHandle file = OpenNative(temporaryPath, O_TRUNC);
+#endif
+	if (file == kInvalidFile) return false;
+	bool written = Write(file, data.data(), data.size()) && Sync(file);
+	Close(file);
+	if (!written) {
+		std::remove(temporaryPath.c_str());
+		return false;
+	}
+	return Rename(temporaryPath, path);
+}
+bool FileApi::Rename(const std::string& from, const std::string& to)
+{
+#ifdef _WIN32
+	return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	if (rename(from.c_str(), to.c_str()) != 0) return false;
+	SyncDirectory(to);
+	return true;
+#endif
+}
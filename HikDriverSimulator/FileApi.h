@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Native file handle: a Win32 HANDLE or a POSIX descriptor
+using FileHandle = intptr_t;
+constexpr FileHandle kInvalidFile = -1;
+
+// Thin portability layer for files that must actually reach the disk.
+// iostreams cannot fsync, so the journal and snapshots write through here.
+class FileApi
+{
+public:
+	// Open for appending, creating the file if needed
+	static FileHandle OpenForAppend(const std::string& path);
+	static bool Write(FileHandle file, const char* data, size_t length);
+	// Flush file contents to stable storage (fsync / FlushFileBuffers)
+	static bool Sync(FileHandle file);
+	static bool Truncate(FileHandle file, uint64_t length);
+	static void Close(FileHandle file);
+	// Replace to with from and make the rename itself durable
+	static bool Rename(const std::string& from, const std::string& to);
+
+	// Write data to path + ".tmp", sync it and rename it over path, so readers
+	// see either the old or the new contents even after a crash.
+	static bool WriteAtomically(const std::string& path, std::string_view data);
+};
@@ -5,26 +5,46 @@
 #include <limits>
 #include "AlarmService.h"
 #include "Logger.h"
+#include "Tracer.h"
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
 
-HikDriverApp::HikDriverApp() : isRunning(true) {
+HikDriverApp::HikDriverApp(int metricsPort) : isRunning(true) {
 
+#ifdef HIK_BINARY_LOG
+	// Compact structured log; render it with Tools/LogDecoder
+	Logger::Init("applcation.binlog", true, LogFileFormat::BINARY);
+#else
 	Logger::Init("applcation.log");
+#endif
 	Logger::Info("HikDriver Simulator started");
+	// TRACE:ON starts recording; a signal dumps without a client connection
+	if (Tracer::kCompiledIn) Tracer::DumpOnSignal();
 
-	alarmService.InitializeZones();
-	alarmService.LoadStateFromJson();
+	alarmService.RecoverState();
 	tcpServer = std::make_unique<TcpServer>(12345, &alarmService);
 
 	if (!tcpServer->Start()) {
 		Logger::Error("Failed to start TCP Server");
 	}
+	if (metricsPort > 0) {
+		metricsExporter = std::make_unique<MetricsExporter>(metricsPort, &alarmService);
+		if (!metricsExporter->Start()) {
+			Logger::Error("Failed to start metrics exporter");
+			metricsExporter.reset();
+		}
+	}
 }
 HikDriverApp::~HikDriverApp() {
 	Logger::Info("[APP] Shutting down HikDriver Simulator");
-	alarmService.SaveStateToJson();
+	// No command may change the state once the final snapshot is under way
+	tcpServer.reset();
+	metricsExporter.reset();
+	alarmService.Shutdown();
+	// A dump in progress still logs, so stop the watcher first
+	Tracer::StopSignalWatcher();
+	Logger::Shutdown();
 }
 
 void HikDriverApp::ShowMenu() {
@@ -52,6 +72,7 @@ void HikDriverApp::Run() {
 
 	int choice = -1;
 	int id = 0;
+	CommandStatus status;
 
 	while (choice != 0) {
 		ShowMenu();
@@ -114,7 +135,7 @@ void HikDriverApp::Run() {
 		case 12:
 			std::cout << "Enter Zone ID to find: ";
 			std::cin >> id;
-			PrintJsonToConsole(alarmService.ListOneZone(id));
+			PrintJsonToConsole(alarmService.ListOneZone(id, status));
 			break;
 		case 0:
 			std::cout << "Exiting system..." << std::endl;
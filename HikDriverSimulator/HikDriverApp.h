@@ -5,17 +5,20 @@
 
 #include "AlarmService.h"
 #include "TcpServer.h"
+#include "MetricsExporter.h"
 
 class HikDriverApp {
 private:
 	AlarmService alarmService;
 	std::unique_ptr<TcpServer> tcpServer;
+	std::unique_ptr<MetricsExporter> metricsExporter;
 	bool isRunning;
 	void ShowMenu();
 	void PrintJsonToConsole(const std::string& jsonResponse);
 
 public:
-	HikDriverApp();
+	// metricsPort 0 leaves the Prometheus listener off
+	explicit HikDriverApp(int metricsPort = 0);
 	~HikDriverApp();
 	void Run();
 
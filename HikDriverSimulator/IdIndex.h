@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Open-addressing hash index from an entity id to its slot in a container.
+// Linear probing over a power-of-two table kept at most half full, so a
+// lookup is one multiply plus, on average, one or two cache-line probes.
+class IdIndex
+{
+private:
+	struct Entry {
+		int key;
+		uint32_t value;
+	};
+	std::vector<Entry> table;
+	size_t count = 0;
+	size_t mask = 0;
+
+	size_t HomeSlot(int key) const {
+		// Fibonacci hashing spreads sequential ids across the table
+		uint64_t hash = static_cast<uint64_t>(static_cast<uint32_t>(key)) * 0x9E3779B97F4A7C15ull;
+		return static_cast<size_t>(hash >> 32) & mask;
+	}
+	void Grow(size_t minCapacity) {
+		size_t capacity = 16;
+		while (capacity < minCapacity * 2) capacity <<= 1;
+		std::vector<Entry> old;
+		old.swap(table);
+		table.assign(capacity, Entry{ 0, kNotFound });
+		mask = capacity - 1;
+		count = 0;
+		for (const Entry& entry : old) {
+			if (entry.value != kNotFound) Insert(entry.key, entry.value);
+		}
+	}
+
+public:
+	static constexpr uint32_t kNotFound = UINT32_MAX;
+
+	void Clear() {
+		table.clear();
+		count = 0;
+		mask = 0;
+	}
+	void Reserve(size_t expected) {
+		if (expected * 2 > table.size()) Grow(expected);
+	}
+	// Returns false (and keeps the existing value) if the id is already present
+	bool Insert(int key, uint32_t value) {
+		if ((count + 1) * 2 > table.size()) Grow(table.empty() ? 8 : table.size());
+		size_t slot = HomeSlot(key);
+		while (table[slot].value != kNotFound) {
+			if (table[slot].key == key) return false;
+			slot = (slot + 1) & mask;
+		}
+		table[slot] = Entry{ key, value };
+		count++;
+		return true;
+	}
+	uint32_t Find(int key) const {
+		if (table.empty()) return kNotFound;
+		size_t slot = HomeSlot(key);
+		while (table[slot].value != kNotFound) {
+			if (table[slot].key == key) return table[slot].value;
+			slot = (slot + 1) & mask;
+		}
+		return kNotFound;
+	}
+	size_t Size() const { return count; }
+};
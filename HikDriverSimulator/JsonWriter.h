@@ -0,0 +1,118 @@
+#pragma once
+#include <cassert>
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Streaming JSON writer that appends straight into a caller-owned buffer.
+// No DOM is built; the only allocations are the buffer's own growth, so a
+// reused or reserved buffer makes a response allocation-free.
+//
+// Output matches nlohmann::json::dump() byte for byte as long as object keys
+// are written in ascending order (nlohmann sorts them); debug builds assert it.
+class JsonWriter
+{
+private:
+	static constexpr int kMaxDepth = 16;
+
+	std::string& out;
+	int depth = 0;
+	// Per nesting level: does the next value need a leading comma
+	bool needComma[kMaxDepth] = {};
+#ifndef NDEBUG
+	std::string_view lastKey[kMaxDepth];
+#endif
+
+	void Separator() {
+		if (needComma[depth]) out.push_back(',');
+		needComma[depth] = true;
+	}
+	void Open(char bracket) {
+		out.push_back(bracket);
+		assert(depth + 1 < kMaxDepth);
+		depth++;
+		needComma[depth] = false;
+#ifndef NDEBUG
+		lastKey[depth] = std::string_view();
+#endif
+	}
+	void Close(char bracket) {
+		out.push_back(bracket);
+		depth--;
+	}
+	void Escaped(std::string_view text) {
+		static const char* const kHex = "0123456789abcdef";
+		size_t runStart = 0;
+		for (size_t i = 0; i < text.size(); i++) {
+			unsigned char c = static_cast<unsigned char>(text[i]);
+			if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+			out.append(text.data() + runStart, i - runStart);
+			runStart = i + 1;
+			switch (c) {
+			case '"': out.append("\\\""); break;
+			case '\\': out.append("\\\\"); break;
+			case '\b': out.append("\\b"); break;
+			case '\f': out.append("\\f"); break;
+			case '\n': out.append("\\n"); break;
+			case '\r': out.append("\\r"); break;
+			case '\t': out.append("\\t"); break;
+			default: {
+				char unicode[6] = { '\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xF] };
+				out.append(unicode, sizeof(unicode));
+			}
+			}
+		}
+		out.append(text.data() + runStart, text.size() - runStart);
+	}
+
+public:
+	explicit JsonWriter(std::string& buffer) : out(buffer) {}
+
+	void BeginObject() { Separator(); Open('{'); }
+	void EndObject() { Close('}'); }
+	void BeginArray() { Separator(); Open('['); }
+	void EndArray() { Close(']'); }
+
+	// Keys are schema literals: written verbatim, never escaped
+	void Key(std::string_view key) {
+#ifndef NDEBUG
+		assert(lastKey[depth].empty() || lastKey[depth] < key);
+		lastKey[depth] = key;
+#endif
+		Separator();
+		out.push_back('"');
+		out.append(key);
+		out.append("\":");
+		// The value belongs to this key, not a new element
+		needComma[depth] = false;
+	}
+	void String(std::string_view value) {
+		Separator();
+		out.push_back('"');
+		Escaped(value);
+		out.push_back('"');
+	}
+	void Int(int64_t value) {
+		Separator();
+		char digits[24];
+		auto result = std::to_chars(digits, digits + sizeof(digits), value);
+		out.append(digits, result.ptr - digits);
+	}
+	void Bool(bool value) {
+		Separator();
+		out.append(value ? "true" : "false");
+	}
+	// Already-serialized JSON value, e.g. a cached zone fragment
+	void Raw(std::string_view json) {
+		Separator();
+		out.append(json);
+	}
+
+	void Field(std::string_view key, std::string_view value) { Key(key); String(value); }
+	void Field(std::string_view key, const char* value) { Key(key); String(value); }
+	void Field(std::string_view key, int64_t value) { Key(key); Int(value); }
+	void Field(std::string_view key, int value) { Key(key); Int(value); }
+	void Field(std::string_view key, bool value) { Key(key); Bool(value); }
+};
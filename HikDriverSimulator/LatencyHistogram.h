@@ -0,0 +1,84 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+// HDR-style latency histogram in nanoseconds. Buckets are log-linear: every
+// power of two is split into kSubBuckets linear steps, so any recorded value
+// is reported within ~6% over the whole 1 ns .. centuries range, in a fixed
+// 8 KiB array. Recording is a few instructions and never allocates.
+// Not thread-safe: record per thread and Merge for reports.
+class LatencyHistogram
+{
+public:
+	static constexpr uint32_t kSubBucketBits = 4;
+	static constexpr size_t kSubBuckets = size_t(1) << kSubBucketBits;
+	static constexpr size_t kBuckets = 64 * kSubBuckets;
+
+	void Record(uint64_t nanos) {
+		counts[IndexOf(nanos)]++;
+		total++;
+		sum += nanos;
+		if (nanos > max) max = nanos;
+	}
+	void Merge(const LatencyHistogram& other) {
+		for (size_t i = 0; i < kBuckets; i++) counts[i] += other.counts[i];
+		total += other.total;
+		sum += other.sum;
+		if (other.max > max) max = other.max;
+	}
+	void Reset() { *this = LatencyHistogram(); }
+	// Fold in counts kept elsewhere, e.g. in a SharedLatencyHistogram
+	void AddBucket(size_t index, uint64_t count) {
+		counts[index] += count;
+		total += count;
+	}
+	void AddTotals(uint64_t addedSum, uint64_t addedMax) {
+		sum += addedSum;
+		if (addedMax > max) max = addedMax;
+	}
+
+	uint64_t Count() const { return total; }
+	uint64_t Max() const { return max; }
+	uint64_t Sum() const { return sum; }
+	double Mean() const { return total == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(total); }
+	// Upper bound of the bucket holding the given percentile (0..100),
+	// capped at the largest recorded value
+	uint64_t Percentile(double percentile) const {
+		if (total == 0) return 0;
+		uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(total) + 0.5);
+		if (rank < 1) rank = 1;
+		if (rank > total) rank = total;
+		uint64_t seen = 0;
+		for (size_t i = 0; i < kBuckets; i++) {
+			seen += counts[i];
+			if (seen >= rank) {
+				uint64_t upper = UpperBoundOf(i);
+				return upper < max ? upper : max;
+			}
+		}
+		return max;
+	}
+	const std::array<uint64_t, kBuckets>& Buckets() const { return counts; }
+	// Largest value that lands in bucket index
+	static uint64_t UpperBoundOf(size_t index) {
+		if (index < kSubBuckets) return index;
+		uint32_t shift = static_cast<uint32_t>(index / kSubBuckets) - 1;
+		uint64_t sub = index % kSubBuckets;
+		uint64_t lower = (kSubBuckets + sub) << shift;
+		return lower + ((uint64_t(1) << shift) - 1);
+	}
+	static size_t IndexOf(uint64_t nanos) {
+		if (nanos < kSubBuckets) return static_cast<size_t>(nanos);
+		// Keep the top kSubBucketBits + 1 bits; the leading one picks the row
+		uint32_t shift = static_cast<uint32_t>(std::bit_width(nanos)) - kSubBucketBits - 1;
+		return (shift + 1) * kSubBuckets + static_cast<size_t>((nanos >> shift) & (kSubBuckets - 1));
+	}
+
+private:
+	std::array<uint64_t, kBuckets> counts{};
+	uint64_t total = 0;
+	uint64_t sum = 0;
+	uint64_t max = 0;
+};
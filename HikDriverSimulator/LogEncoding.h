@@ -0,0 +1,174 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Binary log layout shared by the Logger and the LogDecoder tool.
+// A file is a sequence of chunks, all integers little-endian:
+//
+//   chunk   : u8 kind | u32 length | payload[length]
+//   'H'     : u32 magic | u16 version | u16 n | n x (u16 length | format text)
+//   'R'     : u8 LogLevel | i64 time | u16 LogFormat | arguments
+//
+// Every session starts with an 'H' chunk holding the format catalog it was
+// built with, so a log can be decoded by any build of the decoder.
+// Each argument is a one byte tag followed by its value:
+//   'i' i64, 'u' u64, 'd' f64, 'b' u8, 's' u32 length | bytes
+class LogEncoding
+{
+public:
+	static constexpr uint32_t kMagic = 0x474C4B48; // "HKLG"
+	static constexpr uint16_t kVersion = 1;
+	static constexpr char kHeaderChunk = 'H';
+	static constexpr char kRecordChunk = 'R';
+	static constexpr size_t kChunkHeaderSize = 5;
+	static constexpr size_t kRecordHeaderSize = 11;
+
+	static void PutU16(std::string& out, uint16_t value) { PutBytes(out, value, 2); }
+	static void PutU32(std::string& out, uint32_t value) { PutBytes(out, value, 4); }
+	static void PutU64(std::string& out, uint64_t value) { PutBytes(out, value, 8); }
+
+	static uint64_t GetBytes(const char* data, size_t count) {
+		uint64_t value = 0;
+		for (size_t i = 0; i < count; i++) {
+			value |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+		}
+		return value;
+	}
+
+	// Append one argument to an encoded argument list
+	template <typename Buffer, typename T>
+	static void EncodeArgument(Buffer& out, const T& value) {
+		char bytes[9];
+		if constexpr (std::is_same_v<T, bool>) {
+			bytes[0] = 'b';
+			bytes[1] = value ? 1 : 0;
+			out.Append(bytes, 2);
+		}
+		else if constexpr (std::is_enum_v<T>) {
+			EncodeArgument(out, static_cast<std::underlying_type_t<T>>(value));
+		}
+		else if constexpr (std::is_integral_v<T>) {
+			bytes[0] = std::is_signed_v<T> ? 'i' : 'u';
+			StoreBytes(bytes + 1, static_cast<uint64_t>(value), 8);
+			out.Append(bytes, 9);
+		}
+		else if constexpr (std::is_floating_point_v<T>) {
+			double number = static_cast<double>(value);
+			uint64_t raw;
+			std::memcpy(&raw, &number, sizeof(raw));
+			bytes[0] = 'd';
+			StoreBytes(bytes + 1, raw, 8);
+			out.Append(bytes, 9);
+		}
+		else {
+			std::string_view text(value);
+			bytes[0] = 's';
+			StoreBytes(bytes + 1, static_cast<uint64_t>(text.size()), 4);
+			out.Append(bytes, 5);
+			out.Append(text.data(), text.size());
+		}
+	}
+
+	// Substitute the encoded arguments into the "{}" placeholders of format.
+	// Returns false if the arguments are truncated or malformed.
+	static bool Render(std::string_view format, std::string_view arguments, std::string& out) {
+		size_t pos = 0;
+		while (true) {
+			size_t placeholder = format.find("{}");
+			if (placeholder == std::string_view::npos) break;
+			out.append(format.data(), placeholder);
+			format.remove_prefix(placeholder + 2);
+			if (!RenderArgument(arguments, pos, out)) return false;
+		}
+		out.append(format.data(), format.size());
+		return pos == arguments.size();
+	}
+
+	static const char* LevelName(uint8_t level) {
+		// Matches the LogLevel enumerator order
+		switch (level) {
+		case 0: return "INFO";
+		case 1: return "WARNING";
+		case 2: return "ERROR";
+		case 3: return "NETWORK";
+		default: return "UNKNOWN";
+		}
+	}
+
+	// "YYYY-mm-dd HH:MM:SS" in local time, as written by the text log
+	static std::string FormatTime(std::time_t time) {
+		std::tm tmNow;
+#ifdef _WIN32
+		localtime_s(&tmNow, &time);
+#else
+		localtime_r(&time, &tmNow);
+#endif
+		char buffer[32];
+		size_t length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tmNow);
+		return std::string(buffer, length);
+	}
+
+private:
+	static void StoreBytes(char* out, uint64_t value, size_t count) {
+		for (size_t i = 0; i < count; i++) {
+			out[i] = static_cast<char>(value >> (8 * i));
+		}
+	}
+	static void PutBytes(std::string& out, uint64_t value, size_t count) {
+		char bytes[8];
+		StoreBytes(bytes, value, count);
+		out.append(bytes, count);
+	}
+	template <typename T>
+	static void AppendNumber(std::string& out, T value) {
+		char buffer[32];
+		auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+		out.append(buffer, result.ptr);
+	}
+	static bool RenderArgument(std::string_view arguments, size_t& pos, std::string& out) {
+		if (pos >= arguments.size()) return false;
+		const char* data = arguments.data() + pos;
+		size_t left = arguments.size() - pos;
+		switch (data[0]) {
+		case 'b':
+			if (left < 2) return false;
+			out += data[1] ? "true" : "false";
+			pos += 2;
+			return true;
+		case 'i':
+		case 'u':
+		case 'd': {
+			if (left < 9) return false;
+			uint64_t raw = GetBytes(data + 1, 8);
+			if (data[0] == 'i') {
+				AppendNumber(out, static_cast<int64_t>(raw));
+			}
+			else if (data[0] == 'u') {
+				AppendNumber(out, raw);
+			}
+			else {
+				double number;
+				std::memcpy(&number, &raw, sizeof(number));
+				AppendNumber(out, number);
+			}
+			pos += 9;
+			return true;
+		}
+		case 's': {
+			if (left < 5) return false;
+			size_t length = static_cast<size_t>(GetBytes(data + 1, 4));
+			if (left - 5 < length) return false;
+			out.append(data + 5, length);
+			pos += 5 + length;
+			return true;
+		}
+		default:
+			return false;
+		}
+	}
+};
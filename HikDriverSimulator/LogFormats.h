@@ -0,0 +1,223 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Catalog of structured log messages. Call sites log a LogFormat id plus raw
+// arguments; "{}" placeholders are filled in only when the record is
+// rendered as text (by the writer thread or by the LogDecoder tool).
+// Ids are stored in binary logs, but every binary log also embeds this
+// table, so entries may be added or reordered freely.
+enum class LogFormat : uint16_t {
+	TEXT,
+	ZONE_ALREADY_ARMED,
+	ZONE_ARMED,
+	ZONE_ARM_BLOCKED_BY_BYPASS,
+	ZONE_ALREADY_DISARMED,
+	ZONE_DISARMED,
+	ZONE_BYPASSED,
+	ZONE_UNBYPASSED,
+	ZONE_TAMPERED,
+	ZONE_TAMPER_CLEARED,
+	ZONE_FAULTED,
+	ZONE_FAULT_CLEARED,
+	ZONE_ACTIVE,
+	ZONE_INACTIVE,
+	ZONE_ALARM,
+	PARTITIONS_INITIALIZED,
+	ZONES_LOADING,
+	ZONES_OPEN_FAILED,
+	ZONES_LINES_SKIPPED,
+	ZONES_LINE_WARNINGS,
+	ZONES_INITIALIZED,
+	ARM_ZONE_NOT_FOUND,
+	ARM_ZONE_ALREADY_ARMED,
+	ARM_ZONE_BYPASSED,
+	DISARM_ZONE_NOT_FOUND,
+	DISARM_ZONE_ALREADY_DISARMED,
+	BYPASS_ZONE_NOT_FOUND,
+	TRIGGER_ZONE_NOT_FOUND,
+	TRIGGER_ZONE_BYPASSED,
+	TRIGGER_ZONE_DISARMED,
+	ZONE_ALARM_TRIGGERED,
+	LIST_ALL_STARTED,
+	LIST_ALL_DONE,
+	LIST_EMPTY,
+	LIST_ONE_STARTED,
+	LIST_ONE_NOT_FOUND,
+	LIST_ONE_DONE,
+	LIST_ARMED_STARTED,
+	LIST_BYPASSED_STARTED,
+	LIST_DISARMED_STARTED,
+	LIST_ALARMING_STARTED,
+	LIST_FILTER_STARTED,
+	LIST_FILTER_DONE,
+	LIST_CHANGES_DONE,
+	FILTER_INVALID,
+	DUPLICATE_PARTITION,
+	DUPLICATE_ZONE,
+	STATE_TXT_SAVE_FAILED,
+	STATE_TXT_SAVED,
+	STATE_TXT_MISSING,
+	STATE_TXT_CORRUPT,
+	STATE_TXT_LOADED,
+	STATE_JSON_SAVE_FAILED,
+	STATE_JSON_MISSING,
+	STATE_JSON_PARTITIONS_LOADED,
+	STATE_JSON_ZONES_LOADED,
+	STATE_JSON_UNKNOWN_ZONE,
+	STATE_JSON_PARSE_ERROR,
+	STATE_JSON_LOAD_ERROR,
+	ARM_PARTITION_REQUEST,
+	ARM_PARTITION_NOT_FOUND,
+	PARTITION_ALREADY_ARMED,
+	ARM_PARTITION_ZONE_BYPASSED,
+	ARM_PARTITION_NOT_READY,
+	DISARM_PARTITION_REQUEST,
+	NET_CLIENT_CONNECTED,
+	NET_CLIENT_DISCONNECTED,
+	NET_MESSAGE_RECEIVED,
+	NET_RESPONSE_SENT,
+	NET_LIST_ALL_SENT,
+	LOG_MESSAGES_DROPPED,
+	JOURNAL_OPEN_FAILED,
+	JOURNAL_WRITE_FAILED,
+	JOURNAL_TAIL_DISCARDED,
+	JOURNAL_REPLAYED,
+	JOURNAL_ROTATE_FAILED,
+	SNAPSHOT_SAVED,
+	SNAPSHOT_SAVE_FAILED,
+	SNAPSHOT_LOADED,
+	SNAPSHOT_INVALID,
+	SNAPSHOT_CONFIG_CHANGED,
+	SNAPSHOT_JSON_NEWER,
+	STATE_JSON_SAVED,
+	ZONE_BATCH_DONE,
+	SENSOR_EVENTS_DROPPED,
+	SENSOR_UNKNOWN_ZONES,
+	SENSOR_DEBOUNCE_SET,
+	EXIT_DELAY_STARTED,
+	EXIT_DELAY_CANCELLED,
+	EXIT_DELAY_ARMED,
+	EXIT_DELAY_NOT_READY,
+	ENTRY_DELAY_STARTED,
+	ENTRY_DELAY_EXPIRED,
+	SIREN_TIMEOUT,
+	DELAY_SET,
+	SYNTHETIC_SITE_CREATED,
+	TRACE_DUMP_FAILED,
+	TRACE_DUMP_WRITTEN,
+	COUNT
+};
+
+constexpr std::array<std::string_view, static_cast<size_t>(LogFormat::COUNT)> kLogFormats = {
+	"{}",
+	"Zone {} ({}) is already armed.",
+	"Zone {} ({}) is armed.",
+	"Zone {} ({}) cannot be armed because it is bypassed.",
+	"Zone {} ({}) is already disarmed.",
+	"Zone {} ({}) is disarmed.",
+	"Zone {} ({}) is bypassed.",
+	"Zone {} ({}) is unbypassed.",
+	"Zone {} ({}) is tampered!",
+	"Zone {} ({}) tamper cleared.",
+	"Zone {} ({}) is faulted!",
+	"Zone {} ({}) fault cleared.",
+	"Zone {} ({}) is active.",
+	"Zone {} ({}) is inactive.",
+	"ALARM on Zone {} ({})!",
+	"Initialized 2 dummy partitions.",
+	"Initializing zones from zones.csv",
+	"Failed to open zones.csv",
+	"{} lines of zones.csv skipped: {}",
+	"{} zones in zones.csv loaded with problems: {}",
+	"{} zones initialized from {} lines in {} ms ({} chunks).",
+	"Arm failed: Zone {} not found.",
+	"Arm request: Zone {} already armed.",
+	"Arm failed: Zone {} is bypassed.",
+	"Disarm failed: Zone {} not found.",
+	"Disarm request: Zone {} already disarmed.",
+	"Bypass failed: Zone {} not found.",
+	"Trigger failed {} not found.",
+	"Trigger ignored: Zone {} is bypassed.",
+	"Trigger ignored: Zone {} is disarmed.",
+	"ALARM TRIGGERED on Zone {}",
+	"Listing all zones: ",
+	"All zones listed",
+	"No zones available to list.",
+	"Listing chosen zone:",
+	"ListOneZone: Zone {} not found.",
+	"Chosen zone listed",
+	"Listing armed zones:",
+	"Listing bypassed zones:",
+	"Listing disarmed zones:",
+	"Listing alarming zones:",
+	"Listing zones matching filter: {}",
+	"All {} zones listed",
+	"Listed {} zones and {} partitions changed since sequence {}",
+	"{}: invalid filter '{}': {}",
+	"Duplicate partition id {} ignored.",
+	"Duplicate zone id {} ignored.",
+	"Could not save state to zone_state.txt",
+	"Zone states saved successfully to zone_state.txt",
+	"No saved state found (zone_state.txt)",
+	"Corrupt data in state file.",
+	"Previous zone states loaded from zone_state.txt",
+	"Could not save state to system_state.json",
+	"No saved JSON state found (system_state.json). Using default states.",
+	"Partition data loaded from JSON backup.",
+	"Zone data loaded from JSON backup.",
+	"Zone {} found in backup but not in CSV. Skipping.",
+	"JSON parse error while loading state: {}",
+	"Exception while loading JSON state: {}",
+	"Request to ARM Partition: {}",
+	"ArmPartition failed: Partition {} does not exist.",
+	"Partition {} already armed.",
+	"Zone {} is bypassed. Ignoring status checks.",
+	"Arming Partition {} failed due to active/faulted zones.",
+	"Request to DISARM Partition: {}",
+	"Client connected from {}",
+	"Client disconnected.",
+	"Received message: {}",
+	"Response sent: {}",
+	"Sent list: All Zones",
+	"{} log messages dropped (queue full)",
+	"Could not open the state journal {}",
+	"Writing the state journal {} failed",
+	"Discarded {} bytes of a torn record at the end of {}",
+	"Replayed {} state changes from {}",
+	"Rotating the state journal {} failed",
+	"Snapshot of {} zones saved: {} bytes, state copied in {} us, written in {} ms",
+	"Could not save the snapshot to {}",
+	"Loaded {} zones from {} in {} ms",
+	"Ignoring snapshot {}: {}",
+	"{} changed since the last snapshot; reloading zones and keeping their saved state",
+	"{} is newer than the snapshot; importing it",
+	"System state exported to {}",
+	"Batch {}: {} zones, {} applied, {} lock stripes held",
+	"Sensor queue full: {} events dropped",
+	"Sensor events for {} unknown zones ignored (first: zone {})",
+	"Sensor debounce set to {} ms for {}",
+	"Partition {} arming: exit delay {} ms",
+	"Partition {} arming cancelled",
+	"Exit delay over: partition {} armed with {} zones",
+	"Exit delay over: partition {} not ready, left disarmed",
+	"Zone {} entry delay started: {} ms",
+	"Entry delay of zone {} expired: ALARM",
+	"Siren timeout: zone {} alarm silenced",
+	"{} set to {} ms for {} of {} ids",
+	"Synthetic site created: {} zones in {} partitions",
+	"Failed to write trace dump {}",
+	"Wrote {} trace events to {}",
+};
+
+constexpr size_t LogFormatArgCount(LogFormat format)
+{
+	std::string_view text = kLogFormats[static_cast<size_t>(format)];
+	size_t count = 0;
+	for (size_t i = 0; i + 1 < text.size(); i++) {
+		if (text[i] == '{' && text[i + 1] == '}') count++;
+	}
+	return count;
+}
@@ -1,38 +1,102 @@
 #pragma once
 #include "Logger.h"
+#include <chrono>
+#include <cstdlib>
+#include "MpscRingBuffer.h"
+#include "Tracer.h"
 
 std::mutex Logger::logMutex;
 std::ofstream Logger::logFile;
 bool Logger::consolOutput = true;
+std::atomic<LogOverflowPolicy> Logger::overflowPolicy{ LogOverflowPolicy::DROP };
+std::atomic<int> Logger::minLevelRank{ HIK_LOG_MIN_LEVEL };
+LogFileFormat Logger::fileFormat = LogFileFormat::TEXT;
+std::atomic<bool> Logger::writerRunning{ false };
+std::atomic<bool> Logger::writerIdle{ false };
+std::atomic<bool> Logger::stopRequested{ false };
+std::atomic<uint64_t> Logger::droppedCount{ 0 };
+std::atomic<uint64_t> Logger::droppedTotal{ 0 };
+std::thread Logger::writerThread;
+std::mutex Logger::wakeMutex;
+std::condition_variable Logger::wakeCondition;
 
-void Logger::Init(const std::string& filename, bool consolOut) {
+namespace {
+	constexpr size_t kQueueCapacity = 16384;
+	// Longest the writer sleeps before looking at the queue again
+	constexpr auto kFlushInterval = std::chrono::milliseconds(20);
+	// Write out a batch early once it grows past this size
+	constexpr size_t kMaxBatchBytes = 256 * 1024;
+
+	MpscRingBuffer<LogRecord>& Queue() {
+		static MpscRingBuffer<LogRecord> queue(kQueueCapacity);
+		return queue;
+	}
+	std::once_flag writerStarted;
+	// Last formatted timestamp; namespace scope so it outlives the atexit flush
+	std::time_t cachedTime = -1;
+	std::string cachedText;
+}
+
+void Logger::Init(const std::string& filename, bool consolOut, LogFileFormat format) {
 	std::lock_guard<std::mutex> lock(logMutex);
 	consolOutput = consolOut;
+	fileFormat = format;
 
-	logFile.open(filename, std::ios::app);
+	if (format == LogFileFormat::BINARY) {
+		logFile.open(filename, std::ios::app | std::ios::binary);
+	}
+	else {
+		logFile.open(filename, std::ios::app);
+	}
 	if (!logFile.is_open()) {
 		std::cerr << "[CRITICAL] Failed to open log file: " << filename << std::endl;
+		return;
+	}
+	if (format == LogFileFormat::BINARY) {
+		// Session header: the catalog that the following format ids refer to
+		std::string header;
+		LogEncoding::PutU32(header, LogEncoding::kMagic);
+		LogEncoding::PutU16(header, LogEncoding::kVersion);
+		LogEncoding::PutU16(header, static_cast<uint16_t>(kLogFormats.size()));
+		for (std::string_view text : kLogFormats) {
+			LogEncoding::PutU16(header, static_cast<uint16_t>(text.size()));
+			header.append(text.data(), text.size());
+		}
+		std::string chunk(1, LogEncoding::kHeaderChunk);
+		LogEncoding::PutU32(chunk, static_cast<uint32_t>(header.size()));
+		chunk += header;
+		logFile.write(chunk.data(), chunk.size());
+		logFile.flush();
 	}
 }
-std::string Logger::GetCurrentTime() {
-
-	auto now = std::time(nullptr);
-	std::tm tmNow;
-	localtime_s(&tmNow, &now);
-	std::ostringstream oss;
-	oss << std::put_time(&tmNow, "%Y-%m-%d %H:%M:%S");
-	return oss.str();
+void Logger::SetOverflowPolicy(LogOverflowPolicy policy) {
+	overflowPolicy = policy;
 }
-void Logger::LogInternal(LogLevel level, const std::string& message) {
-	std::lock_guard<std::mutex> lock(logMutex);
-	std::string levelStr;
-	std::string colorCode = "";
-	std::string resetColor = "\033[0m";
-
-	switch (level) {
+void Logger::SetMinLevel(LogLevel level) {
+	minLevelRank.store(LogLevelRank(level), std::memory_order_relaxed);
+}
+// Timestamps only change once a second, so the formatted text is cached.
+// Caller holds logMutex.
+const std::string& Logger::FormatTime(std::time_t time) {
+	if (time != cachedTime) {
+		std::tm tmNow;
+#ifdef _WIN32
+		localtime_s(&tmNow, &time);
+#else
+		localtime_r(&time, &tmNow);
+#endif
+		char buffer[32];
+		size_t length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tmNow);
+		cachedText.assign(buffer, length);
+		cachedTime = time;
+	}
+	return cachedText;
+}
+void Logger::FormatRecord(const LogRecord& record, std::string& fileBatch, std::string& consoleBatch) {
+	const char* levelStr = "INFO";
+	const char* colorCode = "\033[32m"; // Green
+	switch (record.level) {
 	case LogLevel::INFO:
-		levelStr = "INFO";
-		colorCode = "\033[32m"; // Green
 		break;
 	case LogLevel::WARNING:
 		levelStr = "WARNING";
@@ -47,15 +111,174 @@ void Logger::LogInternal(LogLevel level, const std::string& message) {
 		colorCode = "\033[34m"; // Blue
 		break;
 	}
-	std::string timeStamp = GetCurrentTime();
-	std::string finalLog = "[" + timeStamp + "] [" + levelStr + "] " + message;
-	if (logFile.is_open()) {
-		logFile << finalLog << std::endl;
+	size_t lineStart = fileBatch.size();
+	fileBatch += '[';
+	fileBatch += FormatTime(record.time);
+	fileBatch += "] [";
+	fileBatch += levelStr;
+	fileBatch += "] ";
+	if (!LogEncoding::Render(kLogFormats[static_cast<size_t>(record.format)], record.arguments.View(), fileBatch)) {
+		fileBatch += "<malformed log arguments>";
+	}
+	fileBatch += '\n';
+
+	if (consolOutput) {
+		consoleBatch += colorCode;
+		consoleBatch.append(fileBatch, lineStart, fileBatch.size() - lineStart - 1);
+		consoleBatch += "\033[0m\n";
+	}
+}
+// Append the record as an 'R' chunk without rendering it
+void Logger::EncodeRecord(const LogRecord& record, std::string& fileBatch) {
+	std::string_view arguments = record.arguments.View();
+	fileBatch += LogEncoding::kRecordChunk;
+	LogEncoding::PutU32(fileBatch, static_cast<uint32_t>(LogEncoding::kRecordHeaderSize + arguments.size()));
+	fileBatch += static_cast<char>(record.level);
+	LogEncoding::PutU64(fileBatch, static_cast<uint64_t>(record.time));
+	LogEncoding::PutU16(fileBatch, static_cast<uint16_t>(record.format));
+	fileBatch.append(arguments.data(), arguments.size());
+}
+// Text files get a rendered line; binary files get the raw record and the
+// console, if enabled, still shows text. Caller holds logMutex.
+void Logger::WriteRecord(const LogRecord& record, std::string& fileBatch, std::string& consoleBatch) {
+	if (fileFormat == LogFileFormat::TEXT) {
+		FormatRecord(record, fileBatch, consoleBatch);
+		return;
 	}
+	EncodeRecord(record, fileBatch);
 	if (consolOutput) {
-		std::cout << colorCode << finalLog << resetColor << std::endl;
+		std::string line;
+		FormatRecord(record, line, consoleBatch);
 	}
 }
+// One write and one flush per batch instead of per line. Caller holds logMutex.
+void Logger::WriteBatches(std::string& fileBatch, std::string& consoleBatch) {
+	if (fileBatch.empty() && consoleBatch.empty()) return;
+	HIK_TRACE_SCOPE("log", "write");
+	if (!fileBatch.empty() && logFile.is_open()) {
+		logFile.write(fileBatch.data(), fileBatch.size());
+		logFile.flush();
+	}
+	if (!consoleBatch.empty()) {
+		std::cout.write(consoleBatch.data(), consoleBatch.size());
+		std::cout.flush();
+	}
+	fileBatch.clear();
+	consoleBatch.clear();
+}
+void Logger::WriterLoop() {
+	Tracer::NameThread("log-writer");
+	auto& queue = Queue();
+	std::string fileBatch;
+	std::string consoleBatch;
+	LogRecord record;
+
+	while (true) {
+		bool stopping = stopRequested.load(std::memory_order_acquire);
+		{
+			std::lock_guard<std::mutex> lock(logMutex);
+			while (queue.TryPop(record)) {
+				WriteRecord(record, fileBatch, consoleBatch);
+				if (fileBatch.size() >= kMaxBatchBytes) WriteBatches(fileBatch, consoleBatch);
+			}
+			uint64_t dropped = droppedCount.exchange(0, std::memory_order_relaxed);
+			if (dropped > 0) {
+				LogRecord notice;
+				notice.level = LogLevel::WARNING;
+				notice.time = std::time(nullptr);
+				notice.format = LogFormat::LOG_MESSAGES_DROPPED;
+				LogEncoding::EncodeArgument(notice.arguments, dropped);
+				WriteRecord(notice, fileBatch, consoleBatch);
+			}
+			WriteBatches(fileBatch, consoleBatch);
+		}
+		// The queue was drained after the stop flag was seen, so nothing is left
+		if (stopping) break;
+
+		std::unique_lock<std::mutex> wakeLock(wakeMutex);
+		writerIdle.store(true, std::memory_order_release);
+		wakeCondition.wait_for(wakeLock, kFlushInterval);
+		writerIdle.store(false, std::memory_order_relaxed);
+	}
+}
+void Logger::StartWriter() {
+	// Construct the queue before registering the exit hook, so it is
+	// destroyed only after Shutdown() has drained it
+	Queue();
+	writerRunning = true;
+	writerThread = std::thread(&Logger::WriterLoop);
+	// Flush whatever is still queued when the process exits normally
+	std::atexit(&Logger::Shutdown);
+}
+void Logger::Shutdown() {
+	if (!writerRunning.exchange(false)) return;
+	stopRequested.store(true, std::memory_order_release);
+	wakeCondition.notify_one();
+	if (writerThread.joinable()) writerThread.join();
+
+	// Records pushed while the writer was exiting
+	WriteInline(nullptr);
+}
+// Write whatever is still queued, then record if given, on the calling
+// thread; used once the writer has stopped
+void Logger::WriteInline(const LogRecord* record) {
+	std::lock_guard<std::mutex> lock(logMutex);
+	std::string fileBatch;
+	std::string consoleBatch;
+	LogRecord queued;
+	while (Queue().TryPop(queued)) {
+		WriteRecord(queued, fileBatch, consoleBatch);
+	}
+	if (record != nullptr) WriteRecord(*record, fileBatch, consoleBatch);
+	WriteBatches(fileBatch, consoleBatch);
+}
+size_t Logger::QueueDepth() {
+	return Queue().ApproximateSize();
+}
+void Logger::Enqueue(LogRecord& record) {
+	HIK_TRACE_SCOPE("log", "enqueue");
+	if (!stopRequested.load(std::memory_order_relaxed)) {
+		std::call_once(writerStarted, &Logger::StartWriter);
+	}
+
+	if (writerRunning.load(std::memory_order_acquire)) {
+		auto& queue = Queue();
+		bool pushed = queue.TryPush(record);
+		while (!pushed) {
+			// Nothing drains a full queue once Shutdown has stopped the writer
+			if (!writerRunning.load(std::memory_order_acquire)) break;
+			if (overflowPolicy.load(std::memory_order_relaxed) == LogOverflowPolicy::DROP) {
+				droppedCount.fetch_add(1, std::memory_order_relaxed);
+				droppedTotal.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			wakeCondition.notify_one();
+			std::this_thread::yield();
+			pushed = queue.TryPush(record);
+		}
+		if (pushed) {
+			// Pairs with the exchange in Shutdown: either the writer is still
+			// running, or its final drain may have missed this record
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (writerRunning.load(std::memory_order_relaxed)) {
+				if (writerIdle.load(std::memory_order_acquire)) wakeCondition.notify_one();
+				return;
+			}
+			WriteInline(nullptr);
+			return;
+		}
+	}
+	// Writer stopped: write inline, after anything still queued
+	WriteInline(&record);
+}
+void Logger::LogInternal(LogLevel level, const std::string& message) {
+	if (!IsEnabled(level)) return;
+	LogRecord record;
+	record.level = level;
+	record.time = std::time(nullptr);
+	LogEncoding::EncodeArgument(record.arguments, message);
+	Enqueue(record);
+}
 void Logger::Info(const std::string& message) {
 	LogInternal(LogLevel::INFO, message);
 }
@@ -68,4 +291,3 @@ void Logger::Error(const std::string& message) {
 void Logger::Network(const std::string& message) {
 	LogInternal(LogLevel::NETWORK, message);
 }
-
@@ -4,8 +4,18 @@
 #include <iostream>
 #include <mutex>
 #include <ctime>
-#include <iomanip>
-#include <sstream>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <cstring>
+#include "LogEncoding.h"
+#include "LogFormats.h"
+
+// Levels below this are compiled out of structured Logger::Log calls.
+// 0 keeps everything, 1 drops NETWORK, 2 keeps WARNING and ERROR, 3 ERROR only.
+#ifndef HIK_LOG_MIN_LEVEL
+#define HIK_LOG_MIN_LEVEL 0
+#endif
 
 enum class LogLevel {
 	INFO,
@@ -14,18 +24,134 @@ enum class LogLevel {
 	NETWORK
 };
 
+// Verbosity order used for filtering: NETWORK < INFO < WARNING < ERROR
+constexpr int LogLevelRank(LogLevel level) {
+	switch (level) {
+	case LogLevel::NETWORK: return 0;
+	case LogLevel::INFO: return 1;
+	case LogLevel::WARNING: return 2;
+	default: return 3;
+	}
+}
+
+enum class LogFileFormat {
+	TEXT,	// "[time] [LEVEL] message" lines
+	BINARY	// LogEncoding chunks; turn back into text with Tools/LogDecoder
+};
+
+// What a producer does when the log queue is full
+enum class LogOverflowPolicy {
+	DROP,	// discard the message and count it; the writer reports the total
+	BLOCK	// wait for the writer to make room
+};
+
+// Encoded arguments of one record. Typical messages (an id and a zone
+// name) fit inline, so queueing them does not allocate.
+struct LogArguments {
+	static constexpr size_t kInlineCapacity = 64;
+	char inlineData[kInlineCapacity];
+	uint32_t length = 0;
+	std::string overflow; // holds everything once inlineData is outgrown
+
+	void Append(const char* data, size_t size) {
+		if (overflow.empty() && length + size <= kInlineCapacity) {
+			std::memcpy(inlineData + length, data, size);
+		}
+		else {
+			if (overflow.empty()) overflow.assign(inlineData, length);
+			overflow.append(data, size);
+		}
+		length += static_cast<uint32_t>(size);
+	}
+	std::string_view View() const {
+		return std::string_view(overflow.empty() ? inlineData : overflow.data(), length);
+	}
+};
+
+// Format id plus raw arguments; text is only produced by the writer thread.
+// Plain string messages use LogFormat::TEXT with the message as its argument.
+struct LogRecord {
+	LogLevel level = LogLevel::INFO;
+	std::time_t time = 0;
+	LogFormat format = LogFormat::TEXT;
+	LogArguments arguments;
+};
+
+// Callers only enqueue a LogRecord into a lock-free ring; a background writer
+// thread formats and writes whole batches to the file and console, so logging
+// no longer serializes worker threads or flushes per line.
+// The writer starts with the first message; after Shutdown() records are
+// written inline again.
+//
+// Hot call sites use the structured form, e.g.
+//   Logger::Info<LogFormat::ZONE_ARMED>(id, name);
+// which checks the level before touching its arguments and never builds the
+// message string on the calling thread.
 class Logger {
 private:
 	static std::mutex logMutex;
 	static std::ofstream logFile;
 	static bool consolOutput;
-	static std::string GetCurrentTime();
+	static std::atomic<LogOverflowPolicy> overflowPolicy;
+	static std::atomic<int> minLevelRank;
+	static LogFileFormat fileFormat;
+	static std::atomic<bool> writerRunning;
+	static std::atomic<bool> writerIdle;
+	static std::atomic<bool> stopRequested;
+	static std::atomic<uint64_t> droppedCount;
+	static std::atomic<uint64_t> droppedTotal;
+	static std::thread writerThread;
+	static std::mutex wakeMutex;
+	static std::condition_variable wakeCondition;
+
+	static const std::string& FormatTime(std::time_t time);
+	static void FormatRecord(const LogRecord& record, std::string& fileBatch, std::string& consoleBatch);
+	static void EncodeRecord(const LogRecord& record, std::string& fileBatch);
+	static void WriteRecord(const LogRecord& record, std::string& fileBatch, std::string& consoleBatch);
+	static void WriteBatches(std::string& fileBatch, std::string& consoleBatch);
+	static void WriterLoop();
+	static void StartWriter();
+	static void Enqueue(LogRecord& record);
+	static void WriteInline(const LogRecord* record);
 	static void LogInternal(LogLevel level, const std::string& message);
 
 public:
-	static void Init(const std::string& filename, bool consoleOutput = true);
+	static void Init(const std::string& filename, bool consoleOutput = true, LogFileFormat format = LogFileFormat::TEXT);
+	static void SetOverflowPolicy(LogOverflowPolicy policy);
+	// Runtime filter on top of HIK_LOG_MIN_LEVEL
+	static void SetMinLevel(LogLevel level);
+	static bool IsEnabled(LogLevel level) {
+		return LogLevelRank(level) >= minLevelRank.load(std::memory_order_relaxed);
+	}
+	// Drain everything queued and stop the writer thread
+	static void Shutdown();
+	// Records waiting for the writer, and all records dropped since start
+	static size_t QueueDepth();
+	static uint64_t DroppedTotal() { return droppedTotal.load(std::memory_order_relaxed); }
 	static void Info(const std::string& message);
 	static void Warning(const std::string& message);
 	static void Error(const std::string& message);
 	static void Network(const std::string& message);
-};
\ No newline at end of file
+
+	template <LogLevel Level, LogFormat Format, typename... Args>
+	static void Log(const Args&... args) {
+		static_assert(sizeof...(Args) == LogFormatArgCount(Format), "argument count does not match the log format");
+		if constexpr (LogLevelRank(Level) >= HIK_LOG_MIN_LEVEL) {
+			if (!IsEnabled(Level)) return;
+			LogRecord record;
+			record.level = Level;
+			record.time = std::time(nullptr);
+			record.format = Format;
+			(LogEncoding::EncodeArgument(record.arguments, args), ...);
+			Enqueue(record);
+		}
+	}
+	template <LogFormat Format, typename... Args>
+	static void Info(const Args&... args) { Log<LogLevel::INFO, Format>(args...); }
+	template <LogFormat Format, typename... Args>
+	static void Warning(const Args&... args) { Log<LogLevel::WARNING, Format>(args...); }
+	template <LogFormat Format, typename... Args>
+	static void Error(const Args&... args) { Log<LogLevel::ERROR_LOG, Format>(args...); }
+	template <LogFormat Format, typename... Args>
+	static void Network(const Args&... args) { Log<LogLevel::NETWORK, Format>(args...); }
+};
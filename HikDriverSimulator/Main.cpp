@@ -1,7 +1,19 @@
+#include <cstdlib>
+#include <string>
 #include "HikDriverApp.h"
+#include "TrafficSimulator.h"
 
-int main() {
-	HikDriverApp app;
+int main(int argc, char* argv[]) {
+	// --simulate <scenario.json> [--report <out.json>] runs a traffic scenario instead of the menu
+	if (argc >= 3 && std::string(argv[1]) == "--simulate") {
+		std::string reportPath;
+		if (argc >= 5 && std::string(argv[3]) == "--report") reportPath = argv[4];
+		return TrafficSimulator::RunFromCommandLine(argv[2], reportPath);
+	}
+	// --metrics-port <port> serves Prometheus metrics over HTTP
+	int metricsPort = 0;
+	if (argc >= 3 && std::string(argv[1]) == "--metrics-port") metricsPort = std::atoi(argv[2]);
+	HikDriverApp app(metricsPort);
 	app.Run();
 	return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file (mmap / MapViewOfFile).
+class MappedFile
+{
+private:
+	const char* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+
+public:
+	MappedFile() = default;
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// False if the file is missing, empty or cannot be mapped
+	bool Open(const std::string& path);
+	void Close();
+	const char* Data() const { return data; }
+	size_t Size() const { return size; }
+};
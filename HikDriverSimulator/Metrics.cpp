@@ -0,0 +1,93 @@
+#include "Metrics.h"
+#include "Logger.h"
+
+std::mutex Metrics::registryMutex;
+std::vector<std::unique_ptr<Metrics::Shard>> Metrics::shards;
+std::vector<Metrics::Shard*> Metrics::freeShards;
+
+Metrics::ShardLease::~ShardLease()
+{
+	if (shard == nullptr) return;
+	std::lock_guard<std::mutex> lock(registryMutex);
+	freeShards.push_back(shard);
+}
+Metrics::Shard& Metrics::Local()
+{
+	thread_local ShardLease lease;
+	if (lease.shard == nullptr) {
+		std::lock_guard<std::mutex> lock(registryMutex);
+		if (!freeShards.empty()) {
+			lease.shard = freeShards.back();
+			freeShards.pop_back();
+		}
+		else {
+			shards.push_back(std::make_unique<Shard>());
+			lease.shard = shards.back().get();
+		}
+	}
+	return *lease.shard;
+}
+void Metrics::RecordCommand(size_t commandSlot, uint64_t nanos, bool failed)
+{
+	Shard& shard = Local();
+	shard.commands[commandSlot].Record(nanos);
+	if (failed) Add(shard.commandErrors[commandSlot], 1);
+}
+void Metrics::RecordPersistence(PersistenceMetric metric, uint64_t nanos)
+{
+	Local().persistence[static_cast<size_t>(metric)].Record(nanos);
+}
+void Metrics::ConnectionAccepted()
+{
+	Add(Local().connectionsAccepted, 1);
+}
+void Metrics::ConnectionClosed()
+{
+	Add(Local().connectionsClosed, 1);
+}
+void Metrics::BytesReceived(uint64_t bytes)
+{
+	Add(Local().bytesReceived, bytes);
+}
+void Metrics::BytesSent(uint64_t bytes)
+{
+	Add(Local().bytesSent, bytes);
+}
+std::unique_ptr<MetricsSnapshot> Metrics::Collect()
+{
+	auto snapshot = std::make_unique<MetricsSnapshot>();
+	{
+		std::lock_guard<std::mutex> lock(registryMutex);
+		for (const auto& shard : shards) {
+			for (size_t i = 0; i < kCommandMetricCount; i++) {
+				shard->commands[i].AddTo(snapshot->commands[i]);
+				snapshot->commandErrors[i] += shard->commandErrors[i].load(std::memory_order_relaxed);
+			}
+			for (size_t i = 0; i < kPersistenceMetricCount; i++) {
+				shard->persistence[i].AddTo(snapshot->persistence[i]);
+			}
+			snapshot->connectionsAccepted += shard->connectionsAccepted.load(std::memory_order_relaxed);
+			snapshot->connectionsClosed += shard->connectionsClosed.load(std::memory_order_relaxed);
+			snapshot->bytesReceived += shard->bytesReceived.load(std::memory_order_relaxed);
+			snapshot->bytesSent += shard->bytesSent.load(std::memory_order_relaxed);
+		}
+	}
+	snapshot->loggerQueueDepth = Logger::QueueDepth();
+	snapshot->loggerDropped = Logger::DroppedTotal();
+	return snapshot;
+}
+std::string_view Metrics::CommandName(size_t commandSlot)
+{
+	if (commandSlot == kBinaryCommandSlot) return "BINARY";
+	return CommandParser::Name(static_cast<TextCommand>(commandSlot));
+}
+std::string_view Metrics::PersistenceName(PersistenceMetric metric)
+{
+	switch (metric) {
+	case PersistenceMetric::JOURNAL_FLUSH: return "journalFlush";
+	case PersistenceMetric::JOURNAL_WAIT: return "journalWait";
+	case PersistenceMetric::SNAPSHOT_COPY: return "snapshotCopy";
+	case PersistenceMetric::SNAPSHOT_WRITE: return "snapshotWrite";
+	default: return "stateJsonSave";
+	}
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+#include "CommandParser.h"
+#include "LatencyHistogram.h"
+
+// Timed persistence steps
+enum class PersistenceMetric : uint8_t {
+	JOURNAL_FLUSH,		// one group-commit write + fsync
+	JOURNAL_WAIT,		// a command batch waiting for its changes to be durable
+	SNAPSHOT_COPY,		// state bits copied under the stripes
+	SNAPSHOT_WRITE,		// snapshot serialized and written
+	STATE_JSON_SAVE
+};
+constexpr size_t kPersistenceMetricCount = 5;
+
+// One slot per TextCommand (UNKNOWN included), plus one for binary requests
+constexpr size_t kCommandMetricCount = static_cast<size_t>(TextCommand::UNKNOWN) + 2;
+constexpr size_t kBinaryCommandSlot = kCommandMetricCount - 1;
+
+// Zone state counts of one partition, gathered when metrics are read
+struct PartitionGauge {
+	int partitionId = 0;
+	size_t zones = 0;
+	size_t armed = 0;
+	size_t alarming = 0;
+	size_t bypassed = 0;
+};
+
+// A LatencyHistogram with a single writer that other threads may read at any
+// time. The owner updates with relaxed loads and stores, never a locked
+// read-modify-write, so recording costs the same as the plain histogram.
+class SharedLatencyHistogram
+{
+public:
+	void Record(uint64_t nanos) {
+		Bump(counts[LatencyHistogram::IndexOf(nanos)], 1);
+		Bump(sum, nanos);
+		if (nanos > max.load(std::memory_order_relaxed)) max.store(nanos, std::memory_order_relaxed);
+	}
+	void AddTo(LatencyHistogram& histogram) const {
+		for (size_t i = 0; i < LatencyHistogram::kBuckets; i++) {
+			uint64_t count = counts[i].load(std::memory_order_relaxed);
+			if (count != 0) histogram.AddBucket(i, count);
+		}
+		histogram.AddTotals(sum.load(std::memory_order_relaxed), max.load(std::memory_order_relaxed));
+	}
+
+private:
+	std::array<std::atomic<uint64_t>, LatencyHistogram::kBuckets> counts{};
+	std::atomic<uint64_t> sum{ 0 };
+	std::atomic<uint64_t> max{ 0 };
+
+	static void Bump(std::atomic<uint64_t>& value, uint64_t by) {
+		value.store(value.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+	}
+};
+
+// Everything Metrics::Collect gathers, merged over all threads
+struct MetricsSnapshot {
+	std::array<LatencyHistogram, kCommandMetricCount> commands;
+	std::array<uint64_t, kCommandMetricCount> commandErrors{};
+	std::array<LatencyHistogram, kPersistenceMetricCount> persistence;
+	uint64_t connectionsAccepted = 0;
+	uint64_t connectionsClosed = 0;
+	uint64_t bytesReceived = 0;
+	uint64_t bytesSent = 0;
+	size_t loggerQueueDepth = 0;
+	uint64_t loggerDropped = 0;
+	// Filled in by the caller, from AlarmService::PartitionGauges
+	std::vector<PartitionGauge> partitions;
+};
+
+// Process-wide counters and latency histograms. Every thread records into
+// its own shard, so instrumentation never contends; Collect sums the
+// shards. A shard outlives its thread and is handed to the next new thread,
+// so nothing recorded is lost.
+class Metrics
+{
+public:
+	static void RecordCommand(size_t commandSlot, uint64_t nanos, bool failed);
+	static void RecordPersistence(PersistenceMetric metric, uint64_t nanos);
+	static void ConnectionAccepted();
+	static void ConnectionClosed();
+	static void BytesReceived(uint64_t bytes);
+	static void BytesSent(uint64_t bytes);
+
+	// Heap-allocated: the histograms take a few hundred KiB
+	static std::unique_ptr<MetricsSnapshot> Collect();
+
+	static size_t CommandSlot(TextCommand command) { return static_cast<size_t>(command); }
+	static std::string_view CommandName(size_t commandSlot);
+	static std::string_view PersistenceName(PersistenceMetric metric);
+
+private:
+	struct Shard {
+		std::array<SharedLatencyHistogram, kCommandMetricCount> commands;
+		std::array<std::atomic<uint64_t>, kCommandMetricCount> commandErrors{};
+		std::array<SharedLatencyHistogram, kPersistenceMetricCount> persistence;
+		std::atomic<uint64_t> connectionsAccepted{ 0 };
+		std::atomic<uint64_t> connectionsClosed{ 0 };
+		std::atomic<uint64_t> bytesReceived{ 0 };
+		std::atomic<uint64_t> bytesSent{ 0 };
+	};
+	// Holds the calling thread's shard; gives it back when the thread exits
+	struct ShardLease {
+		Shard* shard = nullptr;
+		~ShardLease();
+	};
+
+	static std::mutex registryMutex;
+	static std::vector<std::unique_ptr<Shard>> shards;
+	static std::vector<Shard*> freeShards;
+
+	static Shard& Local();
+	static void Add(std::atomic<uint64_t>& counter, uint64_t by) {
+		counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+	}
+};
@@ -0,0 +1,233 @@
+#include "MetricsExporter.h"
+#include <cstdio>
+#include <string_view>
+#include <vector>
+#include "Logger.h"
+
+namespace {
+	constexpr double kSummaryQuantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+
+	void AppendNumber(std::string& out, double value)
+	{
+		char text[32];
+		int length = std::snprintf(text, sizeof(text), "%.9g", value);
+		out.append(text, static_cast<size_t>(length));
+	}
+	void AppendHeader(std::string& out, std::string_view name, std::string_view type, std::string_view help)
+	{
+		out += "# HELP ";
+		out += name;
+		out += ' ';
+		out += help;
+		out += "\n# TYPE ";
+		out += name;
+		out += ' ';
+		out += type;
+		out += '\n';
+	}
+	void AppendSample(std::string& out, std::string_view name, std::string_view labels, double value)
+	{
+		out += name;
+		if (!labels.empty()) {
+			out += '{';
+			out += labels;
+			out += '}';
+		}
+		out += ' ';
+		AppendNumber(out, value);
+		out += '\n';
+	}
+	// One summary series: quantiles, _sum and _count, all in seconds
+	void AppendSummary(std::string& out, std::string_view name, const std::string& labels, const LatencyHistogram& latency)
+	{
+		for (double quantile : kSummaryQuantiles) {
+			std::string quantileLabels = labels + ",quantile=\"";
+			AppendNumber(quantileLabels, quantile);
+			quantileLabels += '"';
+			AppendSample(out, name, quantileLabels, static_cast<double>(latency.Percentile(quantile * 100.0)) / 1e9);
+		}
+		AppendSample(out, std::string(name) + "_sum", labels, static_cast<double>(latency.Sum()) / 1e9);
+		AppendSample(out, std::string(name) + "_count", labels, static_cast<double>(latency.Count()));
+	}
+	std::string HttpResponse(std::string_view status, std::string_view contentType, std::string_view body)
+	{
+		std::string out = "HTTP/1.1 ";
+		out += status;
+		out += "\r\nContent-Type: ";
+		out += contentType;
+		out += "\r\nContent-Length: ";
+		out += std::to_string(body.size());
+		out += "\r\nConnection: close\r\n\r\n";
+		out += body;
+		return out;
+	}
+}
+
+MetricsExporter::MetricsExporter(int port, AlarmService* alarmService)
+	: port(port), alarmService(alarmService), listener(kInvalidSocket), isRunning(false)
+{
+}
+MetricsExporter::~MetricsExporter() {
+	Stop();
+}
+bool MetricsExporter::Start() {
+	if (!SocketApi::Startup()) {
+		return false;
+	}
+	std::string error;
+	listener = SocketApi::CreateListener(port, error);
+	if (listener == kInvalidSocket) {
+		Logger::Error("Metrics exporter: " + error);
+		SocketApi::Cleanup();
+		return false;
+	}
+	poller = Poller::Create();
+	if (!poller->Add(listener, POLL_READABLE)) {
+		Logger::Error("Metrics exporter: failed to register listening socket with the poller");
+		SocketApi::Close(listener);
+		SocketApi::Cleanup();
+		return false;
+	}
+	isRunning = true;
+	thread = std::thread(&MetricsExporter::Serve, this);
+	Logger::Info("Metrics exporter listening on port " + std::to_string(port));
+	return true;
+}
+void MetricsExporter::Stop() {
+	if (!isRunning) return;
+	isRunning = false;
+	poller->Wakeup();
+	if (thread.joinable()) thread.join();
+
+	while (!scrapes.empty()) Close(scrapes.begin()->first);
+	SocketApi::Close(listener);
+	listener = kInvalidSocket;
+	SocketApi::Cleanup();
+}
+void MetricsExporter::Serve() {
+	std::vector<PollResult> ready;
+	while (isRunning) {
+		poller->Wait(ready, -1);
+		for (const PollResult& result : ready) {
+			if (result.socket == listener) {
+				AcceptScrapers();
+				continue;
+			}
+			auto it = scrapes.find(result.socket);
+			if (it == scrapes.end()) continue;
+			if (it->second.response.empty()) HandleReadable(result.socket, it->second);
+			else FlushResponse(result.socket, it->second);
+		}
+	}
+}
+void MetricsExporter::AcceptScrapers() {
+	while (true) {
+		std::string peerAddress;
+		SocketHandle socket = SocketApi::Accept(listener, peerAddress);
+		if (socket == kInvalidSocket) return;
+		if (!SocketApi::SetNonBlocking(socket) || !poller->Add(socket, POLL_READABLE)) {
+			SocketApi::Close(socket);
+			continue;
+		}
+		scrapes[socket] = Scrape();
+	}
+}
+// Read until the end of the request head, then answer and close
+void MetricsExporter::HandleReadable(SocketHandle socket, Scrape& scrape) {
+	char chunk[2048];
+	while (true) {
+		int received = SocketApi::Receive(socket, chunk, sizeof(chunk));
+		if (received > 0) {
+			scrape.request.append(chunk, received);
+			if (scrape.request.size() > kMaxRequestSize) {
+				Close(socket);
+				return;
+			}
+			continue;
+		}
+		if (received == SocketApi::kWouldBlock) break;
+		// A scraper may half-close after sending its request
+		if (received == 0 && scrape.request.find("\r\n\r\n") != std::string::npos) break;
+		Close(socket);
+		return;
+	}
+	if (scrape.request.find("\r\n\r\n") == std::string::npos) return;
+
+	scrape.response = BuildResponse(scrape.request);
+	if (FlushResponse(socket, scrape)) poller->Modify(socket, POLL_WRITABLE);
+}
+// False once the socket is closed
+bool MetricsExporter::FlushResponse(SocketHandle socket, Scrape& scrape) {
+	while (scrape.offset < scrape.response.size()) {
+		int sent = SocketApi::Send(socket, scrape.response.data() + scrape.offset,
+			static_cast<int>(scrape.response.size() - scrape.offset));
+		if (sent == SocketApi::kWouldBlock) return true;
+		if (sent < 0) break;
+		scrape.offset += sent;
+	}
+	Close(socket);
+	return false;
+}
+void MetricsExporter::Close(SocketHandle socket) {
+	poller->Remove(socket);
+	SocketApi::Close(socket);
+	scrapes.erase(socket);
+}
+std::string MetricsExporter::BuildResponse(const std::string& request) {
+	std::string_view requestLine = std::string_view(request).substr(0, request.find("\r\n"));
+	if (requestLine.rfind("GET ", 0) != 0) {
+		return HttpResponse("405 Method Not Allowed", "text/plain", "Only GET is supported\n");
+	}
+	std::string_view target = requestLine.substr(4, requestLine.find(' ', 4) - 4);
+	if (target != "/metrics") {
+		return HttpResponse("404 Not Found", "text/plain", "Metrics are served at /metrics\n");
+	}
+	auto snapshot = Metrics::Collect();
+	snapshot->partitions = alarmService->PartitionGauges();
+	std::string body;
+	WritePrometheus(body, *snapshot);
+	return HttpResponse("200 OK", "text/plain; version=0.0.4", body);
+}
+void MetricsExporter::WritePrometheus(std::string& out, const MetricsSnapshot& metrics) {
+	AppendHeader(out, "hik_command_duration_seconds", "summary", "Time to execute a command on a worker, before the journal sync.");
+	for (size_t slot = 0; slot < kCommandMetricCount; slot++) {
+		if (metrics.commands[slot].Count() == 0) continue;
+		std::string labels = "command=\"" + std::string(Metrics::CommandName(slot)) + "\"";
+		AppendSummary(out, "hik_command_duration_seconds", labels, metrics.commands[slot]);
+	}
+	AppendHeader(out, "hik_command_errors_total", "counter", "Commands answered with an error.");
+	for (size_t slot = 0; slot < kCommandMetricCount; slot++) {
+		if (metrics.commands[slot].Count() == 0) continue;
+		std::string labels = "command=\"" + std::string(Metrics::CommandName(slot)) + "\"";
+		AppendSample(out, "hik_command_errors_total", labels, static_cast<double>(metrics.commandErrors[slot]));
+	}
+
+	AppendHeader(out, "hik_connections_accepted_total", "counter", "Client connections accepted.");
+	AppendSample(out, "hik_connections_accepted_total", "", static_cast<double>(metrics.connectionsAccepted));
+	AppendHeader(out, "hik_connections_open", "gauge", "Client connections currently open.");
+	AppendSample(out, "hik_connections_open", "", static_cast<double>(metrics.connectionsAccepted - metrics.connectionsClosed));
+	AppendHeader(out, "hik_network_received_bytes_total", "counter", "Bytes read from clients.");
+	AppendSample(out, "hik_network_received_bytes_total", "", static_cast<double>(metrics.bytesReceived));
+	AppendHeader(out, "hik_network_sent_bytes_total", "counter", "Bytes written to clients.");
+	AppendSample(out, "hik_network_sent_bytes_total", "", static_cast<double>(metrics.bytesSent));
+
+	AppendHeader(out, "hik_logger_queue_depth", "gauge", "Log records waiting for the writer thread.");
+	AppendSample(out, "hik_logger_queue_depth", "", static_cast<double>(metrics.loggerQueueDepth));
+	AppendHeader(out, "hik_logger_dropped_total", "counter", "Log records dropped because the queue was full.");
+	AppendSample(out, "hik_logger_dropped_total", "", static_cast<double>(metrics.loggerDropped));
+
+	AppendHeader(out, "hik_partition_zones", "gauge", "Zones per partition, in total and by state.");
+	for (const auto& gauge : metrics.partitions) {
+		std::string partition = "partition=\"" + std::to_string(gauge.partitionId) + "\",state=";
+		AppendSample(out, "hik_partition_zones", partition + "\"total\"", static_cast<double>(gauge.zones));
+		AppendSample(out, "hik_partition_zones", partition + "\"armed\"", static_cast<double>(gauge.armed));
+		AppendSample(out, "hik_partition_zones", partition + "\"alarming\"", static_cast<double>(gauge.alarming));
+		AppendSample(out, "hik_partition_zones", partition + "\"bypassed\"", static_cast<double>(gauge.bypassed));
+	}
+
+	AppendHeader(out, "hik_persistence_duration_seconds", "summary", "Journal and snapshot timings.");
+	for (size_t i = 0; i < kPersistenceMetricCount; i++) {
+		std::string labels = "operation=\"" + std::string(Metrics::PersistenceName(static_cast<PersistenceMetric>(i))) + "\"";
+		AppendSummary(out, "hik_persistence_duration_seconds", labels, metrics.persistence[i]);
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "SocketApi.h"
+#include "Poller.h"
+#include "AlarmService.h"
+#include "Metrics.h"
+
+// Optional HTTP listener serving GET /metrics in the Prometheus text format,
+// for scrapers that cannot speak the TCP protocol. It runs on its own thread
+// and poller, so a slow scraper never delays commands.
+class MetricsExporter
+{
+public:
+	MetricsExporter(int port, AlarmService* alarmService);
+	~MetricsExporter();
+	bool Start();
+	void Stop();
+
+	// Text exposition format 0.0.4; latencies become summaries in seconds
+	static void WritePrometheus(std::string& out, const MetricsSnapshot& metrics);
+
+private:
+	// Largest accepted request head; scrapes are a single short GET
+	static constexpr size_t kMaxRequestSize = 8 * 1024;
+
+	struct Scrape {
+		std::string request;
+		std::string response;
+		size_t offset = 0;
+	};
+
+	int port;
+	AlarmService* alarmService;
+	SocketHandle listener;
+	std::atomic<bool> isRunning;
+	std::thread thread;
+	std::unique_ptr<Poller> poller;
+	std::unordered_map<SocketHandle, Scrape> scrapes;
+
+	void Serve();
+	void AcceptScrapers();
+	void HandleReadable(SocketHandle socket, Scrape& scrape);
+	bool FlushResponse(SocketHandle socket, Scrape& scrape);
+	void Close(SocketHandle socket);
+	std::string BuildResponse(const std::string& request);
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// Bounded lock-free multi-producer / single-consumer queue.
+// Each cell carries a sequence number that tells producers and the consumer
+// whether it is free or filled, so a push is one CAS on the tail plus one
+// release store, and a pop only stores its own position. Capacity is
+// rounded up to a power of two; TryPush fails instead of blocking when full.
+template <typename T>
+class MpscRingBuffer
+{
+private:
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T value;
+	};
+	std::unique_ptr<Cell[]> cells;
+	size_t mask;
+	// Producers and the consumer write different cache lines
+	alignas(64) std::atomic<size_t> enqueuePos{ 0 };
+	// Atomic only so ApproximateSize can read it; the consumer is its sole writer
+	alignas(64) std::atomic<size_t> dequeuePos{ 0 };
+
+public:
+	explicit MpscRingBuffer(size_t capacity) {
+		size_t size = 2;
+		while (size < capacity) size <<= 1;
+		cells.reset(new Cell[size]);
+		mask = size - 1;
+		for (size_t i = 0; i < size; i++) {
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+	MpscRingBuffer(const MpscRingBuffer&) = delete;
+	MpscRingBuffer& operator=(const MpscRingBuffer&) = delete;
+
+	// Safe from any thread; leaves value untouched when the queue is full
+	bool TryPush(T& value) {
+		size_t pos = enqueuePos.load(std::memory_order_relaxed);
+		Cell* cell;
+		while (true) {
+			cell = &cells[pos & mask];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+			if (difference == 0) {
+				if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+			}
+			else if (difference < 0) {
+				return false;
+			}
+			else {
+				pos = enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+		cell->value = std::move(value);
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+	// Consumer thread only
+	bool TryPop(T& value) {
+		size_t pos = dequeuePos.load(std::memory_order_relaxed);
+		Cell& cell = cells[pos & mask];
+		size_t sequence = cell.sequence.load(std::memory_order_acquire);
+		if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1) < 0) return false;
+
+		value = std::move(cell.value);
+		cell.sequence.store(pos + mask + 1, std::memory_order_release);
+		dequeuePos.store(pos + 1, std::memory_order_relaxed);
+		return true;
+	}
+	size_t Capacity() const { return mask + 1; }
+	// Claimed but not yet popped cells; a snapshot for monitoring, from any thread
+	size_t ApproximateSize() const {
+		size_t dequeued = dequeuePos.load(std::memory_order_relaxed);
+		size_t enqueued = enqueuePos.load(std::memory_order_relaxed);
+		return enqueued > dequeued ? enqueued - dequeued : 0;
+	}
+};
@@ -0,0 +1,240 @@
+#include "Poller.h"
+#include <unordered_map>
+#include "Logger.h"
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#elif !defined(_WIN32)
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+#ifdef __linux__
+
+// epoll backend: level-triggered, one kernel call per Wait regardless of
+// how many sockets are registered.
+class EpollPoller : public Poller
+{
+private:
+	int epollFd;
+	int wakeFd;
+	std::vector<epoll_event> events;
+
+	static uint32_t ToEpoll(uint32_t interest) {
+		uint32_t mask = 0;
+		if (interest & POLL_READABLE) mask |= EPOLLIN | EPOLLRDHUP;
+		if (interest & POLL_WRITABLE) mask |= EPOLLOUT;
+		return mask;
+	}
+
+public:
+	EpollPoller() : events(256) {
+		epollFd = epoll_create1(EPOLL_CLOEXEC);
+		wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+		epoll_event ev{};
+		ev.events = EPOLLIN;
+		ev.data.fd = wakeFd;
+		epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+	}
+	~EpollPoller() override {
+		close(wakeFd);
+		close(epollFd);
+	}
+	bool Add(SocketHandle socket, uint32_t interest) override {
+		epoll_event ev{};
+		ev.events = ToEpoll(interest);
+		ev.data.fd = socket;
+		return epoll_ctl(epollFd, EPOLL_CTL_ADD, socket, &ev) == 0;
+	}
+	bool Modify(SocketHandle socket, uint32_t interest) override {
+		epoll_event ev{};
+		ev.events = ToEpoll(interest);
+		ev.data.fd = socket;
+		return epoll_ctl(epollFd, EPOLL_CTL_MOD, socket, &ev) == 0;
+	}
+	void Remove(SocketHandle socket) override {
+		epoll_ctl(epollFd, EPOLL_CTL_DEL, socket, nullptr);
+	}
+	int Wait(std::vector<PollResult>& results, int timeoutMs) override {
+		results.clear();
+		int count = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), timeoutMs);
+		if (count <= 0) return 0;
+
+		for (int i = 0; i < count; i++) {
+			const epoll_event& ev = events[i];
+			if (ev.data.fd == wakeFd) {
+				uint64_t drained;
+				while (read(wakeFd, &drained, sizeof(drained)) > 0) {}
+				continue;
+			}
+			uint32_t mask = 0;
+			if (ev.events & (EPOLLIN | EPOLLRDHUP)) mask |= POLL_READABLE;
+			if (ev.events & EPOLLOUT) mask |= POLL_WRITABLE;
+			if (ev.events & EPOLLHUP) mask |= POLL_HANGUP;
+			if (ev.events & EPOLLERR) mask |= POLL_ERROR;
+			results.push_back({ ev.data.fd, mask });
+		}
+		// A full batch means more sockets are probably ready; grow for next time
+		if (count == static_cast<int>(events.size())) events.resize(events.size() * 2);
+		return static_cast<int>(results.size());
+	}
+	void Wakeup() override {
+		uint64_t one = 1;
+		ssize_t written = write(wakeFd, &one, sizeof(one));
+		(void)written;
+	}
+};
+
+#else
+
+// Portable poll()/WSAPoll() backend. O(registered sockets) per Wait, which is
+// fine for the few hundred connections a Windows workstation build sees.
+class PollPoller : public Poller
+{
+private:
+	std::vector<pollfd> fds;
+	std::unordered_map<SocketHandle, size_t> slotBySocket;
+	SocketHandle wakeRead;
+	SocketHandle wakeWrite;
+
+	static short ToPoll(uint32_t interest) {
+		short mask = 0;
+		if (interest & POLL_READABLE) mask |= POLLIN;
+		if (interest & POLL_WRITABLE) mask |= POLLOUT;
+		return mask;
+	}
+	bool CreateWakeupPair() {
+#ifdef _WIN32
+		// WSAPoll only waits on sockets, so the wakeup channel is a loopback pair
+		SocketHandle listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		sockaddr_in addr{};
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = 0;
+		int addrLen = sizeof(addr);
+		if (listener == kInvalidSocket
+			|| bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0
+			|| listen(listener, 1) != 0
+			|| getsockname(listener, (sockaddr*)&addr, &addrLen) != 0) {
+			SocketApi::Close(listener);
+			return false;
+		}
+		wakeWrite = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (connect(wakeWrite, (sockaddr*)&addr, sizeof(addr)) != 0) {
+			SocketApi::Close(listener);
+			return false;
+		}
+		wakeRead = accept(listener, nullptr, nullptr);
+		SocketApi::Close(listener);
+		if (wakeRead == kInvalidSocket) return false;
+		SocketApi::SetNoDelay(wakeWrite);
+#else
+		int pipeFds[2];
+		if (pipe(pipeFds) != 0) return false;
+		wakeRead = pipeFds[0];
+		wakeWrite = pipeFds[1];
+#endif
+		SocketApi::SetNonBlocking(wakeRead);
+		SocketApi::SetNonBlocking(wakeWrite);
+		return true;
+	}
+
+public:
+	PollPoller() : wakeRead(kInvalidSocket), wakeWrite(kInvalidSocket) {
+		if (!CreateWakeupPair()) {
+			Logger::Error("Poller: could not create wakeup channel, falling back to timeouts.");
+			return;
+		}
+		Add(wakeRead, POLL_READABLE);
+	}
+	~PollPoller() override {
+#ifdef _WIN32
+		SocketApi::Close(wakeRead);
+		SocketApi::Close(wakeWrite);
+#else
+		close(wakeRead);
+		close(wakeWrite);
+#endif
+	}
+	bool Add(SocketHandle socket, uint32_t interest) override {
+		if (slotBySocket.count(socket)) return false;
+		slotBySocket[socket] = fds.size();
+		pollfd entry{};
+		entry.fd = socket;
+		entry.events = ToPoll(interest);
+		fds.push_back(entry);
+		return true;
+	}
+	bool Modify(SocketHandle socket, uint32_t interest) override {
+		auto it = slotBySocket.find(socket);
+		if (it == slotBySocket.end()) return false;
+		fds[it->second].events = ToPoll(interest);
+		return true;
+	}
+	void Remove(SocketHandle socket) override {
+		auto it = slotBySocket.find(socket);
+		if (it == slotBySocket.end()) return;
+		size_t slot = it->second;
+		slotBySocket.erase(it);
+		if (slot != fds.size() - 1) {
+			fds[slot] = fds.back();
+			slotBySocket[fds[slot].fd] = slot;
+		}
+		fds.pop_back();
+	}
+	int Wait(std::vector<PollResult>& results, int timeoutMs) override {
+		results.clear();
+#ifdef _WIN32
+		int count = WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), timeoutMs);
+#else
+		int count = poll(fds.data(), fds.size(), timeoutMs);
+#endif
+		if (count <= 0) return 0;
+
+		for (const pollfd& entry : fds) {
+			if (entry.revents == 0) continue;
+			if (entry.fd == wakeRead) {
+				char drain[64];
+#ifdef _WIN32
+				while (recv(wakeRead, drain, sizeof(drain), 0) > 0) {}
+#else
+				while (read(wakeRead, drain, sizeof(drain)) > 0) {}
+#endif
+				continue;
+			}
+			uint32_t mask = 0;
+			if (entry.revents & POLLIN) mask |= POLL_READABLE;
+			if (entry.revents & POLLOUT) mask |= POLL_WRITABLE;
+			// WSAPoll raises POLLHUP on a plain half-close too
+			if (entry.revents & POLLHUP) mask |= POLL_HANGUP;
+			if (entry.revents & (POLLERR | POLLNVAL)) mask |= POLL_ERROR;
+			results.push_back({ static_cast<SocketHandle>(entry.fd), mask });
+		}
+		return static_cast<int>(results.size());
+	}
+	void Wakeup() override {
+		if (wakeWrite == kInvalidSocket) return;
+		char one = 1;
+#ifdef _WIN32
+		send(wakeWrite, &one, 1, 0);
+#else
+		ssize_t written = write(wakeWrite, &one, 1);
+		(void)written;
+#endif
+	}
+};
+
+#endif
+
+std::unique_ptr<Poller> Poller::Create()
+{
+#ifdef __linux__
+	return std::make_unique<EpollPoller>();
+#else
+	return std::make_unique<PollPoller>();
+#endif
+}
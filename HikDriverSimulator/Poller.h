@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "SocketApi.h"
+
+enum PollEvent : uint32_t {
+	POLL_READABLE = 1,
+	POLL_WRITABLE = 2,
+	// The peer closed; data sent before that may still be waiting to be read
+	POLL_HANGUP = 4,
+	POLL_ERROR = 8
+};
+
+struct PollResult {
+	SocketHandle socket;
+	uint32_t events;
+};
+
+// Readiness notification backend for the TCP reactor.
+// Linux uses epoll (O(ready) per wait, scales to many thousands of sockets),
+// Windows and other platforms fall back to WSAPoll / poll.
+class Poller
+{
+public:
+	static std::unique_ptr<Poller> Create();
+	virtual ~Poller() {}
+
+	virtual bool Add(SocketHandle socket, uint32_t interest) = 0;
+	virtual bool Modify(SocketHandle socket, uint32_t interest) = 0;
+	virtual void Remove(SocketHandle socket) = 0;
+
+	// Blocks until at least one socket is ready, Wakeup() is called or the
+	// timeout (ms, -1 = infinite) expires. Returns the number of results.
+	virtual int Wait(std::vector<PollResult>& results, int timeoutMs) = 0;
+
+	// Interrupt a concurrent Wait() from any thread.
+	virtual void Wakeup() = 0;
+};
@@ -0,0 +1,239 @@
+#include "ResponseWriter.h"
+#include "CommandResult.h"
+#include <algorithm>
+#include <utility>
+
+namespace {
+	// Typical responses fit without regrowing the buffer
+	constexpr size_t kResponseReserve = 128;
+}
+
+void ResponseWriter::WriteResponse(std::string& out, std::string_view status, std::string_view message, int id, std::string_view state)
+{
+	JsonWriter writer(out);
+	writer.BeginObject();
+	if (id != -1) writer.Field("id", id);
+	writer.Field("message", message);
+	if (!state.empty()) writer.Field("newState", state);
+	writer.Field("status", status);
+	writer.EndObject();
+}
+std::string ResponseWriter::Response(std::string_view status, std::string_view message, int id, std::string_view state)
+{
+	std::string out;
+	out.reserve(kResponseReserve + message.size());
+	WriteResponse(out, status, message, id, state);
+	return out;
+}
+void ResponseWriter::WriteZone(JsonWriter& writer, Zone& zone, std::string_view status)
+{
+	writer.BeginObject();
+	writer.Field("active", zone.isActive);
+	writer.Field("alarming", zone.isAlarming);
+	writer.Field("armed", zone.isArmed);
+	writer.Field("bypassed", zone.isBypassed);
+	writer.Field("faulted", zone.isFaulted);
+	writer.Field("id", zone.id);
+	writer.Field("name", zone.name);
+	writer.Field("partitionId", zone.partitionId);
+	if (!status.empty()) writer.Field("status", status);
+	writer.Field("tampered", zone.isTampered);
+	writer.Field("type", zone.GetType());
+	writer.EndObject();
+}
+void ResponseWriter::WriteZoneState(JsonWriter& writer, Zone& zone, uint16_t stateBits)
+{
+	writer.BeginObject();
+	writer.Field("active", (stateBits & ZONE_ACTIVE) != 0);
+	writer.Field("alarming", (stateBits & ZONE_ALARMING) != 0);
+	writer.Field("armed", (stateBits & ZONE_ARMED) != 0);
+	writer.Field("bypassed", (stateBits & ZONE_BYPASSED) != 0);
+	writer.Field("faulted", (stateBits & ZONE_FAULTED) != 0);
+	writer.Field("id", zone.id);
+	writer.Field("name", zone.name);
+	writer.Field("partitionId", zone.partitionId);
+	writer.Field("tampered", (stateBits & ZONE_TAMPERED) != 0);
+	writer.Field("type", zone.GetType());
+	writer.EndObject();
+}
+void ResponseWriter::WriteEvent(std::string& out, const StateEvent& event)
+{
+	static constexpr std::pair<uint16_t, std::string_view> kChangeNames[] = {
+		{ ZONE_ARMED, "ARMED" }, { ZONE_BYPASSED, "BYPASSED" }, { ZONE_ALARMING, "ALARMING" },
+		{ ZONE_ACTIVE, "ACTIVE" }, { ZONE_TAMPERED, "TAMPERED" }, { ZONE_FAULTED, "FAULTED" },
+	};
+	JsonWriter writer(out);
+	writer.BeginObject();
+	if (event.kind == StateEventKind::ZONE) {
+		writer.Field("active", (event.flags & ZONE_ACTIVE) != 0);
+		writer.Field("alarming", (event.flags & ZONE_ALARMING) != 0);
+	}
+	writer.Field("armed", (event.flags & ZONE_ARMED) != 0);
+	if (event.kind == StateEventKind::ZONE) {
+		writer.Field("bypassed", (event.flags & ZONE_BYPASSED) != 0);
+	}
+	writer.Key("changes");
+	writer.BeginArray();
+	for (const auto& [flag, name] : kChangeNames) {
+		if (event.changed & flag) writer.String(name);
+	}
+	writer.EndArray();
+	if (event.kind == StateEventKind::PARTITION) {
+		writer.Field("event", "PARTITION");
+		writer.Field("id", event.id);
+		writer.Field("sequence", static_cast<int64_t>(event.sequence));
+	}
+	else {
+		writer.Field("event", "ZONE");
+		writer.Field("faulted", (event.flags & ZONE_FAULTED) != 0);
+		writer.Field("id", event.id);
+		writer.Field("partitionId", event.partitionId);
+		writer.Field("sequence", static_cast<int64_t>(event.sequence));
+		writer.Field("tampered", (event.flags & ZONE_TAMPERED) != 0);
+	}
+	writer.EndObject();
+}
+void ResponseWriter::WriteEventsDropped(std::string& out, size_t dropped)
+{
+	JsonWriter writer(out);
+	writer.BeginObject();
+	writer.Field("dropped", static_cast<int64_t>(dropped));
+	writer.Field("event", "OVERFLOW");
+	writer.Field("message", "Events were dropped, re-read the state to resynchronize");
+	writer.EndObject();
+}
+void ResponseWriter::WriteBatch(std::string& out, std::string_view command, const std::vector<CommandResult>& results)
+{
+	// Per-status counts, keyed in the sorted order of the status names
+	constexpr CommandStatus kSummaryOrder[] = { CommandStatus::ALARM, CommandStatus::FAILURE,
+		CommandStatus::IGNORED, CommandStatus::INFO, CommandStatus::SUCCESS };
+	int64_t counts[5] = {};
+
+	out.reserve(out.size() + kResponseReserve + results.size() * 48);
+	JsonWriter writer(out);
+	writer.BeginObject();
+	writer.Field("command", command);
+	writer.Field("count", static_cast<int64_t>(results.size()));
+	writer.Key("results");
+	writer.BeginArray();
+	for (const auto& result : results) {
+		counts[static_cast<size_t>(result.status)]++;
+		writer.BeginObject();
+		writer.Field("id", result.id);
+		// Successful results are fully described by their new state
+		if (result.status != CommandStatus::SUCCESS && result.status != CommandStatus::ALARM) {
+			writer.Field("message", result.message);
+		}
+		if (!result.state.empty()) writer.Field("newState", result.state);
+		writer.Field("status", CommandStatusName(result.status));
+		writer.EndObject();
+	}
+	writer.EndArray();
+	writer.Field("status", CommandStatusName(BatchStatus(results)));
+	writer.Key("summary");
+	writer.BeginObject();
+	for (CommandStatus status : kSummaryOrder) {
+		int64_t count = counts[static_cast<size_t>(status)];
+		if (count > 0) writer.Field(CommandStatusName(status), count);
+	}
+	writer.EndObject();
+	writer.EndObject();
+}
+void ResponseWriter::WriteTimerStats(std::string& out, const TimerStats& stats)
+{
+	JsonWriter writer(out);
+	writer.BeginObject();
+	writer.Field("fired", static_cast<int64_t>(stats.fired));
+	writer.Field("lastLagMicros", static_cast<int64_t>(stats.lastLagMicros));
+	writer.Key("levels");
+	writer.BeginArray();
+	for (size_t count : stats.levels) {
+		writer.Int(static_cast<int64_t>(count));
+	}
+	writer.EndArray();
+	writer.Field("maxLagMicros", static_cast<int64_t>(stats.maxLagMicros));
+	writer.Field("pending", static_cast<int64_t>(stats.pending));
+	writer.Field("status", "SUCCESS");
+	writer.Field("tickMs", static_cast<int64_t>(stats.tickMs));
+	writer.EndObject();
+}
+namespace {
+	void WriteLatencyFields(JsonWriter& writer, const LatencyHistogram& latency)
+	{
+		writer.Field("maxNs", static_cast<int64_t>(latency.Max()));
+		writer.Field("meanNs", static_cast<int64_t>(latency.Mean()));
+		writer.Field("p50Ns", static_cast<int64_t>(latency.Percentile(50.0)));
+		writer.Field("p999Ns", static_cast<int64_t>(latency.Percentile(99.9)));
+		writer.Field("p99Ns", static_cast<int64_t>(latency.Percentile(99.0)));
+	}
+}
+void ResponseWriter::WriteMetrics(std::string& out, const MetricsSnapshot& metrics)
+{
+	// Only commands that ran, by name
+	std::vector<size_t> slots;
+	for (size_t slot = 0; slot < kCommandMetricCount; slot++) {
+		if (metrics.commands[slot].Count() > 0) slots.push_back(slot);
+	}
+	std::sort(slots.begin(), slots.end(),
+		[](size_t a, size_t b) { return Metrics::CommandName(a) < Metrics::CommandName(b); });
+
+	JsonWriter writer(out);
+	writer.BeginObject();
+	writer.Key("commands");
+	writer.BeginObject();
+	for (size_t slot : slots) {
+		writer.Key(Metrics::CommandName(slot));
+		writer.BeginObject();
+		writer.Field("count", static_cast<int64_t>(metrics.commands[slot].Count()));
+		writer.Field("errors", static_cast<int64_t>(metrics.commandErrors[slot]));
+		WriteLatencyFields(writer, metrics.commands[slot]);
+		writer.EndObject();
+	}
+	writer.EndObject();
+	writer.Key("connections");
+	writer.BeginObject();
+	writer.Field("accepted", static_cast<int64_t>(metrics.connectionsAccepted));
+	writer.Field("bytesReceived", static_cast<int64_t>(metrics.bytesReceived));
+	writer.Field("bytesSent", static_cast<int64_t>(metrics.bytesSent));
+	writer.Field("open", static_cast<int64_t>(metrics.connectionsAccepted - metrics.connectionsClosed));
+	writer.EndObject();
+	writer.Key("logger");
+	writer.BeginObject();
+	writer.Field("dropped", static_cast<int64_t>(metrics.loggerDropped));
+	writer.Field("queueDepth", static_cast<int64_t>(metrics.loggerQueueDepth));
+	writer.EndObject();
+	writer.Key("partitions");
+	writer.BeginArray();
+	for (const auto& gauge : metrics.partitions) {
+		writer.BeginObject();
+		writer.Field("alarming", static_cast<int64_t>(gauge.alarming));
+		writer.Field("armed", static_cast<int64_t>(gauge.armed));
+		writer.Field("bypassed", static_cast<int64_t>(gauge.bypassed));
+		writer.Field("id", gauge.partitionId);
+		writer.Field("zones", static_cast<int64_t>(gauge.zones));
+		writer.EndObject();
+	}
+	writer.EndArray();
+	// PersistenceMetric order is alphabetical by name
+	writer.Key("persistence");
+	writer.BeginObject();
+	for (size_t i = 0; i < kPersistenceMetricCount; i++) {
+		writer.Key(Metrics::PersistenceName(static_cast<PersistenceMetric>(i)));
+		writer.BeginObject();
+		writer.Field("count", static_cast<int64_t>(metrics.persistence[i].Count()));
+		WriteLatencyFields(writer, metrics.persistence[i]);
+		writer.EndObject();
+	}
+	writer.EndObject();
+	writer.Field("status", "SUCCESS");
+	writer.EndObject();
+}
+void ResponseWriter::WriteZoneFault(JsonWriter& writer, int id, std::string_view name, bool bypassed, std::string_view reason)
+{
+	writer.BeginObject();
+	writer.Field("bypassed", bypassed);
+	writer.Field("id", id);
+	writer.Field("name", name);
+	writer.Field("reason", reason);
+	writer.EndObject();
+}
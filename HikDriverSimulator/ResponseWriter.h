@@ -0,0 +1,49 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include "JsonWriter.h"
+#include "Zone.h"
+#include "EventHub.h"
+#include "CommandResult.h"
+#include "TimerScheduler.h"
+#include "Metrics.h"
+
+// Fixed response shapes written with JsonWriter instead of a json DOM.
+// Each writer emits its keys in the sorted order nlohmann::json uses, so the
+// wire format is unchanged:
+//   response : id?, message, newState?, status
+//   zone     : active, alarming, armed, bypassed, faulted, id, name,
+//              partitionId, status?, tampered, type
+//   fault    : bypassed, id, name, reason
+// WriteZoneState writes the zone shape of system_state.json (no status)
+// from state bits copied earlier instead of the live flags.
+// Pushed subscription events, one JSON object per line:
+//   zone      : active, alarming, armed, bypassed, changes, event, faulted,
+//               id, partitionId, sequence, tampered
+//   partition : armed, changes, event, id, sequence
+//   overflow  : dropped, event, message
+// Batch zone commands answer with one line:
+//   batch     : command, count, results, status, summary
+//   result    : id, message?, newState?, status (message only when the
+//               zone was not changed as asked)
+//   timers    : fired, lastLagMicros, levels, maxLagMicros, pending,
+//               status, tickMs
+//   metrics   : commands, connections, logger, partitions, persistence,
+//               status (latencies as count, errors?, maxNs, meanNs, p50Ns,
+//               p999Ns, p99Ns)
+class ResponseWriter
+{
+public:
+	static void WriteResponse(std::string& out, std::string_view status, std::string_view message, int id = -1, std::string_view state = {});
+	static std::string Response(std::string_view status, std::string_view message, int id = -1, std::string_view state = {});
+
+	static void WriteZone(JsonWriter& writer, Zone& zone, std::string_view status = {});
+	static void WriteZoneState(JsonWriter& writer, Zone& zone, uint16_t stateBits);
+	static void WriteEvent(std::string& out, const StateEvent& event);
+	static void WriteEventsDropped(std::string& out, size_t dropped);
+	static void WriteBatch(std::string& out, std::string_view command, const std::vector<CommandResult>& results);
+	static void WriteTimerStats(std::string& out, const TimerStats& stats);
+	static void WriteMetrics(std::string& out, const MetricsSnapshot& metrics);
+	static void WriteZoneFault(JsonWriter& writer, int id, std::string_view name, bool bypassed, std::string_view reason);
+};
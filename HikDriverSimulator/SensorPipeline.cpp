@@ -0,0 +1,204 @@
+#include "SensorPipeline.h"
+#include "CommandParser.h"
+#include "Logger.h"
+#include "Tracer.h"
+
+namespace {
+	// Events taken off the queue before expired windows are forwarded
+	constexpr size_t kMaxDrain = 4096;
+	// Longest the thread sleeps with nothing pending
+	constexpr auto kIdleWait = std::chrono::milliseconds(100);
+}
+
+SensorPipeline::SensorPipeline()
+	: queue(kQueueCapacity)
+{
+}
+SensorPipeline::~SensorPipeline()
+{
+	Stop();
+}
+void SensorPipeline::Start(ApplyChanges applyChanges)
+{
+	if (running.exchange(true)) return;
+	apply = std::move(applyChanges);
+	stopRequested = false;
+	thread = std::thread(&SensorPipeline::Loop, this);
+}
+void SensorPipeline::Stop()
+{
+	if (!running.exchange(false)) return;
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		stopRequested = true;
+	}
+	wakeCondition.notify_one();
+	if (thread.joinable()) thread.join();
+}
+bool SensorPipeline::Submit(const SensorEvent& event)
+{
+	SensorEvent copy = event;
+	if (!running.load(std::memory_order_acquire) || !queue.TryPush(copy)) {
+		dropped.fetch_add(1, std::memory_order_relaxed);
+		unreportedDrops.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	// Pairs with the idle store in Loop: either the thread sees this count
+	// before it sleeps, or this sees it idle and wakes it
+	received.fetch_add(1);
+	if (idle.load()) {
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		wakeCondition.notify_one();
+	}
+	return true;
+}
+void SensorPipeline::SetDebounce(int zoneId, uint32_t milliseconds)
+{
+	std::lock_guard<std::mutex> lock(configMutex);
+	zoneDebounceMs[zoneId] = milliseconds;
+}
+void SensorPipeline::SetDefaultDebounce(uint32_t milliseconds)
+{
+	std::lock_guard<std::mutex> lock(configMutex);
+	defaultDebounceMs = milliseconds;
+}
+SensorStats SensorPipeline::Stats() const
+{
+	SensorStats stats;
+	stats.received = received.load(std::memory_order_relaxed);
+	stats.dropped = dropped.load(std::memory_order_relaxed);
+	stats.forwarded = forwarded.load(std::memory_order_relaxed);
+	return stats;
+}
+bool SensorPipeline::ParseEvents(std::string_view text, std::vector<SensorEvent>& events)
+{
+	events.clear();
+	while (true) {
+		size_t end = text.find(';');
+		std::string_view item = text.substr(0, end);
+		size_t first = item.find(',');
+		size_t second = first == std::string_view::npos ? first : item.find(',', first + 1);
+		if (second == std::string_view::npos) return false;
+
+		SensorEvent event;
+		int value = 0;
+		if (!CommandParser::ParseId(item.substr(0, first), event.zoneId)
+			|| !ParseInput(item.substr(first + 1, second - first - 1), event.input)
+			|| !CommandParser::ParseId(item.substr(second + 1), value) || (value != 0 && value != 1)) {
+			return false;
+		}
+		event.value = value == 1;
+		events.push_back(event);
+		if (end == std::string_view::npos) return true;
+		text.remove_prefix(end + 1);
+	}
+}
+bool SensorPipeline::ParseInput(std::string_view name, SensorInput& input)
+{
+	if (CommandParser::EqualsIgnoreCase(name, "ACTIVE")) input = SensorInput::ACTIVE;
+	else if (CommandParser::EqualsIgnoreCase(name, "TAMPER")) input = SensorInput::TAMPER;
+	else if (CommandParser::EqualsIgnoreCase(name, "FAULT")) input = SensorInput::FAULT;
+	else return false;
+	return true;
+}
+const char* SensorPipeline::InputName(SensorInput input)
+{
+	switch (input) {
+	case SensorInput::ACTIVE: return "active";
+	case SensorInput::TAMPER: return "tamper";
+	default: return "fault";
+	}
+}
+uint64_t SensorPipeline::KeyOf(int zoneId, SensorInput input)
+{
+	return static_cast<uint64_t>(static_cast<uint32_t>(zoneId)) << 8 | static_cast<uint8_t>(input);
+}
+void SensorPipeline::Loop()
+{
+	Tracer::NameThread("sensor-pipeline");
+	std::vector<SensorEvent> batch;
+	std::vector<SensorEvent> changes;
+	uint64_t consumed = 0;
+	batch.reserve(kMaxDrain);
+
+	while (true) {
+		bool stopping = stopRequested.load(std::memory_order_acquire);
+		batch.clear();
+		SensorEvent event;
+		while (batch.size() < kMaxDrain && queue.TryPop(event)) {
+			batch.push_back(event);
+		}
+		consumed += batch.size();
+
+		auto now = Clock::now();
+		if (!batch.empty()) {
+			std::lock_guard<std::mutex> lock(configMutex);
+			for (const auto& raw : batch) {
+				auto configured = zoneDebounceMs.find(raw.zoneId);
+				uint32_t window = configured != zoneDebounceMs.end() ? configured->second : defaultDebounceMs;
+				Accept(raw, now, std::chrono::milliseconds(window));
+			}
+		}
+		bool drained = batch.size() < kMaxDrain;
+		changes.clear();
+		Expire(now, stopping && drained, changes);
+		if (!changes.empty()) {
+			forwarded.fetch_add(changes.size(), std::memory_order_relaxed);
+			apply(changes);
+		}
+		uint64_t lost = unreportedDrops.exchange(0, std::memory_order_relaxed);
+		if (lost > 0) Logger::Warning<LogFormat::SENSOR_EVENTS_DROPPED>(lost);
+
+		if (!drained) continue;
+		if (stopping) break;
+
+		std::unique_lock<std::mutex> wakeLock(wakeMutex);
+		idle.store(true);
+		auto ready = [&]() { return stopRequested.load() || received.load() != consumed; };
+		if (deadlines.empty()) wakeCondition.wait_for(wakeLock, kIdleWait, ready);
+		else wakeCondition.wait_until(wakeLock, deadlines.top().when, ready);
+		idle.store(false, std::memory_order_relaxed);
+	}
+}
+void SensorPipeline::Accept(const SensorEvent& event, Clock::time_point now, Clock::duration window)
+{
+	uint64_t key = KeyOf(event.zoneId, event.input);
+	auto [it, inserted] = pending.try_emplace(key);
+	Pending& entry = it->second;
+	if (inserted) {
+		entry.zoneId = event.zoneId;
+		entry.input = event.input;
+		entry.window = window;
+		deadlines.push({ now + window, key });
+	}
+	entry.latest = event.value;
+	entry.wasSet = entry.wasSet || event.value;
+}
+// Forward every window that has closed; flushAll closes them all (shutdown)
+void SensorPipeline::Expire(Clock::time_point now, bool flushAll, std::vector<SensorEvent>& changes)
+{
+	while (!deadlines.empty() && (flushAll || deadlines.top().when <= now)) {
+		uint64_t key = deadlines.top().key;
+		deadlines.pop();
+		auto it = pending.find(key);
+		Pending& entry = it->second;
+		SensorEvent change;
+		change.zoneId = entry.zoneId;
+		change.input = entry.input;
+
+		if (entry.wasSet && !entry.latest) {
+			// Set and cleared again inside the window: report the set now and
+			// the clear once it has held for another window
+			change.value = true;
+			changes.push_back(change);
+			if (!flushAll) {
+				entry.wasSet = false;
+				deadlines.push({ now + entry.window, key });
+				continue;
+			}
+		}
+		change.value = entry.latest;
+		changes.push_back(change);
+		pending.erase(it);
+	}
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "MpscRingBuffer.h"
+
+enum class SensorInput : uint8_t {
+	ACTIVE,
+	TAMPER,
+	FAULT
+};
+
+// One raw sensor reading, as reported by the panel
+struct SensorEvent {
+	int zoneId = 0;
+	SensorInput input = SensorInput::ACTIVE;
+	bool value = false;
+};
+
+struct SensorStats {
+	uint64_t received = 0;	// queued events
+	uint64_t dropped = 0;	// rejected because the queue was full
+	uint64_t forwarded = 0;	// debounced changes handed to the apply callback
+};
+
+// Ingests raw sensor events from any thread and hands debounced changes to
+// the apply callback on its own thread, in batches.
+// Debounce: the first event for a zone input opens a window (per zone,
+// default kDefaultDebounceMs). Events inside the window only update the
+// latest value; when it closes, the latest value is forwarded once. A zone
+// that went active, tampered or faulted at any point in the window is
+// forwarded as set, so a short door opening is never lost, and its return
+// to normal follows one window later if it held. Chatter therefore costs at
+// most two changes per window instead of one per event.
+class SensorPipeline
+{
+public:
+	static constexpr size_t kQueueCapacity = 65536;
+	static constexpr uint32_t kDefaultDebounceMs = 50;
+	static constexpr uint32_t kMaxDebounceMs = 60000;
+
+	using ApplyChanges = std::function<void(const std::vector<SensorEvent>& changes)>;
+
+	SensorPipeline();
+	~SensorPipeline();
+	SensorPipeline(const SensorPipeline&) = delete;
+	SensorPipeline& operator=(const SensorPipeline&) = delete;
+
+	void Start(ApplyChanges apply);
+	// Forwards everything still pending before the thread exits
+	void Stop();
+	// Safe from any thread; false when the queue is full and the event is dropped
+	bool Submit(const SensorEvent& event);
+	// Debounce window of a zone; the default applies to zones without their own
+	void SetDebounce(int zoneId, uint32_t milliseconds);
+	void SetDefaultDebounce(uint32_t milliseconds);
+	SensorStats Stats() const;
+
+	// "<zoneId>,<active|tamper|fault>,<0|1>", several separated by ';'
+	static bool ParseEvents(std::string_view text, std::vector<SensorEvent>& events);
+	static bool ParseInput(std::string_view name, SensorInput& input);
+	static const char* InputName(SensorInput input);
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Pending {
+		int zoneId = 0;
+		SensorInput input = SensorInput::ACTIVE;
+		Clock::duration window{ 0 };
+		bool latest = false;
+		bool wasSet = false;	// any event in the window reported the input as set
+	};
+	struct Deadline {
+		Clock::time_point when;
+		uint64_t key;
+		bool operator>(const Deadline& other) const { return when > other.when; }
+	};
+
+	MpscRingBuffer<SensorEvent> queue;
+	ApplyChanges apply;
+	std::thread thread;
+	std::atomic<bool> running{ false };
+	std::atomic<bool> stopRequested{ false };
+	std::atomic<bool> idle{ false };
+	std::mutex wakeMutex;
+	std::condition_variable wakeCondition;
+
+	mutable std::mutex configMutex;
+	std::unordered_map<int, uint32_t> zoneDebounceMs;
+	uint32_t defaultDebounceMs = kDefaultDebounceMs;
+
+	std::atomic<uint64_t> received{ 0 };
+	std::atomic<uint64_t> dropped{ 0 };
+	std::atomic<uint64_t> forwarded{ 0 };
+	std::atomic<uint64_t> unreportedDrops{ 0 };
+
+	// Pipeline thread only. Each pending entry has exactly one deadline queued.
+	std::unordered_map<uint64_t, Pending> pending;
+	std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>> deadlines;
+
+	void Loop();
+	void Accept(const SensorEvent& event, Clock::time_point now, Clock::duration window);
+	void Expire(Clock::time_point now, bool flushAll, std::vector<SensorEvent>& changes);
+	static uint64_t KeyOf(int zoneId, SensorInput input);
+};
@@ -0,0 +1,172 @@
+#include "SocketApi.h"
+#include "Logger.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <netdb.h>
+#endif
+
+bool SocketApi::Startup()
+{
+#ifdef _WIN32
+	WSADATA wsaData;
+	int result = WSAStartup(MAKEWORD(2, 2), &wsaData);
+	if (result != 0) {
+		Logger::Error("WSAStartup failed: " + std::to_string(result));
+		return false;
+	}
+#endif
+	return true;
+}
+void SocketApi::Cleanup()
+{
+#ifdef _WIN32
+	WSACleanup();
+#endif
+}
+SocketHandle SocketApi::CreateListener(int port, std::string& error)
+{
+	SocketHandle listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (listener == kInvalidSocket) {
+		error = "Socket creation failed: " + std::to_string(LastError());
+		return kInvalidSocket;
+	}
+#ifndef _WIN32
+	// Allow quick restarts while old connections sit in TIME_WAIT
+	int reuse = 1;
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#endif
+	// Bind the socket to the specified port
+	sockaddr_in serverAddr{};
+	serverAddr.sin_family = AF_INET;
+	serverAddr.sin_addr.s_addr = INADDR_ANY;
+	serverAddr.sin_port = htons(static_cast<unsigned short>(port));
+
+	if (bind(listener, (sockaddr*)&serverAddr, sizeof(serverAddr)) != 0) {
+		error = "Bind failed: " + std::to_string(LastError());
+		Close(listener);
+		return kInvalidSocket;
+	}
+	if (listen(listener, SOMAXCONN) != 0) {
+		error = "Listen failed: " + std::to_string(LastError());
+		Close(listener);
+		return kInvalidSocket;
+	}
+	if (!SetNonBlocking(listener)) {
+		error = "Could not switch listener to non-blocking mode: " + std::to_string(LastError());
+		Close(listener);
+		return kInvalidSocket;
+	}
+	return listener;
+}
+SocketHandle SocketApi::Accept(SocketHandle listener, std::string& peerAddress)
+{
+	sockaddr_in clientAddr{};
+	socklen_t clientAddrSize = sizeof(clientAddr);
+	SocketHandle clientSocket = accept(listener, (sockaddr*)&clientAddr, &clientAddrSize);
+	if (clientSocket == kInvalidSocket) {
+		return kInvalidSocket;
+	}
+	char clientIp[INET_ADDRSTRLEN] = {};
+	inet_ntop(AF_INET, &(clientAddr.sin_addr), clientIp, INET_ADDRSTRLEN);
+	peerAddress = clientIp;
+	return clientSocket;
+}
+SocketHandle SocketApi::Connect(const std::string& host, int port, std::string& error)
+{
+	addrinfo hints{};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	addrinfo* addresses = nullptr;
+	int result = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses);
+	if (result != 0 || addresses == nullptr) {
+		error = "Cannot resolve " + host + ": " + std::to_string(result);
+		return kInvalidSocket;
+	}
+	SocketHandle connection = socket(addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol);
+	if (connection == kInvalidSocket) {
+		error = "Socket creation failed: " + std::to_string(LastError());
+	}
+	else if (connect(connection, addresses->ai_addr, static_cast<socklen_t>(addresses->ai_addrlen)) != 0) {
+		error = "Connect to " + host + ":" + std::to_string(port) + " failed: " + std::to_string(LastError());
+		Close(connection);
+		connection = kInvalidSocket;
+	}
+	freeaddrinfo(addresses);
+	return connection;
+}
+bool SocketApi::SetNonBlocking(SocketHandle socket)
+{
+#ifdef _WIN32
+	u_long mode = 1;
+	return ioctlsocket(socket, FIONBIO, &mode) == 0;
+#else
+	int flags = fcntl(socket, F_GETFL, 0);
+	if (flags < 0) return false;
+	return fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+void SocketApi::SetNoDelay(SocketHandle socket)
+{
+	int noDelay = 1;
+	setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+}
+void SocketApi::Close(SocketHandle socket)
+{
+	if (socket == kInvalidSocket) return;
+#ifdef _WIN32
+	closesocket(socket);
+#else
+	close(socket);
+#endif
+}
+int SocketApi::Receive(SocketHandle socket, char* buffer, int length)
+{
+	int received = static_cast<int>(recv(socket, buffer, length, 0));
+	if (received >= 0) return received;
+
+	int error = LastError();
+#ifdef _WIN32
+	if (error == WSAEWOULDBLOCK) return kWouldBlock;
+#else
+	if (error == EAGAIN || error == EWOULDBLOCK || error == EINTR) return kWouldBlock;
+#endif
+	return kSocketError;
+}
+int SocketApi::Send(SocketHandle socket, const char* data, int length)
+{
+#ifdef _WIN32
+	int sent = send(socket, data, length, 0);
+#else
+	// MSG_NOSIGNAL: a peer that vanished must not kill the process with SIGPIPE
+	int sent = static_cast<int>(send(socket, data, length, MSG_NOSIGNAL));
+#endif
+	if (sent >= 0) return sent;
+
+	int error = LastError();
+#ifdef _WIN32
+	if (error == WSAEWOULDBLOCK) return kWouldBlock;
+#else
+	if (error == EAGAIN || error == EWOULDBLOCK || error == EINTR) return kWouldBlock;
+#endif
+	return kSocketError;
+}
+bool SocketApi::IsDescriptorLimit(int error)
+{
+#ifdef _WIN32
+	return error == WSAEMFILE || error == WSAENOBUFS;
+#else
+	return error == EMFILE || error == ENFILE || error == ENOBUFS || error == ENOMEM;
+#endif
+}
+int SocketApi::LastError()
+{
+#ifdef _WIN32
+	return WSAGetLastError();
+#else
+	return errno;
+#endif
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+using SocketHandle = SOCKET;
+constexpr SocketHandle kInvalidSocket = INVALID_SOCKET;
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+using SocketHandle = int;
+constexpr SocketHandle kInvalidSocket = -1;
+#endif
+
+// Thin portability layer over WinSock2 and BSD sockets.
+// Everything the network layer needs goes through here so TcpServer and the
+// pollers never touch platform headers or error codes directly.
+class SocketApi
+{
+public:
+	static constexpr int kWouldBlock = -1;
+	static constexpr int kSocketError = -2;
+
+	static bool Startup();
+	static void Cleanup();
+
+	// Create a non-blocking TCP socket bound to the given port and listening.
+	static SocketHandle CreateListener(int port, std::string& error);
+	// Accept one pending connection, kInvalidSocket when the backlog is empty.
+	static SocketHandle Accept(SocketHandle listener, std::string& peerAddress);
+	// Blocking connect to host (name or IPv4 address) and port; client tools only.
+	static SocketHandle Connect(const std::string& host, int port, std::string& error);
+
+	static bool SetNonBlocking(SocketHandle socket);
+	static void SetNoDelay(SocketHandle socket);
+	static void Close(SocketHandle socket);
+
+	// Returns bytes transferred, 0 on orderly shutdown (recv only),
+	// kWouldBlock when the call would block and kSocketError on a hard error.
+	static int Receive(SocketHandle socket, char* buffer, int length);
+	static int Send(SocketHandle socket, const char* data, int length);
+
+	static int LastError();
+	// Whether an accept failed because the process or system ran out of
+	// descriptors or socket buffers
+	static bool IsDescriptorLimit(int error);
+};
@@ -0,0 +1,287 @@
+#include "StateJournal.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+#include <iterator>
+#include "Checksum.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "Tracer.h"
+
+namespace {
+	constexpr size_t kChecksummedBytes = 8;
+
+	void EncodeRecord(const JournalRecord& record, char* out) {
+		uint32_t id = static_cast<uint32_t>(record.id);
+		out[0] = static_cast<char>(record.kind);
+		out[1] = 0;
+		out[2] = static_cast<char>(record.value);
+		out[3] = static_cast<char>(record.value >> 8);
+		for (int i = 0; i < 4; i++) out[4 + i] = static_cast<char>(id >> (8 * i));
+		uint32_t crc = Checksum::Crc32(out, kChecksummedBytes);
+		for (int i = 0; i < 4; i++) out[8 + i] = static_cast<char>(crc >> (8 * i));
+	}
+	uint32_t ReadU32(const char* data) {
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+		return static_cast<uint32_t>(bytes[0])
+			| static_cast<uint32_t>(bytes[1]) << 8
+			| static_cast<uint32_t>(bytes[2]) << 16
+			| static_cast<uint32_t>(bytes[3]) << 24;
+	}
+	bool DecodeRecord(const char* data, JournalRecord& record) {
+		if (ReadU32(data + kChecksummedBytes) != Checksum::Crc32(data, kChecksummedBytes)) return false;
+		uint8_t kind = static_cast<uint8_t>(data[0]);
+		if (kind != static_cast<uint8_t>(JournalRecordKind::ZONE_STATE)
+			&& kind != static_cast<uint8_t>(JournalRecordKind::PARTITION_STATE)) {
+			return false;
+		}
+		record.kind = static_cast<JournalRecordKind>(kind);
+		record.value = static_cast<uint16_t>(static_cast<unsigned char>(data[2]) | static_cast<unsigned char>(data[3]) << 8);
+		record.id = static_cast<int>(ReadU32(data + 4));
+		return true;
+	}
+}
+
+StateJournal::~StateJournal()
+{
+	Close();
+}
+// Apply the intact prefix of one journal file and cut off anything after it
+size_t StateJournal::ReplayFile(const std::string& journalPath, const std::function<void(const JournalRecord&)>& apply)
+{
+	std::ifstream input(journalPath, std::ios::binary);
+	if (!input.is_open()) return 0;
+	std::string data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+	input.close();
+
+	size_t applied = 0;
+	size_t validBytes = 0;
+	JournalRecord record;
+	while (data.size() - validBytes >= kRecordSize && DecodeRecord(data.data() + validBytes, record)) {
+		apply(record);
+		applied++;
+		validBytes += kRecordSize;
+	}
+	if (validBytes < data.size()) {
+		// A crash mid-write leaves a partial record; everything before it is intact
+		Logger::Warning<LogFormat::JOURNAL_TAIL_DISCARDED>(data.size() - validBytes, journalPath);
+		FileHandle handle = FileApi::OpenForAppend(journalPath);
+		if (handle != kInvalidFile) {
+			FileApi::Truncate(handle, validBytes);
+			FileApi::Sync(handle);
+			FileApi::Close(handle);
+		}
+	}
+	return applied;
+}
+size_t StateJournal::Open(const std::string& journalPath, const std::function<void(const JournalRecord&)>& apply)
+{
+	Close();
+	// The rotated file holds the older records
+	size_t replayed = ReplayFile(RotatedPath(journalPath), apply);
+	replayed += ReplayFile(journalPath, apply);
+
+	FileHandle handle = FileApi::OpenForAppend(journalPath);
+	if (handle == kInvalidFile) {
+		Logger::Error<LogFormat::JOURNAL_OPEN_FAILED>(journalPath);
+		return replayed;
+	}
+	std::error_code error;
+	uintmax_t size = std::filesystem::file_size(journalPath, error);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	file = handle;
+	isOpen = true;
+	path = journalPath;
+	pending.clear();
+	recordCount = error ? 0 : static_cast<size_t>(size / kRecordSize);
+	stopping = false;
+	compactionRequested = false;
+	flusherThread = std::thread(&StateJournal::FlusherLoop, this);
+	return replayed;
+}
+void StateJournal::Close()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!isOpen) return;
+		stopping = true;
+	}
+	pendingCondition.notify_one();
+	if (flusherThread.joinable()) flusherThread.join();
+
+	std::lock_guard<std::mutex> fileLock(fileMutex);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		FileApi::Close(file);
+		file = kInvalidFile;
+		isOpen = false;
+		durableSequence = appendedSequence;
+		rotationsCompleted = rotationsRequested;
+	}
+	durableCondition.notify_all();
+}
+bool StateJournal::IsOpen() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return isOpen;
+}
+void StateJournal::SetCompactionHandler(size_t thresholdRecords, std::function<void()> handler)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	compactionThreshold = thresholdRecords;
+	compactionHandler = std::move(handler);
+}
+uint64_t StateJournal::Append(const JournalRecord& record)
+{
+	char bytes[kRecordSize];
+	EncodeRecord(record, bytes);
+
+	bool wasEmpty;
+	uint64_t sequence;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!isOpen) return 0;
+		wasEmpty = pending.empty();
+		pending.append(bytes, kRecordSize);
+		sequence = ++appendedSequence;
+		recordCount++;
+	}
+	if (wasEmpty) pendingCondition.notify_one();
+	return sequence;
+}
+uint64_t StateJournal::LastSequence() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return appendedSequence;
+}
+void StateJournal::WaitDurable(uint64_t sequence)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	durableCondition.wait(lock, [this, sequence] { return durableSequence >= sequence; });
+}
+uint64_t StateJournal::Rotate()
+{
+	uint64_t ticket;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!isOpen) return 0;
+		rotateRequested = true;
+		rotateOffset = pending.size();
+		ticket = ++rotationsRequested;
+		recordCount = 0;
+		compactionRequested = false;
+	}
+	pendingCondition.notify_one();
+	return ticket;
+}
+void StateJournal::DiscardRotated(uint64_t rotation)
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		durableCondition.wait(lock, [this, rotation] { return rotationsCompleted >= rotation; });
+		if (!isOpen) return;
+	}
+	std::lock_guard<std::mutex> fileLock(fileMutex);
+	std::remove(RotatedPath(path).c_str());
+}
+// Caller holds fileMutex
+void StateJournal::WriteBatch(const char* data, size_t length)
+{
+	if (length == 0) return;
+	if (!FileApi::Write(file, data, length) || !FileApi::Sync(file)) {
+		Logger::Error<LogFormat::JOURNAL_WRITE_FAILED>(path);
+	}
+}
+// Move the current file's records to the rotated file and start an empty
+// one. Normally a rename; if the last snapshot failed and an older rotated
+// file is still there, the records are appended to it instead.
+// Caller holds fileMutex.
+bool StateJournal::RotateFile()
+{
+	std::string rotatedPath = RotatedPath(path);
+	FileApi::Close(file);
+	file = kInvalidFile;
+
+	bool rotated;
+	std::error_code error;
+	if (!std::filesystem::exists(rotatedPath, error)) {
+		rotated = FileApi::Rename(path, rotatedPath);
+		file = FileApi::OpenForAppend(path);
+	}
+	else {
+		std::ifstream input(path, std::ios::binary);
+		std::string data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+		input.close();
+		FileHandle older = FileApi::OpenForAppend(rotatedPath);
+		rotated = older != kInvalidFile && FileApi::Write(older, data.data(), data.size()) && FileApi::Sync(older);
+		FileApi::Close(older);
+
+		file = FileApi::OpenForAppend(path);
+		if (rotated && file != kInvalidFile) {
+			rotated = FileApi::Truncate(file, 0) && FileApi::Sync(file);
+		}
+	}
+	return rotated && file != kInvalidFile;
+}
+// Each pass writes everything appended since the previous one with a single
+// write and sync. Appends that arrive during the sync form the next batch.
+void StateJournal::FlusherLoop()
+{
+	Tracer::NameThread("journal-flusher");
+	std::string batch;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			pendingCondition.wait(lock, [this] { return stopping || !pending.empty() || rotateRequested; });
+			if (pending.empty() && !rotateRequested) break;
+		}
+		bool compact = false;
+		{
+			std::lock_guard<std::mutex> fileLock(fileMutex);
+			bool rotate;
+			size_t split;
+			uint64_t rotationTicket;
+			uint64_t batchEnd;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				batch.swap(pending);
+				batchEnd = appendedSequence;
+				rotate = rotateRequested;
+				split = rotateOffset;
+				rotationTicket = rotationsRequested;
+				rotateRequested = false;
+			}
+			auto flushStart = std::chrono::steady_clock::now();
+			{
+				HIK_TRACE_SCOPE("persistence", "journalFlush");
+				if (rotate) {
+					WriteBatch(batch.data(), split);
+					if (!RotateFile()) {
+						Logger::Error<LogFormat::JOURNAL_ROTATE_FAILED>(path);
+					}
+					WriteBatch(batch.data() + split, batch.size() - split);
+				}
+				else {
+					WriteBatch(batch.data(), batch.size());
+				}
+			}
+			if (!batch.empty()) {
+				Metrics::RecordPersistence(PersistenceMetric::JOURNAL_FLUSH,
+					std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - flushStart).count());
+			}
+			batch.clear();
+
+			std::lock_guard<std::mutex> lock(mutex);
+			if (batchEnd > durableSequence) durableSequence = batchEnd;
+			if (rotate) rotationsCompleted = rotationTicket;
+			compact = compactionHandler && !stopping && !compactionRequested && recordCount >= compactionThreshold;
+			if (compact) compactionRequested = true;
+		}
+		durableCondition.notify_all();
+
+		// The handler only schedules a snapshot; it must not wait for one
+		if (compact) compactionHandler();
+	}
+}
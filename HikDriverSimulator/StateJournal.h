@@ -0,0 +1,99 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "FileApi.h"
+
+enum class JournalRecordKind : uint8_t {
+	ZONE_STATE = 1,		// value: ZoneStateBit flags after the change
+	PARTITION_STATE = 2	// value: 1 armed, 0 disarmed
+};
+
+// Every record carries the complete resulting state of one zone or
+// partition, so replaying a record twice (or on top of a newer snapshot)
+// is harmless.
+struct JournalRecord {
+	JournalRecordKind kind = JournalRecordKind::ZONE_STATE;
+	int id = 0;
+	uint16_t value = 0;
+};
+
+// Append-only write-ahead journal of state transitions.
+//
+//   record : u8 kind | u8 reserved | u16 value | u32 id | u32 crc32 of the first 8 bytes
+//
+// Append() only copies the record into a buffer. A flusher thread writes
+// and fsyncs everything buffered in one go, so concurrent commands share a
+// single sync (group commit); WaitDurable() blocks until a record is on
+// disk. Once the journal holds enough records the compaction handler is
+// called on the flusher thread; it should schedule a snapshot.
+//
+// A snapshot calls Rotate() at the instant it copies the state: records
+// appended before that point move to the rotated file (path + ".1"), later
+// ones stay in the current file. Once the snapshot is safely on disk,
+// DiscardRotated() deletes the rotated file. Recovery replays the rotated
+// file, then the current one.
+class StateJournal
+{
+private:
+	// file belongs to whoever holds fileMutex; isOpen is guarded by mutex
+	FileHandle file = kInvalidFile;
+	bool isOpen = false;
+	std::string path;
+	std::string pending;
+	uint64_t appendedSequence = 0;
+	uint64_t durableSequence = 0;
+	size_t recordCount = 0;
+	bool stopping = false;
+	bool compactionRequested = false;
+	// Rotate() marks the end of the covered records as an offset into pending
+	bool rotateRequested = false;
+	size_t rotateOffset = 0;
+	uint64_t rotationsRequested = 0;
+	uint64_t rotationsCompleted = 0;
+	size_t compactionThreshold = 0;
+	std::function<void()> compactionHandler;
+	std::thread flusherThread;
+	// Order: fileMutex before mutex
+	std::mutex fileMutex;
+	mutable std::mutex mutex;
+	std::condition_variable pendingCondition;
+	std::condition_variable durableCondition;
+
+	void FlusherLoop();
+	void WriteBatch(const char* data, size_t length);
+	bool RotateFile();
+	static size_t ReplayFile(const std::string& path, const std::function<void(const JournalRecord&)>& apply);
+
+public:
+	static constexpr size_t kRecordSize = 12;
+
+	StateJournal() = default;
+	~StateJournal();
+	StateJournal(const StateJournal&) = delete;
+	StateJournal& operator=(const StateJournal&) = delete;
+
+	static std::string RotatedPath(const std::string& journalPath) { return journalPath + ".1"; }
+
+	// Apply every intact record of the rotated and current files, in order,
+	// cut off torn tails, then open for appending and start the flusher.
+	// Returns the number of records replayed.
+	size_t Open(const std::string& journalPath, const std::function<void(const JournalRecord&)>& apply);
+	// Flush what is buffered and stop the flusher
+	void Close();
+	bool IsOpen() const;
+	void SetCompactionHandler(size_t thresholdRecords, std::function<void()> handler);
+
+	// Buffer a record; returns its sequence number (0 when the journal is closed)
+	uint64_t Append(const JournalRecord& record);
+	uint64_t LastSequence() const;
+	void WaitDurable(uint64_t sequence);
+	// Split the journal after the last appended record; cheap enough to call
+	// while every stripe is held. Returns a ticket for DiscardRotated().
+	uint64_t Rotate();
+	// Delete the rotated file once a snapshot covers it
+	void DiscardRotated(uint64_t rotation);
+};
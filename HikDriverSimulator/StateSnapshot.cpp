@@ -0,0 +1,147 @@
+#include "StateSnapshot.h"
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include "Checksum.h"
+
+namespace {
+	constexpr size_t kHeaderCrcBytes = offsetof(StateSnapshot::Header, headerCrc);
+
+	template <typename T>
+	void Append(std::string& out, const T& value) {
+		out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+}
+
+void StateSnapshot::Write(std::string& out, const ConfigFingerprint& config,
+	const std::vector<std::shared_ptr<Partition>>& partitions, const std::vector<uint8_t>& partitionStates,
+	const std::vector<std::shared_ptr<Zone>>& zones, const std::vector<uint16_t>& zoneStates)
+{
+	std::string strings;
+	size_t headerStart = out.size();
+	out.append(sizeof(Header), '\0');
+
+	for (size_t slot = 0; slot < partitions.size(); slot++) {
+		PartitionEntry entry{};
+		entry.id = partitions[slot]->id;
+		entry.nameOffset = static_cast<uint32_t>(strings.size());
+		entry.nameLength = static_cast<uint32_t>(partitions[slot]->name.size());
+		entry.armed = partitionStates[slot];
+		strings += partitions[slot]->name;
+		Append(out, entry);
+	}
+	for (size_t slot = 0; slot < zones.size(); slot++) {
+		const Zone& zone = *zones[slot];
+		ZoneEntry entry{};
+		entry.id = zone.id;
+		entry.partitionId = zone.partitionId;
+		entry.nameOffset = static_cast<uint32_t>(strings.size());
+		entry.nameLength = static_cast<uint32_t>(zone.name.size());
+		entry.stateBits = zoneStates[slot];
+		entry.kind = static_cast<uint8_t>(ZoneFactory::KindOf(zone));
+		strings += zone.name;
+		Append(out, entry);
+	}
+	out += strings;
+
+	Header fileHeader{};
+	fileHeader.magic = kMagic;
+	fileHeader.version = kVersion;
+	fileHeader.headerSize = sizeof(Header);
+	fileHeader.partitionCount = static_cast<uint32_t>(partitions.size());
+	fileHeader.zoneCount = static_cast<uint32_t>(zones.size());
+	fileHeader.configSize = config.size;
+	fileHeader.configWriteTime = config.writeTime;
+	fileHeader.stringsSize = strings.size();
+	size_t bodyStart = headerStart + sizeof(Header);
+	fileHeader.bodyCrc = Checksum::Crc32(out.data() + bodyStart, out.size() - bodyStart);
+	fileHeader.headerCrc = Checksum::Crc32(&fileHeader, kHeaderCrcBytes);
+	std::memcpy(&out[headerStart], &fileHeader, sizeof(Header));
+}
+bool StateSnapshot::Validate(const char* data, size_t size, std::string& error)
+{
+	if (size < sizeof(Header)) {
+		error = "file too short";
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(Header));
+	if (header.magic != kMagic) {
+		error = "not a snapshot file";
+		return false;
+	}
+	if (header.version != kVersion || header.headerSize != sizeof(Header)) {
+		error = "unsupported version " + std::to_string(header.version);
+		return false;
+	}
+	if (Checksum::Crc32(&header, kHeaderCrcBytes) != header.headerCrc) {
+		error = "header checksum mismatch";
+		return false;
+	}
+	uint64_t expectedSize = sizeof(Header)
+		+ static_cast<uint64_t>(header.partitionCount) * sizeof(PartitionEntry)
+		+ static_cast<uint64_t>(header.zoneCount) * sizeof(ZoneEntry)
+		+ header.stringsSize;
+	if (expectedSize != size) {
+		error = "size mismatch";
+		return false;
+	}
+	if (Checksum::Crc32(data + sizeof(Header), size - sizeof(Header)) != header.bodyCrc) {
+		error = "body checksum mismatch";
+		return false;
+	}
+	partitionData = data + sizeof(Header);
+	zoneData = partitionData + static_cast<size_t>(header.partitionCount) * sizeof(PartitionEntry);
+	stringData = zoneData + static_cast<size_t>(header.zoneCount) * sizeof(ZoneEntry);
+
+	// Checksums catch damage, not a buggy writer: bound every name reference too
+	for (size_t i = 0; i < header.partitionCount; i++) {
+		PartitionEntry entry = GetPartition(i);
+		if (static_cast<uint64_t>(entry.nameOffset) + entry.nameLength > header.stringsSize) {
+			error = "partition name out of range";
+			return false;
+		}
+	}
+	for (size_t i = 0; i < header.zoneCount; i++) {
+		ZoneEntry entry = GetZone(i);
+		if (static_cast<uint64_t>(entry.nameOffset) + entry.nameLength > header.stringsSize) {
+			error = "zone name out of range";
+			return false;
+		}
+	}
+	return true;
+}
+ConfigFingerprint StateSnapshot::Config() const
+{
+	ConfigFingerprint config;
+	config.size = header.configSize;
+	config.writeTime = header.configWriteTime;
+	return config;
+}
+StateSnapshot::PartitionEntry StateSnapshot::GetPartition(size_t index) const
+{
+	PartitionEntry entry;
+	std::memcpy(&entry, partitionData + index * sizeof(PartitionEntry), sizeof(PartitionEntry));
+	return entry;
+}
+StateSnapshot::ZoneEntry StateSnapshot::GetZone(size_t index) const
+{
+	ZoneEntry entry;
+	std::memcpy(&entry, zoneData + index * sizeof(ZoneEntry), sizeof(ZoneEntry));
+	return entry;
+}
+std::string_view StateSnapshot::Name(uint32_t offset, uint32_t length) const
+{
+	return std::string_view(stringData + offset, length);
+}
+ConfigFingerprint StateSnapshot::FingerprintOf(const std::string& path)
+{
+	ConfigFingerprint config;
+	std::error_code error;
+	auto size = std::filesystem::file_size(path, error);
+	if (error) return config;
+	auto writeTime = std::filesystem::last_write_time(path, error);
+	if (error) return config;
+	config.size = static_cast<uint64_t>(size);
+	config.writeTime = static_cast<int64_t>(writeTime.time_since_epoch().count());
+	return config;
+}
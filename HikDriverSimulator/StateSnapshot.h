@@ -0,0 +1,97 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Partition.h"
+#include "Zone.h"
+#include "ZoneFactory.h"
+
+static_assert(std::endian::native == std::endian::little, "snapshot images are read in place as little-endian");
+
+// Identifies the zones.csv a snapshot was built from
+struct ConfigFingerprint {
+	uint64_t size = 0;
+	int64_t writeTime = 0;
+
+	bool operator==(const ConfigFingerprint& other) const {
+		return size == other.size && writeTime == other.writeTime;
+	}
+};
+
+// Versioned binary image of the whole system state (system_state.snap),
+// laid out so it can be mapped and used without parsing:
+//
+//   header     : 64 bytes, see Header
+//   partitions : partitionCount x PartitionEntry (16 bytes)
+//   zones      : zoneCount x ZoneEntry (24 bytes)
+//   strings    : stringsSize bytes of names, referenced by offset/length
+//
+// headerCrc covers the header up to itself; bodyCrc covers everything
+// after the header. Validate() checks both, every size and every name
+// reference, after which entries are read straight from the mapping.
+class StateSnapshot
+{
+public:
+	static constexpr uint32_t kMagic = 0x53534B48; // "HKSS"
+	static constexpr uint16_t kVersion = 1;
+
+	struct Header {
+		uint32_t magic;
+		uint16_t version;
+		uint16_t headerSize;
+		uint32_t partitionCount;
+		uint32_t zoneCount;
+		uint64_t configSize;
+		int64_t configWriteTime;
+		uint64_t stringsSize;
+		uint32_t bodyCrc;
+		uint32_t headerCrc;
+		uint8_t reserved[16];
+	};
+	struct PartitionEntry {
+		int32_t id;
+		uint32_t nameOffset;
+		uint32_t nameLength;
+		uint8_t armed;
+		uint8_t reserved[3];
+	};
+	struct ZoneEntry {
+		int32_t id;
+		int32_t partitionId;
+		uint32_t nameOffset;
+		uint32_t nameLength;
+		uint16_t stateBits;	// ZoneStateBit flags
+		uint8_t kind;		// ZoneKind
+		uint8_t reserved[5];
+	};
+	static_assert(sizeof(Header) == 64, "snapshot header layout");
+	static_assert(sizeof(PartitionEntry) == 16, "snapshot partition layout");
+	static_assert(sizeof(ZoneEntry) == 24, "snapshot zone layout");
+
+	// Serialize the given objects with the state bits copied at snapshot time
+	static void Write(std::string& out, const ConfigFingerprint& config,
+		const std::vector<std::shared_ptr<Partition>>& partitions, const std::vector<uint8_t>& partitionStates,
+		const std::vector<std::shared_ptr<Zone>>& zones, const std::vector<uint16_t>& zoneStates);
+
+	// Check an image in place. On success the accessors read from data,
+	// which must stay mapped while they are used.
+	bool Validate(const char* data, size_t size, std::string& error);
+
+	ConfigFingerprint Config() const;
+	uint32_t PartitionCount() const { return header.partitionCount; }
+	uint32_t ZoneCount() const { return header.zoneCount; }
+	PartitionEntry GetPartition(size_t index) const;
+	ZoneEntry GetZone(size_t index) const;
+	std::string_view Name(uint32_t offset, uint32_t length) const;
+
+	static ConfigFingerprint FingerprintOf(const std::string& path);
+
+private:
+	Header header{};
+	const char* partitionData = nullptr;
+	const char* zoneData = nullptr;
+	const char* stringData = nullptr;
+};
@@ -2,63 +2,72 @@
 #include <ranges>
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <string>
-#include <ws2tcpip.h>
 #include "Logger.h"
-#include <nlohmann/json.hpp>
+#include "ResponseWriter.h"
+#include "CommandParser.h"
+#include "Metrics.h"
+#include "Tracer.h"
 
+namespace {
+	void RecordCommandMetric(size_t commandSlot, std::chrono::steady_clock::time_point started, bool failed)
+	{
+		auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started);
+		Metrics::RecordCommand(commandSlot, static_cast<uint64_t>(elapsed.count()), failed);
+	}
+	CommandReply SuccessReply(std::string text)
+	{
+		return CommandReply(std::move(text), CommandStatus::SUCCESS);
+	}
+	CommandReply FailureReply(std::string_view message)
+	{
+		return CommandReply(ResponseWriter::Response("ERROR", message), CommandStatus::FAILURE);
+	}
+	CommandReply ResultReply(AlarmService& alarmService, const CommandResult& result)
+	{
+		return CommandReply(alarmService.ToJson(result), result.status);
+	}
+}
 
-TcpServer::TcpServer(int port) : port(port), serverSocket(INVALID_SOCKET), isRunning(false)
+TcpServer::TcpServer(int port) : port(port), serverSocket(kInvalidSocket), isRunning(false), alarmService(nullptr), nextConnectionId(1)
 {
 }
 
-TcpServer::TcpServer(int port, AlarmService* alarmService) : port(port), alarmService(alarmService), serverSocket(INVALID_SOCKET), isRunning(false)
+TcpServer::TcpServer(int port, AlarmService* alarmService) : port(port), alarmService(alarmService), serverSocket(kInvalidSocket), isRunning(false), nextConnectionId(1)
 {
 }
 
 TcpServer::~TcpServer() {
 	Stop();
 }
-// Initialize Winsock and start the server
+// Initialize the socket layer, the worker pool and the reactor thread
 bool TcpServer::Start() {
-	WSADATA wsaData;
-	int result = WSAStartup(MAKEWORD(2, 2), &wsaData);
-
-	if (result != 0) {
-		Logger::Error("WSAStartup failed: " + std::to_string(result));
-		return false;
-	}
-	// Create a TCP socket
-	serverSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-	if (serverSocket == INVALID_SOCKET) {
-		Logger::Error("Socket creation failed: " + std::to_string(WSAGetLastError()));
-		WSACleanup();
+	if (!SocketApi::Startup()) {
 		return false;
 	}
-	// Bind the socket to the specified port
-	sockaddr_in serverAddr;
-	serverAddr.sin_family = AF_INET;
-	serverAddr.sin_addr.s_addr = INADDR_ANY;
-	serverAddr.sin_port = htons(port);
-
-	if (bind(serverSocket, (sockaddr*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
-		Logger::Error("Bind failed: " + std::to_string(WSAGetLastError()));
-		closesocket(serverSocket);
-		WSACleanup();
+	std::string error;
+	serverSocket = SocketApi::CreateListener(port, error);
+	if (serverSocket == kInvalidSocket) {
+		Logger::Error(error);
+		SocketApi::Cleanup();
 		return false;
 	}
-	// Start listening for incoming connections
-	if (listen(serverSocket, SOMAXCONN) == SOCKET_ERROR) {
-		Logger::Error("Listen failed: " + std::to_string(WSAGetLastError()));
-		closesocket(serverSocket);
-		WSACleanup();
+	poller = Poller::Create();
+	if (!poller->Add(serverSocket, POLL_READABLE)) {
+		Logger::Error("Failed to register listening socket with the poller");
+		SocketApi::Close(serverSocket);
+		SocketApi::Cleanup();
 		return false;
 	}
+	size_t workerCount = std::max(2u, std::thread::hardware_concurrency());
+	workerPool.Start(workerCount);
+
 	isRunning = true;
-	Logger::Network("TCP Server started on port " + std::to_string(port));
+	Logger::Network("TCP Server started on port " + std::to_string(port) + " with " + std::to_string(workerCount) + " workers");
 
-	// Start the client listening thread
-	std::thread(&TcpServer::ListenForClients, this).detach();
+	// Start the event loop thread
+	serverThread = std::thread(&TcpServer::ListenForClients, this);
 
 	return true;
 }
@@ -66,136 +75,698 @@ bool TcpServer::Start() {
 void TcpServer::Stop() {
 	if (isRunning) {
 		isRunning = false;
-		closesocket(serverSocket);
-		WSACleanup();
+		poller->Wakeup();
 
 		if (serverThread.joinable()) {
 			serverThread.join();
 		}
+		// Workers may still wake the poller, so they stop before it goes away
+		workerPool.Stop();
+		// Drops the subscriptions too, whose callbacks point back here
+		while (!connections.empty()) CloseConnection(connections.begin()->first);
+		SocketApi::Close(serverSocket);
+		serverSocket = kInvalidSocket;
+		SocketApi::Cleanup();
 		Logger::Network("TCP Server stopped.");
 	}
 }
-// Listen for incoming client connections
+// Reactor loop: multiplex the listener and every client socket on one thread.
+// Sockets are non-blocking, so a slow client never stalls the others.
 void TcpServer::ListenForClients() {
+	Tracer::NameThread("tcp-reactor");
+	std::vector<PollResult> ready;
+
+	int timeoutMs = -1;
 	while (isRunning) {
-		sockaddr_in clientAddr;
-		int clientAddrSize = sizeof(clientAddr);
-		SOCKET clientSocket = accept(serverSocket, (sockaddr*)&clientAddr, &clientAddrSize);
+		poller->Wait(ready, timeoutMs);
+		timeoutMs = ResumeAcceptingIfDue();
+
+		for (const PollResult& result : ready) {
+			if (result.socket == serverSocket) {
+				AcceptClients();
+				if (acceptPaused) timeoutMs = static_cast<int>(kAcceptBackoff.count());
+				continue;
+			}
+			auto it = connections.find(result.socket);
+			if (it == connections.end()) continue;
+			ClientConnection& connection = *it->second;
 
-		if (clientSocket == INVALID_SOCKET) {
-			if (isRunning) {
-				Logger::Error("Accept failed: " + std::to_string(WSAGetLastError()));
+			if (result.events & POLL_ERROR) {
+				CloseConnection(connection.socket);
+				continue;
 			}
+			// Read what the client sent before hanging up; its commands are
+			// still answered while the socket can take the replies
+			if (result.events & POLL_HANGUP) connection.hungUp = true;
+
+			if ((result.events & POLL_WRITABLE) && !HandleWritable(connection)) continue;
+			if (result.events & (POLL_READABLE | POLL_HANGUP)) HandleReadable(connection);
+		}
+		DrainCompletions();
+		int flushTimeoutMs = RetryHungUpFlushes();
+		if (flushTimeoutMs >= 0 && (timeoutMs < 0 || flushTimeoutMs < timeoutMs)) timeoutMs = flushTimeoutMs;
+	}
+	while (!connections.empty()) {
+		CloseConnection(connections.begin()->first);
+	}
+}
+// Drain the accept backlog
+void TcpServer::AcceptClients() {
+	HIK_TRACE_SCOPE("net", "accept");
+	while (true) {
+		std::string clientIp;
+		SocketHandle clientSocket = SocketApi::Accept(serverSocket, clientIp);
+		if (clientSocket == kInvalidSocket) {
+			if (SocketApi::IsDescriptorLimit(SocketApi::LastError())) PauseAccepting();
+			return;
+		}
+		if (!SocketApi::SetNonBlocking(clientSocket) || !poller->Add(clientSocket, POLL_READABLE)) {
+			Logger::Error("Failed to register client " + clientIp + ": " + std::to_string(SocketApi::LastError()));
+			SocketApi::Close(clientSocket);
 			continue;
 		}
-		char clientIp[INET_ADDRSTRLEN];
-		inet_ntop(AF_INET, &(clientAddr.sin_addr), clientIp, INET_ADDRSTRLEN);
-		Logger::Network("Client connected from " + std::string(clientIp));
+		SocketApi::SetNoDelay(clientSocket);
+		descriptorLimitReported = false;
+
+		auto connection = std::make_unique<ClientConnection>();
+		connection->socket = clientSocket;
+		connection->connectionId = nextConnectionId++;
+		connection->peerAddress = clientIp;
+		connections[clientSocket] = std::move(connection);
+		Metrics::ConnectionAccepted();
+		Logger::Network<LogFormat::NET_CLIENT_CONNECTED>(clientIp);
+	}
+}
+// Out of descriptors: the connection stays queued and the listener stays
+// readable, so stop watching it for a moment instead of spinning on accept
+void TcpServer::PauseAccepting() {
+	if (acceptPaused) return;
+	if (!descriptorLimitReported) {
+		Logger::Warning("Accept failed, out of descriptors: " + std::to_string(SocketApi::LastError())
+			+ "; pausing new connections");
+		descriptorLimitReported = true;
+	}
+	poller->Modify(serverSocket, 0);
+	acceptPaused = true;
+	acceptResumeAt = std::chrono::steady_clock::now() + kAcceptBackoff;
+}
+// Watch the listener again once the back-off is over. Returns the Wait
+// timeout: the time left while paused, otherwise none.
+int TcpServer::ResumeAcceptingIfDue() {
+	if (!acceptPaused) return -1;
+	auto now = std::chrono::steady_clock::now();
+	if (now < acceptResumeAt) {
+		auto left = std::chrono::duration_cast<std::chrono::milliseconds>(acceptResumeAt - now).count();
+		return static_cast<int>(left) + 1;
+	}
+	acceptPaused = false;
+	poller->Modify(serverSocket, POLL_READABLE);
+	return -1;
+}
+// Give hung-up connections another go at their pending replies; returns
+// the milliseconds until the next retry, or -1 when none is waiting
+int TcpServer::RetryHungUpFlushes() {
+	if (hungUpFlushes.empty()) return -1;
+	auto now = std::chrono::steady_clock::now();
+	if (now < hungUpFlushAt) {
+		auto left = std::chrono::duration_cast<std::chrono::milliseconds>(hungUpFlushAt - now).count();
+		return static_cast<int>(left) + 1;
+	}
+	std::vector<std::pair<SocketHandle, uint64_t>> due;
+	due.swap(hungUpFlushes);
+	for (const auto& [socket, connectionId] : due) {
+		auto it = connections.find(socket);
+		if (it == connections.end() || it->second->connectionId != connectionId) continue;
+		it->second->flushRetryQueued = false;
+		Advance(*it->second);
+	}
+	return hungUpFlushes.empty() ? -1 : static_cast<int>(kHangupFlushRetry.count());
+}
+// Read everything currently available and queue the complete commands.
+// Connections stay open, so a client can pipeline any number of
+// newline-terminated commands over one socket.
+bool TcpServer::HandleReadable(ClientConnection& connection) {
+	char chunk[16384];
+	uint64_t receivedTotal = 0;
+
+	// Stop reading while a backlog is buffered; level-triggered polling
+	// brings us back once the queued commands have drained.
+	{
+		HIK_TRACE_SCOPE("net", "recv");
+		while (!connection.peerClosed && connection.inBuffer.size() < kMaxInputBuffered) {
+			int received = SocketApi::Receive(connection.socket, chunk, sizeof(chunk));
+			if (received > 0) {
+				connection.inBuffer.append(chunk, received);
+				receivedTotal += received;
+				continue;
+			}
+			if (received == SocketApi::kWouldBlock) break;
+			if (received == 0) {
+				connection.peerClosed = true;
+				break;
+			}
+			Logger::Error("Receive failed: " + std::to_string(SocketApi::LastError()));
+			CloseConnection(connection.socket);
+			return false;
+		}
+	}
+	if (receivedTotal > 0) Metrics::BytesReceived(receivedTotal);
+	return Advance(connection);
+}
+bool TcpServer::HandleWritable(ClientConnection& connection) {
+	return Advance(connection);
+}
+// Hand worker results back to their connections
+void TcpServer::DrainCompletions() {
+	std::vector<CommandCompletion> finished;
+	std::vector<std::pair<SocketHandle, uint64_t>> ready;
+	{
+		std::lock_guard<std::mutex> lock(completionMutex);
+		finished.swap(completions);
+		ready.swap(readySubscriptions);
+	}
+	for (CommandCompletion& completion : finished) {
+		auto it = connections.find(completion.socket);
+		// The client may have gone away (and its socket been reused) meanwhile
+		if (it == connections.end() || it->second->connectionId != completion.connectionId) continue;
 
-		char buffer[1024];
-		ZeroMemory(buffer, sizeof(buffer));
+		ClientConnection& connection = *it->second;
+		connection.outBuffer += completion.responses;
+		connection.commandsInFlight = false;
+		Advance(connection);
+	}
+	for (const auto& [socket, connectionId] : ready) {
+		auto it = connections.find(socket);
+		if (it == connections.end() || it->second->connectionId != connectionId) continue;
+		Advance(*it->second);
+	}
+}
+// Move the connection forward as far as it can go: queue parsed commands,
+// start the next batch, flush replies and close once everything is answered.
+bool TcpServer::Advance(ClientConnection& connection) {
+	QueueCompleteLines(connection);
 
-		int bytesReceived = recv(clientSocket, buffer, sizeof(buffer) - 1, 0);
+	if (!connection.commandsInFlight && !connection.pendingCommands.empty()
+		&& PendingOutput(connection) < kMaxPendingOutput) {
+		SubmitCommands(connection);
+	}
+	if (connection.closeAfterFlush && IsIdle(connection) && !connection.finalResponse.empty()) {
+		SendResponse(connection, connection.finalResponse);
+		connection.finalResponse.clear();
+	}
+	WriteEvents(connection);
+	if (!FlushOutput(connection)) return false;
+	// A flush that emptied a full buffer makes room for the next batch
+	if (!connection.commandsInFlight && !connection.pendingCommands.empty()
+		&& PendingOutput(connection) < kMaxPendingOutput) {
+		SubmitCommands(connection);
+	}
+	// Events held back by a full buffer can go now that it drained
+	if (WriteEvents(connection) && !FlushOutput(connection)) return false;
 
-		if (bytesReceived > 0) {
-			std::string message(buffer, bytesReceived);
-			Logger::Network("Received message: " + message);
+	UpdateInterest(connection);
+	return true;
+}
+// Split the input buffer into commands. Replies are produced in the same
+// order, which keeps pipelined responses aligned with their requests
+// regardless of how TCP segmented the input.
+void TcpServer::QueueCompleteLines(ClientConnection& connection) {
+	HIK_TRACE_SCOPE("net", "parse");
+	size_t start = 0;
+	while (!connection.closeAfterFlush && connection.pendingCommands.size() < kMaxQueuedCommands) {
+		if (!QueueNextFrame(connection, start)) break;
+	}
+	connection.inBuffer.erase(0, start);
 
-			std::string response = "ERROR: Unknown command format";
+	if (connection.closeAfterFlush) return;
 
-			std::string command;
-			std::string paramStr;
+	if (connection.binaryMode) {
+		uint32_t length = 0;
+		if (BinaryProtocol::PeekLength(connection.inBuffer, length) && length > BinaryProtocol::kMaxFrameLength) {
+			Logger::Error("Frame from " + connection.peerAddress + " exceeds "
+				+ std::to_string(BinaryProtocol::kMaxFrameLength) + " bytes, closing connection.");
+			connection.finalResponse = BinaryProtocol::ErrorFrame(CommandError::FRAME_TOO_LARGE);
+			connection.inBuffer.clear();
+			connection.closeAfterFlush = true;
+		}
+		else if (connection.peerClosed) {
+			// A truncated trailing frame cannot be executed
+			connection.inBuffer.clear();
+			connection.closeAfterFlush = true;
+		}
+		return;
+	}
+	if (connection.inBuffer.find('\n') != std::string::npos) return;
 
-			size_t delimiterPos = message.find(':');
+	if (connection.inBuffer.size() > kMaxCommandLength) {
+		Logger::Error("Command from " + connection.peerAddress + " exceeds "
+			+ std::to_string(kMaxCommandLength) + " bytes, closing connection.");
+		connection.finalResponse = ResponseWriter::Response("ERROR", "Command too long");
+		connection.inBuffer.clear();
+		connection.closeAfterFlush = true;
+	}
+	else if (connection.peerClosed) {
+		// Half-closed client: a trailing unterminated command still counts
+		if (!connection.inBuffer.empty()) {
+			QueueMessage(connection, connection.inBuffer);
+			connection.inBuffer.clear();
+		}
+		connection.closeAfterFlush = true;
+	}
+}
+// Queue the command starting at start, if complete, and advance start past it
+bool TcpServer::QueueNextFrame(ClientConnection& connection, size_t& start) {
+	if (connection.binaryMode) {
+		std::string_view rest(connection.inBuffer.data() + start, connection.inBuffer.size() - start);
+		uint32_t length = 0;
+		if (!BinaryProtocol::PeekLength(rest, length) || length > BinaryProtocol::kMaxFrameLength
+			|| rest.size() < BinaryProtocol::kLengthSize + length) {
+			return false;
+		}
+		connection.pendingCommands.push_back({ .data = std::string(rest.substr(BinaryProtocol::kLengthSize, length)), .binary = true });
+		start += BinaryProtocol::kLengthSize + length;
+		return true;
+	}
+	size_t newlinePos = connection.inBuffer.find('\n', start);
+	if (newlinePos == std::string::npos) return false;
+	QueueMessage(connection, connection.inBuffer.substr(start, newlinePos - start));
+	start = newlinePos + 1;
+	return true;
+}
+void TcpServer::QueueMessage(ClientConnection& connection, std::string message) {
+	if (!message.empty() && message.back() == '\r') message.pop_back();
+	if (message.empty()) return;
 
-			if (delimiterPos != std::string::npos) {
-				command = message.substr(0, delimiterPos);
-				paramStr = message.substr(delimiterPos + 1);
-			}
-			else {
-				command = message;
-				command.erase(std::remove(command.begin(), command.end(), '\n'), command.end());
-				command.erase(std::remove(command.begin(), command.end(), '\r'), command.end());
+	QueuedCommand command{ .data = std::move(message) };
+	// Switch framing here, on the reactor, so the bytes that follow this line
+	// are already split as binary frames
+	if (CommandParser::EqualsIgnoreCase(command.data, "PROTOCOL:BINARY")) {
+		connection.binaryMode = true;
+		// Events are text lines; they would corrupt the binary framing
+		command.subscriptionChange = SubscriptionChange::UNSUBSCRIBE;
+		Logger::Network("Client " + connection.peerAddress + " switched to the binary protocol");
+	}
+	ParsedCommand parsed = CommandParser::Parse(command.data);
+	command.SetParsed(parsed);
+	if (parsed.command == TextCommand::SUBSCRIBE) {
+		// An invalid filter changes nothing; the worker reports the error
+		SubscriptionFilter filter;
+		std::string error;
+		if (SubscriptionFilter::Parse(parsed.argument, filter, error)) {
+			command.subscriptionChange = SubscriptionChange::SUBSCRIBE;
+			command.subscription = std::make_shared<Subscription>(std::move(filter),
+				[this, socket = connection.socket, connectionId = connection.connectionId]() {
+					{
+						std::lock_guard<std::mutex> lock(completionMutex);
+						readySubscriptions.emplace_back(socket, connectionId);
+					}
+					poller->Wakeup();
+				});
+		}
+	}
+	else if (parsed.command == TextCommand::UNSUBSCRIBE) {
+		command.subscriptionChange = SubscriptionChange::UNSUBSCRIBE;
+	}
+	connection.pendingCommands.push_back(std::move(command));
+}
+// Run the next batch of this connection's commands on the worker pool
+void TcpServer::SubmitCommands(ClientConnection& connection) {
+	std::vector<QueuedCommand> batch;
+	while (!connection.pendingCommands.empty() && batch.size() < kMaxCommandBatch) {
+		QueuedCommand& command = connection.pendingCommands.front();
+		if (command.subscriptionChange != SubscriptionChange::NONE) ApplySubscriptionChange(connection, command);
+		batch.push_back(std::move(command));
+		connection.pendingCommands.pop_front();
+	}
+	connection.commandsInFlight = true;
+
+	workerPool.Submit([this, socket = connection.socket, connectionId = connection.connectionId, batch = std::move(batch)]() {
+		HIK_TRACE_SCOPE("dispatch", "batch");
+		uint64_t journaled = alarmService->JournalSequence();
+		std::string responses;
+		for (const QueuedCommand& command : batch) {
+			auto started = std::chrono::steady_clock::now();
+			if (command.binary) {
+				HIK_TRACE_SCOPE("dispatch", "BINARY");
+				std::string frame = BinaryProtocol::Handle(*alarmService, command.data);
+				RecordCommandMetric(kBinaryCommandSlot, started, BinaryProtocol::IsFailure(frame));
+				responses += frame;
+				continue;
 			}
-			std::transform(command.begin(), command.end(), command.begin(),
-				[](auto c) { return std::toupper(c); });
-
-			try {
-				if (command == "ARM") {
-					response = alarmService->ArmZone(std::stoi(paramStr));
-				}
-				else if (command == "DISARM") {
-					response = alarmService->DisarmZone(std::stoi(paramStr));
-				}
-				else if (command == "BYPASS") {
-					response = alarmService->BypassZone(std::stoi(paramStr), true);
-				}
-				else if (command == "UNBYPASS") {
-					response = alarmService->BypassZone(std::stoi(paramStr), false);
-				}
-				else if (command == "STATUS") {
-					response = alarmService->GetZoneStatus(std::stoi(paramStr));
-				}
-				else if (command == "TRIGGER") {
-					response = alarmService->TriggerZone(std::stoi(paramStr));
-				}
-				else if (command == "LIST_ALL_ZONES") {
-					response = alarmService->ListAllZones();
-					Logger::Info("Sent list: All Zones");
-				}
-				else if (command == "LIST_ARMED_ZONES") {
-					response = alarmService->ListArmedZones();
-				}
-				else if (command == "LIST_BYPASSED_ZONES") {
-					response = alarmService->ListBypassedZones();
-				}
-				else if (command == "LIST_DISARMED_ZONES") {
-					response = alarmService->ListDisarmedZones();
-				}
-				else if (command == "LIST_ALARMING_ZONES") {
-					response = alarmService->ListAlarmingZones();
-				}
-				else if (command == "LIST_ONE_ZONE") {
-					response = alarmService->ListOneZone(std::stoi(paramStr));
-				}
-				else if (command == "DISARM_PARTITION") {
-					response = alarmService->DisarmPartition(std::stoi(paramStr));
-				}
-				else if (command == "ARM_PARTITION") {
-					response = alarmService->ArmPartition(std::stoi(paramStr));
-				}
-				else {
-					nlohmann::json jErr;
-					jErr["status"] = "ERROR";
-					jErr["message"] = "Unknown command: " + command;
-					response = jErr.dump();
-					Logger::Error("Unknown command: " + command);
-				}
+			ParsedCommand parsed = command.Parsed();
+			size_t slot = Metrics::CommandSlot(parsed.command);
+			// Command names are literals, so the view is null-terminated
+			HIK_TRACE_SCOPE("dispatch", Metrics::CommandName(slot).data());
+			Logger::Network<LogFormat::NET_MESSAGE_RECEIVED>(command.data);
+			CommandReply reply = HandleCommand(parsed, command.data);
+			RecordCommandMetric(slot, started, reply.status == CommandStatus::FAILURE);
+			Logger::Network<LogFormat::NET_RESPONSE_SENT>(reply.text);
+			responses += reply.text;
+			responses += '\n';
+		}
+		// Group commit: hold the replies until the batch's changes are
+		// durable. Read-only batches append nothing and need not wait.
+		alarmService->SyncJournalSince(journaled);
+		{
+			std::lock_guard<std::mutex> lock(completionMutex);
+			completions.push_back({ socket, connectionId, std::move(responses) });
+		}
+		poller->Wakeup();
+	});
+}
+// Replace or drop the connection's subscription. Runs when the command's
+// batch is submitted: events published from here on are written after the
+// batch's replies.
+void TcpServer::ApplySubscriptionChange(ClientConnection& connection, QueuedCommand& command) {
+	if (connection.subscription) {
+		alarmService->Events().Remove(connection.subscription);
+		connection.subscription.reset();
+		Logger::Network("Client " + connection.peerAddress + " unsubscribed from state events");
+	}
+	if (command.subscriptionChange == SubscriptionChange::SUBSCRIBE) {
+		connection.subscription = std::move(command.subscription);
+		alarmService->Events().Add(connection.subscription);
+		Logger::Network("Client " + connection.peerAddress + " subscribed to state events");
+	}
+}
+// Append the subscription's queued events, one JSON line each. Only between
+// command batches, so events never land in the middle of pipelined replies,
+// and only while the client keeps up; otherwise they keep coalescing in the
+// subscription's queue.
+bool TcpServer::WriteEvents(ClientConnection& connection) {
+	if (!connection.subscription || connection.commandsInFlight || connection.closeAfterFlush
+		|| PendingOutput(connection) >= kMaxEventOutput) {
+		return false;
+	}
+	std::vector<StateEvent> events;
+	size_t dropped = 0;
+	connection.subscription->Drain(events, dropped);
+	if (events.empty() && dropped == 0) return false;
+
+	for (const StateEvent& event : events) {
+		ResponseWriter::WriteEvent(connection.outBuffer, event);
+		connection.outBuffer += '\n';
+	}
+	if (dropped > 0) {
+		ResponseWriter::WriteEventsDropped(connection.outBuffer, dropped);
+		connection.outBuffer += '\n';
+	}
+	return true;
+}
+// Push as much pending output as the socket accepts; partial writes resume
+// on the next writable notification.
+bool TcpServer::FlushOutput(ClientConnection& connection) {
+	if (connection.outOffset < connection.outBuffer.size()) {
+		HIK_TRACE_SCOPE("net", "send");
+		while (connection.outOffset < connection.outBuffer.size()) {
+			int sent = SocketApi::Send(connection.socket,
+				connection.outBuffer.data() + connection.outOffset,
+				static_cast<int>(connection.outBuffer.size() - connection.outOffset));
+			if (sent == SocketApi::kWouldBlock) {
+				return true;
 			}
-			catch (const std::exception& e) {
-				nlohmann::json jErr;
-				jErr["status"] = "ERROR";
-				jErr["message"] = "Invalid command format or ID";
-				response = jErr.dump();
-				Logger::Error("Exception in command processing: " + std::string(e.what()));
+			if (sent < 0) {
+				Logger::Error("Send failed: " + std::to_string(SocketApi::LastError()));
+				CloseConnection(connection.socket);
+				return false;
 			}
+			connection.outOffset += sent;
+			Metrics::BytesSent(sent);
+		}
+	}
+	connection.outBuffer.clear();
+	connection.outOffset = 0;
+
+	if (connection.closeAfterFlush && IsIdle(connection) && connection.finalResponse.empty()) {
+		CloseConnection(connection.socket);
+		return false;
+	}
+	return true;
+}
+size_t TcpServer::PendingOutput(const ClientConnection& connection) const {
+	return connection.outBuffer.size() - connection.outOffset;
+}
+bool TcpServer::IsIdle(const ClientConnection& connection) const {
+	return !connection.commandsInFlight && connection.pendingCommands.empty();
+}
+// Read while there is room for more work, write while output is pending
+void TcpServer::UpdateInterest(ClientConnection& connection) {
+	uint32_t interest = 0;
+	if (!connection.peerClosed && !connection.closeAfterFlush
+		&& PendingOutput(connection) < kMaxPendingOutput
+		&& connection.inBuffer.size() < kMaxInputBuffered
+		&& connection.pendingCommands.size() < kMaxQueuedCommands) {
+		interest |= POLL_READABLE;
+	}
+	if (PendingOutput(connection) > 0) {
+		interest |= POLL_WRITABLE;
+	}
+	bool parked = connection.hungUp && (interest & POLL_READABLE) == 0;
+	if (parked && (interest & POLL_WRITABLE) && !connection.flushRetryQueued) {
+		if (hungUpFlushes.empty()) hungUpFlushAt = std::chrono::steady_clock::now() + kHangupFlushRetry;
+		hungUpFlushes.emplace_back(connection.socket, connection.connectionId);
+		connection.flushRetryQueued = true;
+	}
+	if (parked != connection.parked) {
+		if (parked) poller->Remove(connection.socket);
+		else poller->Add(connection.socket, interest);
+		connection.parked = parked;
+		connection.interest = interest;
+		return;
+	}
+	if (interest != connection.interest) {
+		poller->Modify(connection.socket, interest);
+		connection.interest = interest;
+	}
+}
+void TcpServer::CloseConnection(SocketHandle socket) {
+	auto it = connections.find(socket);
+	if (it != connections.end() && it->second->subscription) {
+		alarmService->Events().Remove(it->second->subscription);
+	}
+	poller->Remove(socket);
+	SocketApi::Close(socket);
+	connections.erase(socket);
+	Metrics::ConnectionClosed();
+	Logger::Network<LogFormat::NET_CLIENT_DISCONNECTED>();
+}
+// The zone operation behind a command that also has a batch form
+bool TcpServer::ZoneOperationFor(TextCommand command, ZoneOperation& operation)
+{
+	switch (command) {
+	case TextCommand::ARM: operation = ZoneOperation::ARM; return true;
+	case TextCommand::DISARM: operation = ZoneOperation::DISARM; return true;
+	case TextCommand::BYPASS: operation = ZoneOperation::BYPASS; return true;
+	case TextCommand::UNBYPASS: operation = ZoneOperation::UNBYPASS; return true;
+	case TextCommand::STATUS: operation = ZoneOperation::STATUS; return true;
+	case TextCommand::TRIGGER: operation = ZoneOperation::TRIGGER; return true;
+	default: return false;
+	}
+}
+// Dispatch one command line, parsed on the reactor, to the AlarmService
+CommandReply TcpServer::HandleCommand(const ParsedCommand& parsed, std::string_view message) {
+	if (parsed.command == TextCommand::UNKNOWN) {
+		// Error path only: echo the name uppercased like the commands themselves
+		std::string command(parsed.name);
+		std::transform(command.begin(), command.end(), command.begin(),
+			[](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+		Logger::Error("Unknown command: " + command);
+		return FailureReply("Unknown command: " + command);
+	}
 
-			SendResponse(clientSocket, response);
-			Logger::Network("Response sent: " + response);
-			closesocket(clientSocket);
-			Logger::Network("Client disconnected.");
+	ZoneOperation operation;
+	if (ZoneOperationFor(parsed.command, operation) && CommandParser::IsIdList(parsed.argument)) {
+		std::vector<int> ids;
+		if (!CommandParser::ParseIdList(parsed.argument, ids, kMaxBatchIds)) {
+			Logger::Error("Invalid id list in command: " + std::string(parsed.name));
+			return FailureReply("Invalid id list (at most " + std::to_string(kMaxBatchIds) + " ids)");
+		}
+		CommandStatus status;
+		std::string response = alarmService->ZoneBatch(operation, ids, status);
+		return CommandReply(std::move(response), status);
+	}
+
+	int id = 0;
+	switch (parsed.command) {
+	case TextCommand::ARM:
+	case TextCommand::DISARM:
+	case TextCommand::BYPASS:
+	case TextCommand::UNBYPASS:
+	case TextCommand::STATUS:
+	case TextCommand::TRIGGER:
+	case TextCommand::LIST_ONE_ZONE:
+	case TextCommand::DISARM_PARTITION:
+	case TextCommand::ARM_PARTITION:
+		if (!CommandParser::ParseId(parsed.argument, id)) {
+			Logger::Error("Invalid id in command: " + std::string(message));
+			return FailureReply("Invalid command format or ID");
+		}
+		break;
+	default:
+		break;
+	}
+
+	switch (parsed.command) {
+	case TextCommand::ARM: return ResultReply(*alarmService, alarmService->ArmZoneResult(id));
+	case TextCommand::DISARM: return ResultReply(*alarmService, alarmService->DisarmZoneResult(id));
+	case TextCommand::BYPASS: return ResultReply(*alarmService, alarmService->BypassZoneResult(id, true));
+	case TextCommand::UNBYPASS: return ResultReply(*alarmService, alarmService->BypassZoneResult(id, false));
+	case TextCommand::STATUS: return ResultReply(*alarmService, alarmService->ZoneStatusResult(id));
+	case TextCommand::TRIGGER: return ResultReply(*alarmService, alarmService->TriggerZoneResult(id));
+	case TextCommand::LIST_ALL_ZONES: {
+		std::string response = alarmService->ListAllZones();
+		Logger::Info<LogFormat::NET_LIST_ALL_SENT>();
+		return SuccessReply(std::move(response));
+	}
+	case TextCommand::LIST_ARMED_ZONES: return SuccessReply(alarmService->ListArmedZones());
+	case TextCommand::LIST_BYPASSED_ZONES: return SuccessReply(alarmService->ListBypassedZones());
+	case TextCommand::LIST_DISARMED_ZONES: return SuccessReply(alarmService->ListDisarmedZones());
+	case TextCommand::LIST_ALARMING_ZONES: return SuccessReply(alarmService->ListAlarmingZones());
+	case TextCommand::LIST_ZONES: {
+		CommandStatus status;
+		std::string response = alarmService->ListZones(std::string(parsed.argument), status);
+		return CommandReply(std::move(response), status);
+	}
+	case TextCommand::COUNT_ZONES: {
+		CommandStatus status;
+		std::string response = alarmService->CountZones(std::string(parsed.argument), status);
+		return CommandReply(std::move(response), status);
+	}
+	case TextCommand::LIST_ONE_ZONE: {
+		CommandStatus status;
+		std::string response = alarmService->ListOneZone(id, status);
+		return CommandReply(std::move(response), status);
+	}
+	case TextCommand::DISARM_PARTITION: return ResultReply(*alarmService, alarmService->DisarmPartitionResult(id));
+	case TextCommand::ARM_PARTITION: return ResultReply(*alarmService, alarmService->ArmPartitionResult(id));
+	case TextCommand::PROTOCOL:
+		// The reactor already switched framing when it saw this line
+		if (CommandParser::EqualsIgnoreCase(parsed.argument, "BINARY")) {
+			return SuccessReply(ResponseWriter::Response("SUCCESS", "Binary protocol enabled", -1, "BINARY"));
+		}
+		if (CommandParser::EqualsIgnoreCase(parsed.argument, "TEXT")) {
+			return SuccessReply(ResponseWriter::Response("SUCCESS", "Text protocol active", -1, "TEXT"));
+		}
+		return FailureReply("Unsupported protocol: " + std::string(parsed.argument));
+	case TextCommand::SNAPSHOT: {
+		SnapshotStats stats = alarmService->TakeSnapshot();
+		if (!stats.saved) return FailureReply("Snapshot could not be saved");
+		return SuccessReply(ResponseWriter::Response("SUCCESS", "Snapshot of " + std::to_string(stats.zoneCount) + " zones saved: "
+			+ std::to_string(stats.bytes) + " bytes, state copied in " + std::to_string(stats.copyMicros) + " us, written in "
+			+ std::to_string(stats.writeMillis) + " ms"));
+	}
+	case TextCommand::LIST_CHANGES_SINCE: {
+		uint64_t sequence = 0;
+		if (!CommandParser::ParseUnsigned(parsed.argument, sequence)) {
+			Logger::Error("Invalid sequence in command: " + std::string(message));
+			return FailureReply("Invalid sequence number");
+		}
+		return SuccessReply(alarmService->ListChangesSince(sequence));
+	}
+	case TextCommand::SENSOR: {
+		// Queued for the sensor pipeline; the state changes later, debounced
+		std::vector<SensorEvent> events;
+		if (!SensorPipeline::ParseEvents(parsed.argument, events)) {
+			Logger::Error("Invalid sensor events in command: " + std::string(message));
+			return FailureReply("Invalid sensor event, expected <zoneId>,<active|tamper|fault>,<0|1>");
+		}
+		size_t queued = 0;
+		for (const auto& event : events) {
+			if (alarmService->Sensors().Submit(event)) queued++;
+		}
+		if (queued < events.size()) {
+			return FailureReply("Sensor queue full: queued " + std::to_string(queued) + " of " + std::to_string(events.size()) + " events");
+		}
+		return SuccessReply(ResponseWriter::Response("SUCCESS", "Queued " + std::to_string(queued) + " sensor events"));
+	}
+	case TextCommand::DEBOUNCE: {
+		// DEBOUNCE:<ms> sets the default, DEBOUNCE:<id list>=<ms> the listed zones
+		std::string_view argument = parsed.argument;
+		size_t equals = argument.find('=');
+		std::vector<int> ids;
+		uint64_t milliseconds = 0;
+		if (!CommandParser::ParseUnsigned(equals == std::string_view::npos ? argument : argument.substr(equals + 1), milliseconds)
+			|| milliseconds > SensorPipeline::kMaxDebounceMs
+			|| (equals != std::string_view::npos && !CommandParser::ParseIdList(argument.substr(0, equals), ids, kMaxBatchIds))) {
+			Logger::Error("Invalid debounce command: " + std::string(message));
+			return FailureReply("Invalid debounce, expected [<id list>=]<0-" + std::to_string(SensorPipeline::kMaxDebounceMs) + " ms>");
+		}
+		uint32_t window = static_cast<uint32_t>(milliseconds);
+		std::string scope = "zones without their own setting";
+		if (equals == std::string_view::npos) {
+			alarmService->Sensors().SetDefaultDebounce(window);
 		}
 		else {
-			Logger::Error("Invalid message format received.");
+			for (int zoneId : ids) {
+				alarmService->Sensors().SetDebounce(zoneId, window);
+			}
+			scope = std::to_string(ids.size()) + " zones";
+		}
+		Logger::Info<LogFormat::SENSOR_DEBOUNCE_SET>(window, scope);
+		return SuccessReply(ResponseWriter::Response("SUCCESS", "Debounce set to " + std::to_string(window) + " ms for " + scope));
+	}
+	case TextCommand::DELAY: {
+		// DELAY:<exit|entry|siren|restore>:<id list>=<ms>
+		std::string_view argument = parsed.argument;
+		size_t colon = argument.find(':');
+		size_t equals = argument.find('=');
+		DelayKind kind;
+		std::vector<int> ids;
+		uint64_t milliseconds = 0;
+		if (colon == std::string_view::npos || equals == std::string_view::npos || equals < colon
+			|| !AlarmService::ParseDelayKind(argument.substr(0, colon), kind)
+			|| !CommandParser::ParseIdList(argument.substr(colon + 1, equals - colon - 1), ids, kMaxBatchIds)
+			|| !CommandParser::ParseUnsigned(argument.substr(equals + 1), milliseconds) || milliseconds > kMaxDelayMs) {
+			Logger::Error("Invalid delay command: " + std::string(message));
+			return FailureReply("Invalid delay, expected <exit|entry|siren|restore>:<id list>=<0-" + std::to_string(kMaxDelayMs) + " ms>");
+		}
+		CommandStatus status;
+		std::string response = alarmService->SetDelay(kind, ids, static_cast<uint32_t>(milliseconds), status);
+		return CommandReply(std::move(response), status);
+	}
+	case TextCommand::TIMERS: return SuccessReply(alarmService->TimerStatus());
+	case TextCommand::TRACE: {
+		if (!Tracer::kCompiledIn) return FailureReply("Tracing is compiled out; rebuild with HIK_TRACING=1");
+		if (CommandParser::EqualsIgnoreCase(parsed.argument, "ON")) {
+			Tracer::Enable(true);
+			return SuccessReply(ResponseWriter::Response("SUCCESS", "Tracing enabled", -1, "ON"));
+		}
+		if (CommandParser::EqualsIgnoreCase(parsed.argument, "OFF")) {
+			Tracer::Enable(false);
+			return SuccessReply(ResponseWriter::Response("SUCCESS", "Tracing disabled", -1, "OFF"));
 		}
+		if (CommandParser::EqualsIgnoreCase(parsed.argument, "DUMP")) {
+			std::string path;
+			size_t eventCount = 0;
+			if (!Tracer::Dump(path, eventCount)) return FailureReply("Failed to write " + path);
+			return SuccessReply(ResponseWriter::Response("SUCCESS", "Wrote " + std::to_string(eventCount) + " trace events to " + path));
+		}
+		return FailureReply("Invalid trace command, expected TRACE:<ON|OFF|DUMP>");
+	}
+	case TextCommand::METRICS: {
+		auto snapshot = Metrics::Collect();
+		snapshot->partitions = alarmService->PartitionGauges();
+		std::string out;
+		ResponseWriter::WriteMetrics(out, *snapshot);
+		return SuccessReply(std::move(out));
+	}
+	case TextCommand::SUBSCRIBE: {
+		// The reactor already started the subscription if the filter is valid
+		SubscriptionFilter filter;
+		std::string error;
+		if (!SubscriptionFilter::Parse(parsed.argument, filter, error)) return FailureReply(error);
+		return SuccessReply(ResponseWriter::Response("SUCCESS", "Subscribed to state events", -1, "SUBSCRIBED"));
+	}
+	case TextCommand::UNSUBSCRIBE:
+		return SuccessReply(ResponseWriter::Response("SUCCESS", "Unsubscribed from state events", -1, "UNSUBSCRIBED"));
+	default:
+		return FailureReply("Invalid command format or ID");
 	}
 }
 
-// Send a response back to the client
-void TcpServer::SendResponse(SOCKET clientSocket, std::string& response) {
-	response += "\n";
-	int bytesSent = send(clientSocket, response.c_str(), response.length(), 0);
-	if (bytesSent == SOCKET_ERROR) {
-		Logger::Error("Send failed: " + std::to_string(WSAGetLastError()));
-	}
-}
\ No newline at end of file
+// Queue a response for the client; HandleWritable flushes it
+void TcpServer::SendResponse(ClientConnection& connection, std::string& response) {
+	// Binary frames carry their own length prefix
+	if (!connection.binaryMode) response += "\n";
+	connection.outBuffer += response;
+}
@@ -2,22 +2,172 @@
 #include <vector>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <thread>
-#include <ws2tcpip.h>
-#include <winsock2.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include "SocketApi.h"
+#include "Poller.h"
+#include "ThreadPool.h"
 #include "AlarmService.h"
-#pragma comment(lib, "ws2_32.lib")
+#include "BinaryProtocol.h"
+#include "CommandParser.h"
+#include "EventHub.h"
 
+// SUBSCRIBE / UNSUBSCRIBE take effect on the reactor when the batch holding
+// them is submitted, so pushed events always follow the reply
+enum class SubscriptionChange : uint8_t {
+	NONE,
+	SUBSCRIBE,
+	UNSUBSCRIBE
+};
+
+// A framed request: a text command line or a binary request payload
+struct QueuedCommand {
+	std::string data;
+	bool binary = false;
+	SubscriptionChange subscriptionChange = SubscriptionChange::NONE;
+	std::shared_ptr<Subscription> subscription = nullptr;
+	// Text commands are parsed once, on the reactor. The views are stored as
+	// offsets into data: moving a short string moves its characters too.
+	TextCommand textCommand = TextCommand::UNKNOWN;
+	size_t nameLength = 0;
+	size_t argumentOffset = 0;
+	size_t argumentLength = 0;
+
+	void SetParsed(const ParsedCommand& parsed) {
+		textCommand = parsed.command;
+		nameLength = parsed.name.size();
+		argumentOffset = parsed.argument.empty() ? 0 : static_cast<size_t>(parsed.argument.data() - data.data());
+		argumentLength = parsed.argument.size();
+	}
+	ParsedCommand Parsed() const {
+		std::string_view view(data);
+		return { textCommand, view.substr(0, nameLength), view.substr(argumentOffset, argumentLength) };
+	}
+};
+
+// A text reply and the status it reports, for the command error counters
+struct CommandReply {
+	explicit CommandReply(std::string text, CommandStatus status)
+		: text(std::move(text)), status(status) {}
+	std::string text;
+	CommandStatus status;
+};
+
+// Per-client state owned by the reactor thread
+struct ClientConnection {
+	SocketHandle socket;
+	uint64_t connectionId = 0;
+	std::string peerAddress;
+	std::string inBuffer;
+	std::string outBuffer;
+	size_t outOffset = 0;
+	uint32_t interest = POLL_READABLE;
+	bool peerClosed = false;
+	bool closeAfterFlush = false;
+	// Hangup is reported whatever the interest, so a hung-up connection
+	// leaves the poller once nothing is left to read. Replies it still owes
+	// are retried on a timer.
+	bool hungUp = false;
+	bool parked = false;
+	bool flushRetryQueued = false;
+	// Set once the client negotiates PROTOCOL:BINARY; input after that line
+	// is parsed as length-prefixed frames
+	bool binaryMode = false;
+	// Parsed commands waiting for a worker; at most one batch runs at a time
+	// so replies are produced in request order.
+	std::deque<QueuedCommand> pendingCommands;
+	bool commandsInFlight = false;
+	// Sent once every earlier command has been answered, then the socket closes
+	std::string finalResponse;
+	// Active SUBSCRIBE; its events are written between command batches
+	std::shared_ptr<Subscription> subscription = nullptr;
+};
+
+// Responses produced by a worker, handed back to the reactor thread
+struct CommandCompletion {
+	SocketHandle socket;
+	uint64_t connectionId;
+	std::string responses;
+};
+
+// Threading model: one reactor thread owns every socket and ClientConnection;
+// commands execute on workerPool. Each connection has at most one batch in
+// flight, so different clients run in parallel while each client's replies
+// stay ordered. Workers return results through the completion queue and wake
+// the reactor via Poller::Wakeup().
 class TcpServer {
 private:
-	SOCKET serverSocket;
+	// Longest accepted command line; anything longer closes the connection
+	static constexpr size_t kMaxCommandLength = 64 * 1024;
+	// Backpressure limits for pipelining clients that do not read replies
+	static constexpr size_t kMaxInputBuffered = 1024 * 1024;
+	static constexpr size_t kMaxPendingOutput = 4 * 1024 * 1024;
+	static constexpr size_t kMaxQueuedCommands = 1024;
+	// Commands handed to a worker in one job
+	static constexpr size_t kMaxCommandBatch = 64;
+	// Ids one batch zone command (ARM:1-500,...) may address
+	static constexpr size_t kMaxBatchIds = 10000;
+	// Longest DELAY setting: one day
+	static constexpr uint64_t kMaxDelayMs = 24 * 60 * 60 * 1000;
+	// Subscription events wait in their (coalescing) queue while this much
+	// output is still unsent
+	static constexpr size_t kMaxEventOutput = 256 * 1024;
+	// How long the listener is ignored after accept ran out of descriptors
+	static constexpr auto kAcceptBackoff = std::chrono::milliseconds(100);
+	// How often a hung-up connection retries sending its remaining replies
+	static constexpr auto kHangupFlushRetry = std::chrono::milliseconds(20);
+
+	SocketHandle serverSocket;
 	int port;
-	bool isRunning;
+	std::atomic<bool> isRunning;
 	std::thread serverThread;
 	AlarmService* alarmService;
+	std::unique_ptr<Poller> poller;
+	std::unordered_map<SocketHandle, std::unique_ptr<ClientConnection>> connections;
+	uint64_t nextConnectionId;
+	bool acceptPaused = false;
+	// Warn once per shortage, not on every back-off
+	bool descriptorLimitReported = false;
+	std::chrono::steady_clock::time_point acceptResumeAt;
+	std::vector<std::pair<SocketHandle, uint64_t>> hungUpFlushes;
+	std::chrono::steady_clock::time_point hungUpFlushAt;
+
+	ThreadPool workerPool;
+	std::mutex completionMutex;
+	std::vector<CommandCompletion> completions;
+	// Connections whose subscription queue became non-empty
+	std::vector<std::pair<SocketHandle, uint64_t>> readySubscriptions;
 
 	void ListenForClients();
-	void SendResponse(SOCKET clientSocket, std::string& response);
+	void AcceptClients();
+	void PauseAccepting();
+	int ResumeAcceptingIfDue();
+	int RetryHungUpFlushes();
+	bool HandleReadable(ClientConnection& connection);
+	bool HandleWritable(ClientConnection& connection);
+	void DrainCompletions();
+	bool Advance(ClientConnection& connection);
+	void QueueCompleteLines(ClientConnection& connection);
+	bool QueueNextFrame(ClientConnection& connection, size_t& start);
+	void QueueMessage(ClientConnection& connection, std::string message);
+	void SubmitCommands(ClientConnection& connection);
+	void ApplySubscriptionChange(ClientConnection& connection, QueuedCommand& command);
+	bool WriteEvents(ClientConnection& connection);
+	bool FlushOutput(ClientConnection& connection);
+	size_t PendingOutput(const ClientConnection& connection) const;
+	bool IsIdle(const ClientConnection& connection) const;
+	void UpdateInterest(ClientConnection& connection);
+	void CloseConnection(SocketHandle socket);
+	CommandReply HandleCommand(const ParsedCommand& parsed, std::string_view message);
+	static bool ZoneOperationFor(TextCommand command, ZoneOperation& operation);
+	void SendResponse(ClientConnection& connection, std::string& response);
 
 public:
 	TcpServer(int port);
@@ -28,4 +178,3 @@ public:
 
 
 };
-
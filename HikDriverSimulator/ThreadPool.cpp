@@ -0,0 +1,51 @@
+#include "ThreadPool.h"
+#include "Tracer.h"
+
+ThreadPool::ThreadPool() : stopping(false) {}
+ThreadPool::~ThreadPool() {
+	Stop();
+}
+void ThreadPool::Start(size_t threadCount)
+{
+	std::lock_guard<std::mutex> lock(queueMutex);
+	stopping = false;
+	for (size_t i = 0; i < threadCount; i++) {
+		workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+void ThreadPool::Submit(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		jobs.push_back(std::move(job));
+	}
+	queueCondition.notify_one();
+}
+void ThreadPool::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		if (workers.empty()) return;
+		stopping = true;
+	}
+	queueCondition.notify_all();
+	for (auto& worker : workers) {
+		if (worker.joinable()) worker.join();
+	}
+	workers.clear();
+}
+void ThreadPool::WorkerLoop()
+{
+	Tracer::NameThread("worker");
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			queueCondition.wait(lock, [this] { return stopping || !jobs.empty(); });
+			if (jobs.empty()) return;
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+		job();
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads fed from a single FIFO queue.
+// Used by TcpServer to run commands off the reactor thread.
+class ThreadPool
+{
+private:
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> jobs;
+	std::mutex queueMutex;
+	std::condition_variable queueCondition;
+	bool stopping;
+
+	void WorkerLoop();
+
+public:
+	ThreadPool();
+	~ThreadPool();
+	void Start(size_t threadCount);
+	void Submit(std::function<void()> job);
+	// Finish the queued jobs, then join every worker
+	void Stop();
+	size_t Size() const { return workers.size(); }
+};
@@ -0,0 +1,110 @@
+#include "TimerScheduler.h"
+#include "Tracer.h"
+
+TimerScheduler::TimerScheduler()
+	: epoch(Clock::now()),
+	wheel(0)
+{
+}
+TimerScheduler::~TimerScheduler()
+{
+	Stop();
+}
+void TimerScheduler::Start(Dispatch onExpired)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (running) return;
+	dispatch = std::move(onExpired);
+	running = true;
+	stopping = false;
+	thread = std::thread(&TimerScheduler::Loop, this);
+}
+void TimerScheduler::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!running) return;
+		running = false;
+		stopping = true;
+	}
+	wakeCondition.notify_one();
+	if (thread.joinable()) thread.join();
+}
+uint64_t TimerScheduler::TickAt(Clock::time_point time) const
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(time - epoch).count()) / kTickMs;
+}
+TimerScheduler::Clock::time_point TimerScheduler::TimeOf(uint64_t tick) const
+{
+	return epoch + std::chrono::milliseconds(tick * kTickMs);
+}
+uint64_t TimerScheduler::Schedule(std::chrono::milliseconds delay, uint64_t payload)
+{
+	// Round up, so a timer never fires early
+	auto due = Clock::now() + delay;
+	uint64_t tick = TickAt(due);
+	if (TimeOf(tick) < due) tick++;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	bool wasIdle = wheel.Pending() == 0;
+	if (wasIdle) {
+		// An idle wheel stops advancing; catch up first (nothing can fire)
+		std::vector<ExpiredTimer> none;
+		wheel.Advance(TickAt(Clock::now()), none);
+	}
+	uint64_t timerId = wheel.Schedule(tick, payload);
+	// The thread only sleeps indefinitely while nothing is pending
+	if (wasIdle) wakeCondition.notify_one();
+	return timerId;
+}
+bool TimerScheduler::Cancel(uint64_t timerId)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return wheel.Cancel(timerId);
+}
+TimerStats TimerScheduler::Stats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	TimerStats stats;
+	stats.tickMs = kTickMs;
+	stats.pending = wheel.Pending();
+	stats.levels = wheel.LevelCounts();
+	stats.fired = fired;
+	stats.lastLagMicros = lastLagMicros;
+	stats.maxLagMicros = maxLagMicros;
+	return stats;
+}
+void TimerScheduler::Loop()
+{
+	Tracer::NameThread("timer-wheel");
+	std::vector<ExpiredTimer> expired;
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!stopping) {
+		if (wheel.Pending() == 0) {
+			wakeCondition.wait(lock, [this]() { return stopping || wheel.Pending() > 0; });
+			continue;
+		}
+		wakeCondition.wait_until(lock, TimeOf(wheel.CurrentTick() + 1), [this]() { return stopping; });
+		if (stopping) break;
+
+		auto now = Clock::now();
+		expired.clear();
+		wheel.Advance(TickAt(now), expired);
+		if (expired.empty()) continue;
+
+		// Lag of the earliest timer in the batch: how far behind the wheel ran
+		uint64_t earliest = expired.front().expiryTick;
+		for (const auto& timer : expired) {
+			if (timer.expiryTick < earliest) earliest = timer.expiryTick;
+		}
+		auto lag = std::chrono::duration_cast<std::chrono::microseconds>(now - TimeOf(earliest)).count();
+		lastLagMicros = lag > 0 ? static_cast<uint64_t>(lag) : 0;
+		if (lastLagMicros > maxLagMicros) maxLagMicros = lastLagMicros;
+		fired += expired.size();
+
+		// Dispatch unlocked, so handlers can schedule and cancel
+		lock.unlock();
+		dispatch(expired);
+		lock.lock();
+	}
+}
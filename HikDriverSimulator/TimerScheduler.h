@@ -0,0 +1,67 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "TimingWheel.h"
+
+struct TimerStats {
+	uint32_t tickMs = 0;
+	size_t pending = 0;
+	std::array<size_t, TimingWheel::kLevels> levels{};
+	uint64_t fired = 0;
+	// How late the most recent / the latest-ever batch of timers fired
+	uint64_t lastLagMicros = 0;
+	uint64_t maxLagMicros = 0;
+};
+
+// Drives one TimingWheel from its own thread, a tick every kTickMs, and
+// hands the payloads of expired timers to the dispatch callback outside the
+// lock. Any thread may schedule or cancel. The thread sleeps until the next
+// tick only while timers are pending; with none it waits for a Schedule.
+class TimerScheduler
+{
+public:
+	static constexpr uint32_t kTickMs = 10;
+
+	using Dispatch = std::function<void(const std::vector<ExpiredTimer>& expired)>;
+
+	TimerScheduler();
+	~TimerScheduler();
+	TimerScheduler(const TimerScheduler&) = delete;
+	TimerScheduler& operator=(const TimerScheduler&) = delete;
+
+	void Start(Dispatch dispatch);
+	// Pending timers are discarded
+	void Stop();
+	// Fires no earlier than delay from now, rounded up to a tick. Returns the
+	// id to cancel with; never 0.
+	uint64_t Schedule(std::chrono::milliseconds delay, uint64_t payload);
+	// False when the timer already fired (its dispatch may still be running)
+	bool Cancel(uint64_t timerId);
+	TimerStats Stats() const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	const Clock::time_point epoch;
+	TimingWheel wheel;
+	Dispatch dispatch;
+	std::thread thread;
+	mutable std::mutex mutex;
+	std::condition_variable wakeCondition;
+	bool running = false;
+	bool stopping = false;
+	uint64_t fired = 0;
+	uint64_t lastLagMicros = 0;
+	uint64_t maxLagMicros = 0;
+
+	void Loop();
+	uint64_t TickAt(Clock::time_point time) const;
+	Clock::time_point TimeOf(uint64_t tick) const;
+};
@@ -0,0 +1,127 @@
+#include "TimingWheel.h"
+
+TimingWheel::TimingWheel(uint64_t startTick)
+	: currentTick(startTick)
+{
+	for (auto& level : heads) level.fill(kNil);
+}
+uint64_t TimingWheel::MakeId(uint32_t index, uint32_t generation)
+{
+	// index + 1 so that 0 never names a timer
+	return static_cast<uint64_t>(generation) << 32 | (static_cast<uint64_t>(index) + 1);
+}
+uint64_t TimingWheel::Schedule(uint64_t expiryTick, uint64_t payload)
+{
+	// The current tick's slot has already been processed
+	if (expiryTick <= currentTick) expiryTick = currentTick + 1;
+	if (expiryTick - currentTick > kMaxDelayTicks) expiryTick = currentTick + kMaxDelayTicks;
+
+	uint32_t index;
+	if (!freeNodes.empty()) {
+		index = freeNodes.back();
+		freeNodes.pop_back();
+	}
+	else {
+		index = static_cast<uint32_t>(nodes.size());
+		nodes.emplace_back();
+	}
+	Node& node = nodes[index];
+	node.expiryTick = expiryTick;
+	node.payload = payload;
+	Place(index);
+	pending++;
+	return MakeId(index, node.generation);
+}
+bool TimingWheel::Cancel(uint64_t timerId)
+{
+	uint64_t low = timerId & 0xFFFFFFFFu;
+	if (low == 0 || low > nodes.size()) return false;
+	uint32_t index = static_cast<uint32_t>(low - 1);
+	Node& node = nodes[index];
+	if (!node.linked || node.generation != static_cast<uint32_t>(timerId >> 32)) return false;
+	Unlink(index);
+	Release(index);
+	return true;
+}
+void TimingWheel::Advance(uint64_t tick, std::vector<ExpiredTimer>& expired)
+{
+	if (pending == 0) {
+		// Nothing to visit, but cascades depend on the tick, so jump straight there
+		if (tick > currentTick) currentTick = tick;
+		return;
+	}
+	while (currentTick < tick) {
+		currentTick++;
+		// When a level wraps, pull the next slot of the level above down,
+		// highest level first so its timers can cascade further
+		size_t wrapped = 0;
+		while (wrapped + 1 < kLevels && (currentTick & ((uint64_t(1) << (kSlotBits * (wrapped + 1))) - 1)) == 0) {
+			wrapped++;
+		}
+		for (size_t level = wrapped; level > 0; level--) {
+			Cascade(level);
+		}
+
+		uint32_t index = heads[0][currentTick & (kSlots - 1)];
+		heads[0][currentTick & (kSlots - 1)] = kNil;
+		while (index != kNil) {
+			Node& node = nodes[index];
+			uint32_t next = node.next;
+			expired.push_back({ MakeId(index, node.generation), node.payload, node.expiryTick });
+			node.linked = false;
+			levelCounts[0]--;
+			Release(index);
+			index = next;
+		}
+		if (pending == 0 && tick > currentTick) currentTick = tick;
+	}
+}
+void TimingWheel::Place(uint32_t index)
+{
+	Node& node = nodes[index];
+	uint64_t delta = node.expiryTick - currentTick;
+	size_t level = 0;
+	while (level + 1 < kLevels && delta >= (uint64_t(1) << (kSlotBits * (level + 1)))) {
+		level++;
+	}
+	uint8_t slot = static_cast<uint8_t>(node.expiryTick >> (kSlotBits * level));
+	uint32_t& head = heads[level][slot];
+	node.level = static_cast<uint8_t>(level);
+	node.slot = slot;
+	node.prev = kNil;
+	node.next = head;
+	if (head != kNil) nodes[head].prev = index;
+	head = index;
+	node.linked = true;
+	levelCounts[level]++;
+}
+void TimingWheel::Unlink(uint32_t index)
+{
+	Node& node = nodes[index];
+	if (node.prev != kNil) nodes[node.prev].next = node.next;
+	else heads[node.level][node.slot] = node.next;
+	if (node.next != kNil) nodes[node.next].prev = node.prev;
+	node.linked = false;
+	levelCounts[node.level]--;
+}
+void TimingWheel::Release(uint32_t index)
+{
+	Node& node = nodes[index];
+	node.generation++;
+	node.prev = kNil;
+	node.next = kNil;
+	freeNodes.push_back(index);
+	pending--;
+}
+void TimingWheel::Cascade(size_t level)
+{
+	uint8_t slot = static_cast<uint8_t>(currentTick >> (kSlotBits * level));
+	uint32_t index = heads[level][slot];
+	heads[level][slot] = kNil;
+	while (index != kNil) {
+		uint32_t next = nodes[index].next;
+		levelCounts[level]--;
+		Place(index);
+		index = next;
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A timer that reached its tick in TimingWheel::Advance
+struct ExpiredTimer {
+	uint64_t timerId;
+	uint64_t payload;
+	uint64_t expiryTick;
+};
+
+// Hierarchical timing wheel: four levels of 256 slots, each level covering
+// 256 times the span of the one below (2^32 ticks in total). A timer sits
+// in the level that matches how far away it is, and moves down a level when
+// the level below wraps around to its slot. Timers are nodes of intrusive
+// doubly linked lists in one pooled array, so Schedule and Cancel are O(1)
+// and allocate nothing once the pool has grown. Not thread-safe.
+class TimingWheel
+{
+public:
+	static constexpr size_t kLevels = 4;
+	static constexpr uint32_t kSlotBits = 8;
+	static constexpr size_t kSlots = 1u << kSlotBits;
+	// Timers further out are clamped to this many ticks
+	static constexpr uint64_t kMaxDelayTicks = (uint64_t(1) << (kSlotBits * kLevels)) - 1;
+
+	explicit TimingWheel(uint64_t startTick = 0);
+
+	// Due at expiryTick; one already in the past fires on the next Advance.
+	// Returns a non-zero id for Cancel.
+	uint64_t Schedule(uint64_t expiryTick, uint64_t payload);
+	// False when the timer already fired or was cancelled
+	bool Cancel(uint64_t timerId);
+	// Move time forward to tick, appending every timer due by then
+	void Advance(uint64_t tick, std::vector<ExpiredTimer>& expired);
+
+	uint64_t CurrentTick() const { return currentTick; }
+	size_t Pending() const { return pending; }
+	const std::array<size_t, kLevels>& LevelCounts() const { return levelCounts; }
+
+private:
+	static constexpr uint32_t kNil = UINT32_MAX;
+
+	struct Node {
+		uint64_t expiryTick = 0;
+		uint64_t payload = 0;
+		uint32_t prev = kNil;
+		uint32_t next = kNil;
+		uint32_t generation = 0;
+		uint8_t level = 0;
+		uint8_t slot = 0;
+		bool linked = false;
+	};
+
+	std::vector<Node> nodes;
+	std::vector<uint32_t> freeNodes;
+	std::array<std::array<uint32_t, kSlots>, kLevels> heads;
+	std::array<size_t, kLevels> levelCounts{};
+	uint64_t currentTick;
+	size_t pending = 0;
+
+	void Place(uint32_t index);
+	void Unlink(uint32_t index);
+	void Release(uint32_t index);
+	// Re-place every timer of one slot, now that it is within the level below
+	void Cascade(size_t level);
+	static uint64_t MakeId(uint32_t index, uint32_t generation);
+};
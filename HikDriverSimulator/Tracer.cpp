@@ -0,0 +1,220 @@
+#include "Tracer.h"
+#include <csignal>
+#include <cstdio>
+#include "FileApi.h"
+#include "JsonWriter.h"
+#include "Logger.h"
+
+std::atomic<bool> Tracer::enabled{ false };
+std::mutex Tracer::registryMutex;
+std::vector<std::unique_ptr<Tracer::Ring>> Tracer::rings;
+std::vector<Tracer::Ring*> Tracer::freeRings;
+
+std::atomic<bool> Tracer::dumpRequested{ false };
+std::mutex Tracer::watcherMutex;
+std::condition_variable_any Tracer::watcherCondition;
+std::jthread Tracer::watcherThread;
+
+namespace {
+	static_assert(std::atomic<bool>::is_always_lock_free, "the signal handler needs a lock-free flag");
+
+	constexpr auto kSignalPollInterval = std::chrono::milliseconds(100);
+#ifdef _WIN32
+	constexpr int kDumpSignal = SIGBREAK;
+#else
+	constexpr int kDumpSignal = SIGUSR1;
+#endif
+
+	struct CollectedSpan {
+		uint32_t threadId;
+		const char* category;
+		const char* name;
+		uint64_t start;
+		uint64_t duration;
+	};
+
+	// Trace-event times are microseconds; keep the nanoseconds as decimals
+	void WriteMicros(JsonWriter& writer, uint64_t nanos)
+	{
+		char text[32];
+		int length = std::snprintf(text, sizeof(text), "%llu.%03u",
+			static_cast<unsigned long long>(nanos / 1000), static_cast<unsigned>(nanos % 1000));
+		writer.Raw(std::string_view(text, static_cast<size_t>(length)));
+	}
+}
+
+Tracer::RingLease::~RingLease()
+{
+	if (ring == nullptr) return;
+	ring->threadName.store(nullptr, std::memory_order_relaxed);
+	std::lock_guard<std::mutex> lock(registryMutex);
+	freeRings.push_back(ring);
+}
+Tracer::RingLease& Tracer::Lease()
+{
+	thread_local RingLease lease;
+	return lease;
+}
+// The ring is allocated on the thread's first span, so threads that never
+// record cost nothing
+Tracer::Ring& Tracer::Local()
+{
+	RingLease& lease = Lease();
+	if (lease.ring == nullptr) {
+		std::lock_guard<std::mutex> lock(registryMutex);
+		if (!freeRings.empty()) {
+			lease.ring = freeRings.back();
+			freeRings.pop_back();
+		}
+		else {
+			rings.push_back(std::make_unique<Ring>());
+			rings.back()->threadId = static_cast<uint32_t>(rings.size());
+			lease.ring = rings.back().get();
+		}
+		lease.ring->threadName.store(lease.threadName, std::memory_order_relaxed);
+	}
+	return *lease.ring;
+}
+void Tracer::Enable(bool on)
+{
+	enabled.store(on, std::memory_order_relaxed);
+}
+void Tracer::Record(const char* category, const char* name, uint64_t start, uint64_t duration)
+{
+	Ring& ring = Local();
+	uint64_t index = ring.head.load(std::memory_order_relaxed);
+	Slot& slot = ring.slots[index % kRingCapacity];
+
+	slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.category.store(category, std::memory_order_relaxed);
+	slot.name.store(name, std::memory_order_relaxed);
+	slot.start.store(start, std::memory_order_relaxed);
+	slot.duration.store(duration, std::memory_order_relaxed);
+	slot.sequence.store(2 * (index + 1), std::memory_order_release);
+	ring.head.store(index + 1, std::memory_order_release);
+}
+void Tracer::NameThread(const char* name)
+{
+	RingLease& lease = Lease();
+	lease.threadName = name;
+	if (lease.ring != nullptr) lease.ring->threadName.store(name, std::memory_order_relaxed);
+}
+size_t Tracer::WriteChromeTrace(std::string& out)
+{
+	std::vector<CollectedSpan> spans;
+	std::vector<std::pair<uint32_t, const char*>> threadNames;
+	{
+		std::lock_guard<std::mutex> lock(registryMutex);
+		for (const auto& ring : rings) {
+			const char* threadName = ring->threadName.load(std::memory_order_relaxed);
+			if (threadName != nullptr) threadNames.emplace_back(ring->threadId, threadName);
+
+			uint64_t head = ring->head.load(std::memory_order_acquire);
+			uint64_t first = head > kRingCapacity ? head - kRingCapacity : 0;
+			for (uint64_t index = first; index < head; index++) {
+				const Slot& slot = ring->slots[index % kRingCapacity];
+				uint64_t before = slot.sequence.load(std::memory_order_acquire);
+				CollectedSpan span{ ring->threadId,
+					slot.category.load(std::memory_order_relaxed),
+					slot.name.load(std::memory_order_relaxed),
+					slot.start.load(std::memory_order_relaxed),
+					slot.duration.load(std::memory_order_relaxed) };
+				std::atomic_thread_fence(std::memory_order_acquire);
+				// Skip slots the owner has started to overwrite meanwhile
+				if (before != 2 * (index + 1) || slot.sequence.load(std::memory_order_relaxed) != before) continue;
+				spans.push_back(span);
+			}
+		}
+	}
+
+	JsonWriter writer(out);
+	writer.BeginObject();
+	writer.Field("displayTimeUnit", "ns");
+	writer.Key("traceEvents");
+	writer.BeginArray();
+	for (const auto& [threadId, threadName] : threadNames) {
+		writer.BeginObject();
+		writer.Key("args");
+		writer.BeginObject();
+		writer.Field("name", threadName);
+		writer.EndObject();
+		writer.Field("name", "thread_name");
+		writer.Field("ph", "M");
+		writer.Field("pid", 1);
+		writer.Field("tid", static_cast<int64_t>(threadId));
+		writer.EndObject();
+	}
+	for (const CollectedSpan& span : spans) {
+		writer.BeginObject();
+		writer.Field("cat", span.category);
+		writer.Key("dur");
+		WriteMicros(writer, span.duration);
+		writer.Field("name", span.name);
+		writer.Field("ph", "X");
+		writer.Field("pid", 1);
+		writer.Field("tid", static_cast<int64_t>(span.threadId));
+		writer.Key("ts");
+		WriteMicros(writer, span.start);
+		writer.EndObject();
+	}
+	writer.EndArray();
+	writer.EndObject();
+	return spans.size();
+}
+bool Tracer::Dump(std::string& path, size_t& eventCount)
+{
+	auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+	path = "trace_" + std::to_string(millis) + ".json";
+
+	std::string data;
+	eventCount = WriteChromeTrace(data);
+	if (!FileApi::WriteAtomically(path, data)) {
+		Logger::Error<LogFormat::TRACE_DUMP_FAILED>(path);
+		return false;
+	}
+	Logger::Info<LogFormat::TRACE_DUMP_WRITTEN>(eventCount, path);
+	return true;
+}
+void Tracer::SignalHandler(int)
+{
+	// Only a lock-free store is safe here; the watcher does the dump
+	dumpRequested.store(true, std::memory_order_relaxed);
+	std::signal(kDumpSignal, &Tracer::SignalHandler);
+}
+void Tracer::DumpOnSignal()
+{
+	std::lock_guard<std::mutex> lock(watcherMutex);
+	if (watcherThread.joinable()) return;
+	std::signal(kDumpSignal, &Tracer::SignalHandler);
+	watcherThread = std::jthread(&Tracer::WatchSignals);
+}
+void Tracer::StopSignalWatcher()
+{
+	std::jthread watcher;
+	{
+		std::lock_guard<std::mutex> lock(watcherMutex);
+		watcher = std::move(watcherThread);
+	}
+	if (!watcher.joinable()) return;
+	// The stop request wakes the watcher at once
+	watcher.request_stop();
+	watcher.join();
+	std::signal(kDumpSignal, SIG_DFL);
+}
+void Tracer::WatchSignals(std::stop_token stopToken)
+{
+	std::unique_lock<std::mutex> lock(watcherMutex);
+	while (!stopToken.stop_requested()) {
+		// The handler cannot notify, so poll the flag
+		watcherCondition.wait_for(lock, stopToken, kSignalPollInterval, [] { return false; });
+		if (!dumpRequested.exchange(false, std::memory_order_relaxed)) continue;
+
+		lock.unlock();
+		std::string path;
+		size_t eventCount = 0;
+		Dump(path, eventCount);
+		lock.lock();
+	}
+}
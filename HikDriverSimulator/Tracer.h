@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Trace spans are compiled in unless HIK_TRACING is 0. Compiled in, a span
+// costs one relaxed load while tracing is off; compiled out, HIK_TRACE_SCOPE
+// expands to nothing and its arguments are never evaluated.
+#ifndef HIK_TRACING
+#define HIK_TRACING 1
+#endif
+
+#if HIK_TRACING
+#define HIK_TRACE_CONCAT_(a, b) a##b
+#define HIK_TRACE_CONCAT(a, b) HIK_TRACE_CONCAT_(a, b)
+// Time the rest of the enclosing scope. Category and name must outlive the
+// process (string literals), since only the pointers are recorded.
+#define HIK_TRACE_SCOPE(category, name) TraceSpan HIK_TRACE_CONCAT(traceSpan, __LINE__)(category, name)
+#else
+#define HIK_TRACE_SCOPE(category, name) ((void)0)
+#endif
+
+// Process-wide span recorder. Every thread appends completed spans to its
+// own ring buffer, overwriting the oldest once it is full, so recording
+// never locks or allocates after a thread's first span. Dump merges the
+// rings into Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev).
+class Tracer
+{
+public:
+	static constexpr bool kCompiledIn = HIK_TRACING != 0;
+	// Spans kept per thread, 40 bytes each
+	static constexpr size_t kRingCapacity = 16384;
+
+	static void Enable(bool enabled);
+	static bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+	static uint64_t Now() {
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+	static void Record(const char* category, const char* name, uint64_t start, uint64_t duration);
+	// Label the calling thread in dumps; name must be a string literal
+	static void NameThread(const char* name);
+
+	// Append every recorded span as a trace-event JSON document
+	static size_t WriteChromeTrace(std::string& out);
+	// Write trace_<unix ms>.json in the working directory; path receives its name
+	static bool Dump(std::string& path, size_t& eventCount);
+
+	// Dump on SIGUSR1 (SIGBREAK on Windows), from a watcher thread
+	static void DumpOnSignal();
+	static void StopSignalWatcher();
+
+private:
+	// Seqlock per slot: sequence is odd while the owner rewrites the slot and
+	// 2 * (index + 1) once span number index is complete
+	struct Slot {
+		std::atomic<uint64_t> sequence{ 0 };
+		std::atomic<const char*> category{ nullptr };
+		std::atomic<const char*> name{ nullptr };
+		std::atomic<uint64_t> start{ 0 };
+		std::atomic<uint64_t> duration{ 0 };
+	};
+	struct Ring {
+		uint32_t threadId = 0;
+		std::atomic<const char*> threadName{ nullptr };
+		std::atomic<uint64_t> head{ 0 };
+		std::unique_ptr<Slot[]> slots{ new Slot[kRingCapacity] };
+	};
+	// Holds the calling thread's ring; gives it back when the thread exits
+	struct RingLease {
+		Ring* ring = nullptr;
+		const char* threadName = nullptr;
+		~RingLease();
+	};
+
+	static std::atomic<bool> enabled;
+	static std::mutex registryMutex;
+	static std::vector<std::unique_ptr<Ring>> rings;
+	static std::vector<Ring*> freeRings;
+
+	static std::atomic<bool> dumpRequested;
+	static std::mutex watcherMutex;
+	static std::condition_variable_any watcherCondition;
+	// Stopped and joined on destruction at the latest, so the watcher never
+	// outlives the statics it uses
+	static std::jthread watcherThread;
+
+	static RingLease& Lease();
+	static Ring& Local();
+	static void SignalHandler(int signal);
+	static void WatchSignals(std::stop_token stopToken);
+};
+
+// Records the time from its construction to the end of the scope, if tracing
+// was on when it started. Use through HIK_TRACE_SCOPE.
+class TraceSpan
+{
+public:
+	TraceSpan(const char* category, const char* name)
+		: category(category), name(name), start(Tracer::IsEnabled() ? Tracer::Now() : 0) {}
+	~TraceSpan() {
+		if (start != 0) Tracer::Record(category, name, start, Tracer::Now() - start);
+	}
+	TraceSpan(const TraceSpan&) = delete;
+	TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+	const char* category;
+	const char* name;
+	uint64_t start;
+};
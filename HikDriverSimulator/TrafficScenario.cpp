@@ -0,0 +1,146 @@
+#include "TrafficScenario.h"
+#include <fstream>
+#include <sstream>
+#include <nlohmann/json.hpp>
+#include "CommandParser.h"
+
+using json = nlohmann::json;
+
+namespace {
+	constexpr const char* kOperationNames[kTrafficOperationCount] = {
+		"STATUS", "TRIGGER", "ARM", "DISARM", "BYPASS", "UNBYPASS",
+		"ACTIVE", "TAMPER", "FAULT", "LIST_ALL_ZONES", "ARM_PARTITION", "DISARM_PARTITION"
+	};
+	constexpr size_t kMaxScheduledPartitions = 100000;
+
+	bool IsPartitionOperation(TrafficOperation operation)
+	{
+		return operation == TrafficOperation::ARM_PARTITION || operation == TrafficOperation::DISARM_PARTITION;
+	}
+	bool ParseStream(const json& item, TrafficStream& stream, std::string& error)
+	{
+		std::string operation = item.at("operation").get<std::string>();
+		if (!TrafficScenarioLoader::ParseOperation(operation, stream.operation) || IsPartitionOperation(stream.operation)) {
+			error = "unknown stream operation '" + operation + "'";
+			return false;
+		}
+		stream.rate = item.at("rate").get<double>();
+		if (!(stream.rate > 0.0)) {
+			error = "stream rate must be positive";
+			return false;
+		}
+		std::string arrival = item.value("arrival", std::string("poisson"));
+		if (CommandParser::EqualsIgnoreCase(arrival, "POISSON")) stream.arrival = ArrivalPattern::POISSON;
+		else if (CommandParser::EqualsIgnoreCase(arrival, "BURSTY")) stream.arrival = ArrivalPattern::BURSTY;
+		else {
+			error = "unknown arrival '" + arrival + "'";
+			return false;
+		}
+		stream.burst = item.value("burst", stream.arrival == ArrivalPattern::BURSTY ? 10u : 1u);
+		if (stream.burst == 0) stream.burst = 1;
+		return true;
+	}
+	bool ParseAction(const json& item, ScheduledAction& action, std::string& error)
+	{
+		std::string operation = item.at("operation").get<std::string>();
+		if (!TrafficScenarioLoader::ParseOperation(operation, action.operation) || !IsPartitionOperation(action.operation)) {
+			error = "schedule operation must be ARM_PARTITION or DISARM_PARTITION, not '" + operation + "'";
+			return false;
+		}
+		action.atSeconds = item.value("at", 0.0);
+		action.everySeconds = item.value("every", 0.0);
+		if (action.atSeconds < 0.0 || action.everySeconds < 0.0) {
+			error = "schedule times must not be negative";
+			return false;
+		}
+		std::string partitions = item.value("partitions", std::string("all"));
+		if (!CommandParser::EqualsIgnoreCase(partitions, "ALL")
+			&& !CommandParser::ParseIdList(partitions, action.partitionIds, kMaxScheduledPartitions)) {
+			error = "bad partition list '" + partitions + "'";
+			return false;
+		}
+		return true;
+	}
+}
+
+bool TrafficScenarioLoader::ParseOperation(std::string_view name, TrafficOperation& operation)
+{
+	for (size_t i = 0; i < kTrafficOperationCount; i++) {
+		if (CommandParser::EqualsIgnoreCase(name, kOperationNames[i])) {
+			operation = static_cast<TrafficOperation>(i);
+			return true;
+		}
+	}
+	return false;
+}
+const char* TrafficScenarioLoader::OperationName(TrafficOperation operation)
+{
+	return kOperationNames[static_cast<size_t>(operation)];
+}
+bool TrafficScenarioLoader::Load(const std::string& path, TrafficScenario& scenario, std::string& error)
+{
+	std::ifstream file(path);
+	if (!file.is_open()) {
+		error = "cannot open " + path;
+		return false;
+	}
+	std::stringstream buffer;
+	buffer << file.rdbuf();
+	return Parse(buffer.str(), scenario, error);
+}
+bool TrafficScenarioLoader::Parse(const std::string& text, TrafficScenario& scenario, std::string& error)
+{
+	scenario = TrafficScenario();
+	try {
+		json root = json::parse(text);
+		scenario.name = root.value("name", std::string("unnamed"));
+		scenario.durationSeconds = root.value("durationSeconds", scenario.durationSeconds);
+		scenario.zones = root.value("zones", scenario.zones);
+		scenario.partitions = root.value("partitions", scenario.partitions);
+		scenario.threads = root.value("threads", scenario.threads);
+		scenario.seed = root.value("seed", scenario.seed);
+		scenario.journal = root.value("journal", scenario.journal);
+
+		if (!(scenario.durationSeconds > 0.0)) {
+			error = "durationSeconds must be positive";
+			return false;
+		}
+		if (scenario.zones == 0 || scenario.zones > kMaxZones || scenario.partitions == 0 || scenario.partitions > scenario.zones) {
+			error = "need 1.." + std::to_string(kMaxZones) + " zones and 1..zones partitions";
+			return false;
+		}
+		if (scenario.threads == 0 || scenario.threads > kMaxThreads) {
+			error = "threads must be 1.." + std::to_string(kMaxThreads);
+			return false;
+		}
+		if (root.contains("delays")) {
+			for (const auto& [kindName, value] : root.at("delays").items()) {
+				DelayKind kind;
+				if (!AlarmService::ParseDelayKind(kindName, kind)) {
+					error = "unknown delay '" + kindName + "'";
+					return false;
+				}
+				scenario.delays.emplace_back(kind, value.get<uint32_t>());
+			}
+		}
+		for (const auto& item : root.value("streams", json::array())) {
+			TrafficStream stream;
+			if (!ParseStream(item, stream, error)) return false;
+			scenario.streams.push_back(stream);
+		}
+		for (const auto& item : root.value("schedule", json::array())) {
+			ScheduledAction action;
+			if (!ParseAction(item, action, error)) return false;
+			scenario.schedule.push_back(std::move(action));
+		}
+		if (scenario.streams.empty() && scenario.schedule.empty()) {
+			error = "scenario has no streams and no schedule";
+			return false;
+		}
+	}
+	catch (const json::exception& e) {
+		error = e.what();
+		return false;
+	}
+	return true;
+}
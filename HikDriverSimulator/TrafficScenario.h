@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "AlarmService.h"
+
+// What one simulated request does to the AlarmService
+enum class TrafficOperation : uint8_t {
+	STATUS,
+	TRIGGER,
+	ARM,
+	DISARM,
+	BYPASS,
+	UNBYPASS,
+	ACTIVE,				// sensor input, through the debounce pipeline
+	TAMPER,
+	FAULT,
+	LIST_ALL_ZONES,
+	ARM_PARTITION,
+	DISARM_PARTITION
+};
+constexpr size_t kTrafficOperationCount = 12;
+
+enum class ArrivalPattern : uint8_t {
+	POISSON,			// independent arrivals at the given mean rate
+	BURSTY				// Poisson bursts of `burst` events on one zone
+};
+
+// Open-loop request stream against random zones
+struct TrafficStream {
+	TrafficOperation operation = TrafficOperation::STATUS;
+	double rate = 0.0;	// events per second, over all threads
+	ArrivalPattern arrival = ArrivalPattern::POISSON;
+	uint32_t burst = 1;
+};
+
+// Partition arm/disarm at fixed times, e.g. the evening arm of a site
+struct ScheduledAction {
+	double atSeconds = 0.0;
+	double everySeconds = 0.0;	// 0 runs once
+	TrafficOperation operation = TrafficOperation::ARM_PARTITION;
+	std::vector<int> partitionIds;	// empty for every partition
+};
+
+struct TrafficScenario {
+	std::string name;
+	double durationSeconds = 10.0;
+	size_t zones = 1000;
+	size_t partitions = 8;
+	size_t threads = 2;
+	uint64_t seed = 1;
+	bool journal = false;	// journal state changes and wait until durable
+	std::vector<std::pair<DelayKind, uint32_t>> delays;	// applied to every zone/partition
+	std::vector<TrafficStream> streams;
+	std::vector<ScheduledAction> schedule;
+};
+
+// Reads scenario files (JSON, see Scenarios/ and the README)
+class TrafficScenarioLoader
+{
+public:
+	static constexpr size_t kMaxZones = 10000000;
+	static constexpr size_t kMaxThreads = 256;
+
+	static bool Load(const std::string& path, TrafficScenario& scenario, std::string& error);
+	static bool Parse(const std::string& text, TrafficScenario& scenario, std::string& error);
+	static bool ParseOperation(std::string_view name, TrafficOperation& operation);
+	static const char* OperationName(TrafficOperation operation);
+};
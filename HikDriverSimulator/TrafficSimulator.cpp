@@ -0,0 +1,294 @@
+#include "TrafficSimulator.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <nlohmann/json.hpp>
+#include "Logger.h"
+
+using json = nlohmann::json;
+
+namespace {
+	constexpr const char* kSimulationLog = "simulation.log";
+	constexpr const char* kSimulationJournal = "simulation_journal.bin";
+
+	uint64_t Nanos(std::chrono::steady_clock::duration duration)
+	{
+		auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+		return nanos > 0 ? static_cast<uint64_t>(nanos) : 0;
+	}
+	double Micros(uint64_t nanos)
+	{
+		return static_cast<double>(nanos) / 1000.0;
+	}
+	bool ChangesState(TrafficOperation operation)
+	{
+		switch (operation) {
+		case TrafficOperation::STATUS:
+		case TrafficOperation::LIST_ALL_ZONES:
+		case TrafficOperation::ACTIVE:
+		case TrafficOperation::TAMPER:
+		case TrafficOperation::FAULT:
+			return false;
+		default:
+			return true;
+		}
+	}
+	json HistogramJson(const LatencyHistogram& histogram)
+	{
+		json out;
+		out["count"] = histogram.Count();
+		out["meanMicros"] = histogram.Mean() / 1000.0;
+		out["p50Micros"] = Micros(histogram.Percentile(50.0));
+		out["p90Micros"] = Micros(histogram.Percentile(90.0));
+		out["p99Micros"] = Micros(histogram.Percentile(99.0));
+		out["p999Micros"] = Micros(histogram.Percentile(99.9));
+		out["maxMicros"] = Micros(histogram.Max());
+		return out;
+	}
+	void PrintRow(std::ostream& out, const std::string& label, const LatencyHistogram& histogram)
+	{
+		out << std::left << std::setw(18) << label << std::right
+			<< std::setw(10) << histogram.Count()
+			<< std::setw(10) << histogram.Mean() / 1000.0;
+		for (double percentile : { 50.0, 90.0, 99.0, 99.9 }) {
+			out << std::setw(10) << Micros(histogram.Percentile(percentile));
+		}
+		out << std::setw(10) << Micros(histogram.Max()) << "\n";
+	}
+}
+
+TrafficSimulator::TrafficSimulator(const TrafficScenario& scenario)
+	: scenario(scenario)
+{
+}
+TrafficSimulator::Clock::duration TrafficSimulator::RandomGap(double meanSeconds, std::mt19937_64& random)
+{
+	std::exponential_distribution<double> gap(1.0 / meanSeconds);
+	return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(gap(random)));
+}
+bool TrafficSimulator::Execute(TrafficOperation operation, int id, bool value)
+{
+	// The string forms, so the cost includes the response JSON as over TCP
+	switch (operation) {
+	case TrafficOperation::STATUS: service.GetZoneStatus(id); break;
+	case TrafficOperation::TRIGGER: service.TriggerZone(id); break;
+	case TrafficOperation::ARM: service.ArmZone(id); break;
+	case TrafficOperation::DISARM: service.DisarmZone(id); break;
+	case TrafficOperation::BYPASS: service.BypassZone(id, true); break;
+	case TrafficOperation::UNBYPASS: service.BypassZone(id, false); break;
+	case TrafficOperation::LIST_ALL_ZONES: service.ListAllZones(); break;
+	case TrafficOperation::ARM_PARTITION: service.ArmPartition(id); break;
+	case TrafficOperation::DISARM_PARTITION: service.DisarmPartition(id); break;
+	case TrafficOperation::ACTIVE:
+		return service.Sensors().Submit({ id, SensorInput::ACTIVE, value });
+	case TrafficOperation::TAMPER:
+		return service.Sensors().Submit({ id, SensorInput::TAMPER, value });
+	case TrafficOperation::FAULT:
+		return service.Sensors().Submit({ id, SensorInput::FAULT, value });
+	}
+	if (scenario.journal && ChangesState(operation)) service.SyncJournal();
+	return true;
+}
+void TrafficSimulator::Worker(size_t index, Clock::time_point start, Clock::time_point end, WorkerStats& stats)
+{
+	std::mt19937_64 random(scenario.seed * 1000003 + index);
+	std::uniform_int_distribution<int> zonePick(1, static_cast<int>(scenario.zones));
+
+	std::vector<StreamState> states;
+	for (const auto& stream : scenario.streams) {
+		StreamState state;
+		state.stream = &stream;
+		// A burst is one arrival of the Poisson process
+		double rate = stream.rate / static_cast<double>(scenario.threads);
+		if (stream.arrival == ArrivalPattern::BURSTY) rate /= stream.burst;
+		state.meanGapSeconds = 1.0 / rate;
+		state.due = start + RandomGap(state.meanGapSeconds, random);
+		states.push_back(state);
+	}
+
+	while (!states.empty()) {
+		auto next = std::min_element(states.begin(), states.end(),
+			[](const StreamState& a, const StreamState& b) { return a.due < b.due; });
+		if (next->due >= end) break;
+		if (Clock::now() < next->due) std::this_thread::sleep_until(next->due);
+
+		Clock::time_point due = next->due;
+		TrafficOperation operation = next->stream->operation;
+		int zoneId;
+		bool value;
+		if (next->stream->arrival == ArrivalPattern::BURSTY) {
+			// One zone chattering: set, clear, set, ... back to back
+			if (next->burstLeft == 0) {
+				next->burstLeft = next->stream->burst;
+				next->burstZone = zonePick(random);
+				next->burstValue = false;
+			}
+			zoneId = next->burstZone;
+			value = next->burstValue = !next->burstValue;
+			if (--next->burstLeft == 0) next->due += RandomGap(next->meanGapSeconds, random);
+		}
+		else {
+			zoneId = zonePick(random);
+			value = (random() & 1) != 0;
+			next->due += RandomGap(next->meanGapSeconds, random);
+		}
+
+		auto started = Clock::now();
+		if (!Execute(operation, zoneId, value)) stats.sensorRejected++;
+		auto finished = Clock::now();
+		stats.latency[static_cast<size_t>(operation)].Record(Nanos(finished - due));
+		stats.startLag.Record(Nanos(started - due));
+	}
+}
+void TrafficSimulator::RunSchedule(Clock::time_point start, Clock::time_point end, WorkerStats& stats)
+{
+	struct Planned {
+		Clock::time_point due;
+		const ScheduledAction* action;
+	};
+	std::vector<Planned> plan;
+	for (const auto& action : scenario.schedule) {
+		for (double at = action.atSeconds; at < scenario.durationSeconds; at += action.everySeconds) {
+			plan.push_back({ start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(at)), &action });
+			if (action.everySeconds <= 0.0) break;
+		}
+	}
+	std::stable_sort(plan.begin(), plan.end(), [](const Planned& a, const Planned& b) { return a.due < b.due; });
+
+	std::vector<int> allPartitions(scenario.partitions);
+	for (size_t i = 0; i < allPartitions.size(); i++) {
+		allPartitions[i] = static_cast<int>(i) + 1;
+	}
+	for (const auto& planned : plan) {
+		if (planned.due >= end) break;
+		std::this_thread::sleep_until(planned.due);
+		const auto& partitionIds = planned.action->partitionIds.empty() ? allPartitions : planned.action->partitionIds;
+		for (int partitionId : partitionIds) {
+			Execute(planned.action->operation, partitionId, true);
+			stats.latency[static_cast<size_t>(planned.action->operation)].Record(Nanos(Clock::now() - planned.due));
+		}
+	}
+}
+TrafficReport TrafficSimulator::Run()
+{
+	service.LoadSyntheticSite(scenario.zones, scenario.partitions, scenario.journal ? kSimulationJournal : "");
+	for (const auto& [kind, milliseconds] : scenario.delays) {
+		bool perPartition = kind == DelayKind::EXIT || kind == DelayKind::SIREN;
+		std::vector<int> ids(perPartition ? scenario.partitions : scenario.zones);
+		for (size_t i = 0; i < ids.size(); i++) {
+			ids[i] = static_cast<int>(i) + 1;
+		}
+		CommandStatus status;
+		service.SetDelay(kind, ids, milliseconds, status);
+	}
+
+	TrafficReport report;
+	report.scenario = scenario.name;
+	report.durationSeconds = scenario.durationSeconds;
+	for (const auto& stream : scenario.streams) {
+		report.targetRate += stream.rate;
+	}
+
+	// Heap-allocated: a WorkerStats is about 100 KiB
+	std::vector<std::unique_ptr<WorkerStats>> workerStats;
+	for (size_t i = 0; i <= scenario.threads; i++) {
+		workerStats.push_back(std::make_unique<WorkerStats>());
+	}
+	auto start = Clock::now();
+	auto end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(scenario.durationSeconds));
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < scenario.threads; i++) {
+		threads.emplace_back(&TrafficSimulator::Worker, this, i, start, end, std::ref(*workerStats[i]));
+	}
+	threads.emplace_back(&TrafficSimulator::RunSchedule, this, start, end, std::ref(*workerStats.back()));
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	report.elapsedSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	for (size_t i = 0; i < workerStats.size(); i++) {
+		const WorkerStats& stats = *workerStats[i];
+		for (size_t op = 0; op < kTrafficOperationCount; op++) {
+			report.latency[op].Merge(stats.latency[op]);
+			if (i < scenario.threads) report.streamEvents += stats.latency[op].Count();
+		}
+		report.startLag.Merge(stats.startLag);
+		report.sensorRejected += stats.sensorRejected;
+	}
+	report.sensors = service.Sensors().Stats();
+	report.timers = service.TimerStatistics();
+	return report;
+}
+void TrafficSimulator::PrintReport(const TrafficReport& report, std::ostream& out)
+{
+	double achieved = report.elapsedSeconds > 0.0 ? static_cast<double>(report.streamEvents) / report.elapsedSeconds : 0.0;
+	out << std::fixed << std::setprecision(1);
+	out << "Scenario '" << report.scenario << "': " << report.elapsedSeconds << " s\n";
+	out << "Throughput: " << achieved << " events/s achieved, " << report.targetRate << " targeted";
+	if (report.targetRate > 0.0) out << " (" << achieved / report.targetRate * 100.0 << "%)";
+	out << "\n\nLatency from planned arrival, microseconds\n";
+	out << std::left << std::setw(18) << "Operation" << std::right << std::setw(10) << "Count" << std::setw(10) << "Mean"
+		<< std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99" << std::setw(10) << "p99.9"
+		<< std::setw(10) << "Max" << "\n";
+	for (size_t op = 0; op < kTrafficOperationCount; op++) {
+		if (report.latency[op].Count() == 0) continue;
+		PrintRow(out, TrafficScenarioLoader::OperationName(static_cast<TrafficOperation>(op)), report.latency[op]);
+	}
+	PrintRow(out, "(start lag)", report.startLag);
+	out << "\nSensors: " << report.sensors.received << " queued, " << report.sensors.dropped << " dropped, "
+		<< report.sensors.forwarded << " forwarded after debounce\n";
+	out << "Timers: " << report.timers.fired << " fired, " << report.timers.pending << " pending, max lag "
+		<< report.timers.maxLagMicros << " us\n";
+}
+bool TrafficSimulator::WriteReport(const TrafficReport& report, const std::string& path)
+{
+	json out;
+	out["scenario"] = report.scenario;
+	out["durationSeconds"] = report.durationSeconds;
+	out["elapsedSeconds"] = report.elapsedSeconds;
+	out["targetRate"] = report.targetRate;
+	out["streamEvents"] = report.streamEvents;
+	out["achievedRate"] = report.elapsedSeconds > 0.0 ? static_cast<double>(report.streamEvents) / report.elapsedSeconds : 0.0;
+	out["sensorRejected"] = report.sensorRejected;
+	json operations = json::object();
+	for (size_t op = 0; op < kTrafficOperationCount; op++) {
+		if (report.latency[op].Count() == 0) continue;
+		operations[TrafficScenarioLoader::OperationName(static_cast<TrafficOperation>(op))] = HistogramJson(report.latency[op]);
+	}
+	out["operations"] = operations;
+	out["startLag"] = HistogramJson(report.startLag);
+	out["sensors"] = { { "received", report.sensors.received }, { "dropped", report.sensors.dropped },
+		{ "forwarded", report.sensors.forwarded } };
+	out["timers"] = { { "fired", report.timers.fired }, { "pending", report.timers.pending },
+		{ "maxLagMicros", report.timers.maxLagMicros } };
+
+	std::ofstream file(path);
+	if (!file.is_open()) return false;
+	file << out.dump(2) << "\n";
+	return file.good();
+}
+int TrafficSimulator::RunFromCommandLine(const std::string& scenarioPath, const std::string& reportPath)
+{
+	TrafficScenario scenario;
+	std::string error;
+	if (!TrafficScenarioLoader::Load(scenarioPath, scenario, error)) {
+		std::cerr << "Invalid scenario " << scenarioPath << ": " << error << std::endl;
+		return 1;
+	}
+	Logger::Init(kSimulationLog, false);
+	TrafficReport report;
+	{
+		TrafficSimulator simulator(scenario);
+		report = simulator.Run();
+	}
+	PrintReport(report, std::cout);
+	int exitCode = 0;
+	if (!reportPath.empty() && !WriteReport(report, reportPath)) {
+		std::cerr << "Failed to write report " << reportPath << std::endl;
+		exitCode = 1;
+	}
+	Logger::Shutdown();
+	return exitCode;
+}
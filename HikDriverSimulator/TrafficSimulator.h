@@ -0,0 +1,75 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "AlarmService.h"
+#include "LatencyHistogram.h"
+#include "TrafficScenario.h"
+
+struct TrafficReport {
+	std::string scenario;
+	double durationSeconds = 0.0;
+	double elapsedSeconds = 0.0;
+	double targetRate = 0.0;		// stream events per second asked for
+	uint64_t streamEvents = 0;
+	uint64_t sensorRejected = 0;	// sensor queue full
+	// Per operation, from each request's planned arrival to its completion,
+	// so time spent waiting behind a slow request counts
+	std::array<LatencyHistogram, kTrafficOperationCount> latency;
+	// How late requests started against their planned arrival
+	LatencyHistogram startLag;
+	SensorStats sensors;
+	TimerStats timers;
+};
+
+// Drives an in-process AlarmService with the open-loop traffic of a
+// scenario: every worker thread runs a share of each stream on its own
+// arrival clock, independent of how fast the service answers, and a
+// schedule thread runs the partition arm/disarm plan. The site is synthetic;
+// the usual state files are neither read nor written.
+class TrafficSimulator
+{
+public:
+	explicit TrafficSimulator(const TrafficScenario& scenario);
+	TrafficSimulator(const TrafficSimulator&) = delete;
+	TrafficSimulator& operator=(const TrafficSimulator&) = delete;
+
+	TrafficReport Run();
+
+	static void PrintReport(const TrafficReport& report, std::ostream& out);
+	static bool WriteReport(const TrafficReport& report, const std::string& path);
+	// --simulate <scenario.json> [--report <out.json>]; returns the exit code
+	static int RunFromCommandLine(const std::string& scenarioPath, const std::string& reportPath);
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct WorkerStats {
+		std::array<LatencyHistogram, kTrafficOperationCount> latency;
+		LatencyHistogram startLag;
+		uint64_t sensorRejected = 0;
+	};
+	// One stream's arrival clock on one worker
+	struct StreamState {
+		const TrafficStream* stream = nullptr;
+		double meanGapSeconds = 0.0;
+		Clock::time_point due;
+		uint32_t burstLeft = 0;
+		int burstZone = 0;
+		bool burstValue = false;
+	};
+
+	const TrafficScenario& scenario;
+	AlarmService service;
+
+	void Worker(size_t index, Clock::time_point start, Clock::time_point end, WorkerStats& stats);
+	void RunSchedule(Clock::time_point start, Clock::time_point end, WorkerStats& stats);
+	// False only for a sensor event the queue rejected
+	bool Execute(TrafficOperation operation, int id, bool value);
+	static Clock::duration RandomGap(double meanSeconds, std::mt19937_64& random);
+};
@@ -17,45 +17,46 @@ Zone::Zone(int zoneId, const std::string& zoneName, int newPartitionId = -1)
 }
 Zone::~Zone() {}
 
-void Zone::Arm()
+void Zone::Arm(bool log)
 {
 	if (isArmed)
 	{
-		Logger::Info("Zone " + std::to_string(id) + " (" + name + ") is already armed.");
+		if (log) Logger::Info<LogFormat::ZONE_ALREADY_ARMED>(id, name);
 		return;
 	}
 	if (!isBypassed)
 	{
 		isArmed = true;
 		isAlarming = false;
-		Logger::Info("Zone " + std::to_string(id) + " (" + name + ") is armed.");
+		if (log) Logger::Info<LogFormat::ZONE_ARMED>(id, name);
 	}
-	else
+	else if (log)
 	{
-		Logger::Info("Zone " + std::to_string(id) + " (" + name + ") cannot be armed because it is bypassed.");
+		Logger::Info<LogFormat::ZONE_ARM_BLOCKED_BY_BYPASS>(id, name);
 	}
 }
-void Zone::Disarm()
+void Zone::Disarm(bool log)
 {
 	if (!isArmed)
 	{
-		Logger::Info("Zone " + std::to_string(id) + " (" + name + ") is already disarmed.");
+		if (log) Logger::Info<LogFormat::ZONE_ALREADY_DISARMED>(id, name);
 		return;
 	}
 	isArmed = false;
 	isAlarming = false;
-	Logger::Info("Zone " + std::to_string(id) + " (" + name + ") is disarmed.");
+	if (log) Logger::Info<LogFormat::ZONE_DISARMED>(id, name);
 }
-void Zone::SetBypass(bool bypassState)
+void Zone::SetBypass(bool bypassState, bool log)
 {
 	isBypassed = bypassState;
+	if (!log) return;
 	if (bypassState)
 	{
-		Logger::Info("Zone " + std::to_string(id) + " (" + name + ") is bypassed.");
+		Logger::Info<LogFormat::ZONE_BYPASSED>(id, name);
 	}
 	else
 	{
-		Logger::Info("Zone " + std::to_string(id) + " (" + name + ") is unbypassed.");
+		Logger::Info<LogFormat::ZONE_UNBYPASSED>(id, name);
 	}
 
 }
@@ -67,15 +68,15 @@ void Zone::SetTampered(bool tampered)
 	isTampered = tampered;
 	if (tampered) 
 	{ 
-		Logger::Warning("Zone " + std::to_string(id) + " (" + name + ") is tampered!"); 
+		Logger::Warning<LogFormat::ZONE_TAMPERED>(id, name); 
 		if (isArmed) {
 			isAlarming = true;
-			Logger::Warning("ALARM on Zone " + std::to_string(id) + " (" + name + ")!");
+			Logger::Warning<LogFormat::ZONE_ALARM>(id, name);
 		}
 	}
 	else 
 	{ 
-		Logger::Info("Zone " + std::to_string(id) + " (" + name + ") tamper cleared."); 
+		Logger::Info<LogFormat::ZONE_TAMPER_CLEARED>(id, name); 
 	}
 }
 void Zone::SetFaulted(bool faulted) 
@@ -83,31 +84,31 @@ void Zone::SetFaulted(bool faulted)
 	this->isFaulted = faulted;
 	if (faulted) 
 	{ 
-		Logger::Warning("Zone " + std::to_string(id) + " (" + name + ") is faulted!"); 
+		Logger::Warning<LogFormat::ZONE_FAULTED>(id, name); 
 		if (isArmed) {
 			isAlarming = true;
-			Logger::Warning("ALARM on Zone " + std::to_string(id) + " (" + name + ")!");
+			Logger::Warning<LogFormat::ZONE_ALARM>(id, name);
 		}
 	}
 	else
 	{ 
-		Logger::Info("Zone " + std::to_string(id) + " (" + name + ") fault cleared."); 
+		Logger::Info<LogFormat::ZONE_FAULT_CLEARED>(id, name); 
 	}
 }
-void Zone::SetActive(bool active) 
+void Zone::SetActive(bool active, bool raiseAlarm) 
 { 
 	this->isActive = active; 
 	if (active) 
 	{ 
-		Logger::Info("Zone " + std::to_string(id) + " (" + name + ") is active."); 
-		if (isArmed) {
+		Logger::Info<LogFormat::ZONE_ACTIVE>(id, name); 
+		if (raiseAlarm && isArmed && !isBypassed) {
 			isAlarming = true;
-			Logger::Warning("ALARM on Zone " + std::to_string(id) + " (" + name + ")!");
+			Logger::Warning<LogFormat::ZONE_ALARM>(id, name);
 		}
 	}
 	else 
 	{ 
-		Logger::Info("Zone " + std::to_string(id) + " (" + name + ") is inactive."); 
+		Logger::Info<LogFormat::ZONE_INACTIVE>(id, name); 
 	}
 
 }
@@ -16,12 +16,14 @@ public:
 
 	Zone(int zoneId, const std::string& zoneName, int newPartitionId);
 	virtual ~Zone();
-	void Arm();
-	void Disarm();
-	void SetBypass(bool active);
+	// log = false keeps batch commands to one summary line
+	void Arm(bool log = true);
+	void Disarm(bool log = true);
+	void SetBypass(bool active, bool log = true);
 	virtual const std::string GetType();
 	void SetPartitionId(int nemPartitionId);
 	void SetTampered(bool tampered);
 	void SetFaulted(bool faulted);
-	void SetActive(bool active);
+	// raiseAlarm = false leaves an armed zone quiet (its entry delay decides)
+	void SetActive(bool active, bool raiseAlarm = true);
 };
\ No newline at end of file
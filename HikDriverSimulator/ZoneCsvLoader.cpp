@@ -0,0 +1,192 @@
+#include "ZoneCsvLoader.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+#include <unordered_set>
+#include "MappedFile.h"
+#include "ZoneFactory.h"
+
+namespace {
+	struct Chunk {
+		std::string_view text;
+		size_t lineCount = 0;
+		// Line numbers are chunk-relative until the chunks are merged
+		std::vector<std::shared_ptr<Zone>> zones;
+		std::vector<size_t> zoneLines;
+		std::vector<CsvLineIssue> skipped;
+		std::vector<CsvLineIssue> warnings;
+	};
+
+	std::string_view Trim(std::string_view text) {
+		while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+		while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+		return text;
+	}
+
+	bool ParseInt(std::string_view text, int& value) {
+		text = Trim(text);
+		if (text.empty()) return false;
+		auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+		return result.ec == std::errc() && result.ptr == text.data() + text.size();
+	}
+
+	void ParseLine(Chunk& chunk, std::string_view line) {
+		size_t lineNumber = chunk.lineCount;
+		// Fields after the fourth are ignored
+		std::string_view fields[4];
+		size_t fieldCount = 0;
+		while (fieldCount < 4) {
+			size_t separator = line.find(';');
+			fields[fieldCount++] = line.substr(0, separator);
+			if (separator == std::string_view::npos) break;
+			line.remove_prefix(separator + 1);
+			if (line.empty()) break;
+		}
+		if (fieldCount < 3) {
+			chunk.skipped.push_back({ lineNumber, "expected id;type;name[;partitionId]" });
+			return;
+		}
+		int zoneId;
+		if (!ParseInt(fields[0], zoneId)) {
+			chunk.skipped.push_back({ lineNumber, "bad zone id" });
+			return;
+		}
+		int partitionId = -1;
+		if (fieldCount == 4 && !ParseInt(fields[3], partitionId)) {
+			partitionId = -1;
+			chunk.warnings.push_back({ lineNumber, "bad partition id, zone " + std::to_string(zoneId) + " has no partition" });
+		}
+		chunk.zones.push_back(ZoneFactory::Create(ZoneFactory::KindFromTypeName(fields[1]),
+			zoneId, std::string(fields[2]), partitionId));
+		chunk.zoneLines.push_back(lineNumber);
+	}
+
+	void ParseChunk(Chunk& chunk) {
+		std::string_view text = chunk.text;
+		// Rough guess of one zone per 32 bytes, to avoid regrowing
+		chunk.zones.reserve(text.size() / 32);
+		chunk.zoneLines.reserve(text.size() / 32);
+		while (!text.empty()) {
+			size_t end = text.find('\n');
+			std::string_view line = text.substr(0, end);
+			text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+			chunk.lineCount++;
+			if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+			if (line.empty()) continue;
+			ParseLine(chunk, line);
+		}
+	}
+}
+
+ZoneCsvResult ZoneCsvLoader::Load(const std::string& path, size_t threadCount)
+{
+	MappedFile file;
+	if (!file.Open(path)) {
+		// Mapping an empty file fails; that is still an (empty) zone list
+		std::error_code error;
+		ZoneCsvResult result;
+		result.opened = std::filesystem::is_regular_file(path, error) && std::filesystem::file_size(path, error) == 0 && !error;
+		return result;
+	}
+	ZoneCsvResult result = Parse(std::string_view(file.Data(), file.Size()), threadCount);
+	result.opened = true;
+	return result;
+}
+ZoneCsvResult ZoneCsvLoader::Parse(std::string_view text, size_t threadCount)
+{
+	// UTF-8 byte order mark, as saved by some editors
+	if (text.size() >= 3 && std::memcmp(text.data(), "\xEF\xBB\xBF", 3) == 0) text.remove_prefix(3);
+
+	if (threadCount == 0) threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+	size_t chunkCount = std::clamp<size_t>(text.size() / kMinChunkBytes, 1, threadCount);
+
+	// Split at the first newline after each even share of the text
+	std::vector<Chunk> chunks(chunkCount);
+	size_t start = 0;
+	for (size_t i = 0; i < chunkCount; i++) {
+		size_t end = text.size();
+		if (i + 1 < chunkCount) {
+			end = text.find('\n', std::max(start, text.size() / chunkCount * (i + 1)));
+			end = end == std::string_view::npos ? text.size() : end + 1;
+		}
+		chunks[i].text = text.substr(start, end - start);
+		start = end;
+	}
+
+	std::vector<std::thread> workers;
+	workers.reserve(chunkCount - 1);
+	for (size_t i = 1; i < chunkCount; i++) {
+		workers.emplace_back(ParseChunk, std::ref(chunks[i]));
+	}
+	ParseChunk(chunks[0]);
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	ZoneCsvResult result;
+	result.chunkCount = chunkCount;
+	size_t zoneCount = 0;
+	for (const auto& chunk : chunks) {
+		zoneCount += chunk.zones.size();
+	}
+	result.zones.reserve(zoneCount);
+	result.zoneLines.reserve(zoneCount);
+	for (auto& chunk : chunks) {
+		size_t firstLine = result.lineCount + 1;
+		for (auto& zone : chunk.zones) {
+			result.zones.push_back(std::move(zone));
+		}
+		for (size_t line : chunk.zoneLines) {
+			result.zoneLines.push_back(firstLine + line - 1);
+		}
+		for (auto& issue : chunk.skipped) {
+			result.skipped.push_back({ firstLine + issue.line - 1, std::move(issue.reason) });
+		}
+		for (auto& issue : chunk.warnings) {
+			result.warnings.push_back({ firstLine + issue.line - 1, std::move(issue.reason) });
+		}
+		result.lineCount += chunk.lineCount;
+	}
+	return result;
+}
+void ZoneCsvLoader::Validate(ZoneCsvResult& result, const std::vector<int>& partitionIds)
+{
+	std::unordered_set<int> knownPartitions(partitionIds.begin(), partitionIds.end());
+	std::unordered_set<int> seenZones;
+	seenZones.reserve(result.zones.size());
+
+	size_t kept = 0;
+	for (size_t i = 0; i < result.zones.size(); i++) {
+		const Zone& zone = *result.zones[i];
+		if (!seenZones.insert(zone.id).second) {
+			result.skipped.push_back({ result.zoneLines[i], "duplicate zone id " + std::to_string(zone.id) });
+			continue;
+		}
+		if (zone.partitionId != -1 && knownPartitions.count(zone.partitionId) == 0) {
+			result.warnings.push_back({ result.zoneLines[i], "unknown partition " + std::to_string(zone.partitionId) });
+		}
+		result.zones[kept] = std::move(result.zones[i]);
+		result.zoneLines[kept] = result.zoneLines[i];
+		kept++;
+	}
+	result.zones.resize(kept);
+	result.zoneLines.resize(kept);
+
+	auto byLine = [](const CsvLineIssue& a, const CsvLineIssue& b) { return a.line < b.line; };
+	std::stable_sort(result.skipped.begin(), result.skipped.end(), byLine);
+	std::stable_sort(result.warnings.begin(), result.warnings.end(), byLine);
+}
+std::string ZoneCsvLoader::Summarize(const std::vector<CsvLineIssue>& issues, size_t limit)
+{
+	std::string summary;
+	for (size_t i = 0; i < issues.size() && i < limit; i++) {
+		if (i > 0) summary += "; ";
+		summary += "line " + std::to_string(issues[i].line) + ": " + issues[i].reason;
+	}
+	if (issues.size() > limit) {
+		summary += "; and " + std::to_string(issues.size() - limit) + " more";
+	}
+	return summary;
+}
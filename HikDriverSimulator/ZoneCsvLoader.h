@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Zone.h"
+
+// A zones.csv line that was skipped or loaded with a problem
+struct CsvLineIssue {
+	size_t line;
+	std::string reason;
+};
+
+struct ZoneCsvResult {
+	bool opened = false;
+	std::vector<std::shared_ptr<Zone>> zones;
+	std::vector<size_t> zoneLines;			// source line of each zone
+	std::vector<CsvLineIssue> skipped;		// malformed, not loaded
+	std::vector<CsvLineIssue> warnings;		// loaded, but not as written
+	size_t lineCount = 0;
+	size_t chunkCount = 0;
+};
+
+// Loads zones.csv ("id;type;name[;partitionId]" per line). The file is
+// mapped and split at line boundaries into chunks that are parsed, and
+// their zones constructed, on separate threads; results are merged in
+// file order. Small files are parsed on the calling thread.
+class ZoneCsvLoader
+{
+public:
+	static constexpr size_t kMinChunkBytes = 256 * 1024;
+
+	// threadCount 0 uses every hardware thread
+	static ZoneCsvResult Load(const std::string& path, size_t threadCount = 0);
+	static ZoneCsvResult Parse(std::string_view text, size_t threadCount = 0);
+	// Drop repeated zone ids (the first one wins) and flag zones whose
+	// partition is not in partitionIds
+	static void Validate(ZoneCsvResult& result, const std::vector<int>& partitionIds);
+	// "line 3: bad zone id; line 9: ..." listing at most limit issues
+	static std::string Summarize(const std::vector<CsvLineIssue>& issues, size_t limit = 10);
+};
@@ -0,0 +1,27 @@
+#include "ZoneFactory.h"
+#include "DoorContact.h"
+#include "MotionSenzor.h"
+
+std::shared_ptr<Zone> ZoneFactory::Create(ZoneKind kind, int zoneId, const std::string& zoneName, int partitionId)
+{
+	switch (kind) {
+	case ZoneKind::MOTION_SENSOR:
+		return std::make_shared<MotionSenzor>(zoneId, zoneName, partitionId);
+	case ZoneKind::DOOR_CONTACT:
+		return std::make_shared<DoorContact>(zoneId, zoneName, partitionId);
+	default:
+		return std::make_shared<Zone>(zoneId, zoneName, partitionId);
+	}
+}
+ZoneKind ZoneFactory::KindOf(const Zone& zone)
+{
+	if (dynamic_cast<const MotionSenzor*>(&zone)) return ZoneKind::MOTION_SENSOR;
+	if (dynamic_cast<const DoorContact*>(&zone)) return ZoneKind::DOOR_CONTACT;
+	return ZoneKind::GENERIC;
+}
+ZoneKind ZoneFactory::KindFromTypeName(std::string_view typeName)
+{
+	if (typeName == "Motion Sensor") return ZoneKind::MOTION_SENSOR;
+	if (typeName == "Door Contact") return ZoneKind::DOOR_CONTACT;
+	return ZoneKind::GENERIC;
+}
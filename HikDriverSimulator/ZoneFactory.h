@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "Zone.h"
+
+// Concrete zone classes, as stored in snapshots
+enum class ZoneKind : uint8_t {
+	GENERIC = 0,
+	MOTION_SENSOR = 1,
+	DOOR_CONTACT = 2
+};
+
+// Creates zones of the type named in zones.csv or stored in a snapshot
+class ZoneFactory
+{
+public:
+	static std::shared_ptr<Zone> Create(ZoneKind kind, int zoneId, const std::string& zoneName, int partitionId);
+	static ZoneKind KindOf(const Zone& zone);
+	// "Motion Sensor" / "Door Contact"; anything else is a generic zone
+	static ZoneKind KindFromTypeName(std::string_view typeName);
+};
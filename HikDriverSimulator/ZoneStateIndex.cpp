@@ -0,0 +1,190 @@
+#include "ZoneStateIndex.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cctype>
+#include <charconv>
+
+namespace {
+	// Words evaluated per block; sized so the scratch arrays stay in L1
+	constexpr size_t kBlockWords = 64;
+
+	std::string Trim(const std::string& text) {
+		size_t first = text.find_first_not_of(" \t");
+		if (first == std::string::npos) return "";
+		size_t last = text.find_last_not_of(" \t");
+		return text.substr(first, last - first + 1);
+	}
+	std::string ToLower(std::string text) {
+		std::transform(text.begin(), text.end(), text.begin(),
+			[](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return text;
+	}
+	bool ParseLiteral(std::string token, ZoneFilterLiteral& literal, std::string& error) {
+		token = Trim(token);
+		while (!token.empty() && token[0] == '!') {
+			literal.negated = !literal.negated;
+			token = Trim(token.substr(1));
+		}
+		std::string name = ToLower(token);
+
+		if (name.rfind("partition=", 0) == 0) {
+			std::string value = Trim(name.substr(10));
+			auto result = std::from_chars(value.data(), value.data() + value.size(), literal.partitionId);
+			if (value.empty() || result.ec != std::errc() || result.ptr != value.data() + value.size()) {
+				error = "invalid partition id '" + value + "'";
+				return false;
+			}
+			literal.isPartition = true;
+			return true;
+		}
+		if (name == "armed") literal.flag = ZoneFlag::ARMED;
+		else if (name == "disarmed") { literal.flag = ZoneFlag::ARMED; literal.negated = !literal.negated; }
+		else if (name == "bypassed") literal.flag = ZoneFlag::BYPASSED;
+		else if (name == "alarming") literal.flag = ZoneFlag::ALARMING;
+		else if (name == "active") literal.flag = ZoneFlag::ACTIVE;
+		else if (name == "tampered") literal.flag = ZoneFlag::TAMPERED;
+		else if (name == "faulted") literal.flag = ZoneFlag::FAULTED;
+		else {
+			error = "unknown term '" + token + "'";
+			return false;
+		}
+		return true;
+	}
+}
+
+bool ZoneFilter::Parse(const std::string& text, ZoneFilter& filter, std::string& error)
+{
+	filter.clauses.clear();
+	size_t clauseStart = 0;
+
+	while (clauseStart <= text.size()) {
+		size_t clauseEnd = text.find('|', clauseStart);
+		if (clauseEnd == std::string::npos) clauseEnd = text.size();
+		std::string clauseText = text.substr(clauseStart, clauseEnd - clauseStart);
+
+		std::vector<ZoneFilterLiteral> clause;
+		size_t termStart = 0;
+		while (termStart <= clauseText.size()) {
+			size_t termEnd = clauseText.find('&', termStart);
+			if (termEnd == std::string::npos) termEnd = clauseText.size();
+			std::string term = Trim(clauseText.substr(termStart, termEnd - termStart));
+
+			if (term.empty()) {
+				error = "empty term in filter";
+				return false;
+			}
+			// "all" is the empty conjunction: it matches every zone
+			if (ToLower(term) != "all") {
+				ZoneFilterLiteral literal;
+				if (!ParseLiteral(term, literal, error)) return false;
+				clause.push_back(literal);
+			}
+			termStart = termEnd + 1;
+		}
+		filter.clauses.push_back(clause);
+		clauseStart = clauseEnd + 1;
+	}
+	return true;
+}
+
+void ZoneStateIndex::Reset(size_t zones, size_t partitions)
+{
+	zoneCount = zones;
+	wordCount = (zones + 63) / 64;
+	for (auto& column : flagColumns) {
+		column.assign(wordCount, 0);
+	}
+	partitionColumns.assign(partitions, std::vector<uint64_t>(wordCount, 0));
+	zeroColumn.assign(wordCount, 0);
+}
+void ZoneStateIndex::SetBit(std::vector<uint64_t>& column, uint32_t slot, bool value)
+{
+	std::atomic_ref<uint64_t> word(column[slot / 64]);
+	uint64_t bit = 1ull << (slot % 64);
+	if (value) word.fetch_or(bit, std::memory_order_relaxed);
+	else word.fetch_and(~bit, std::memory_order_relaxed);
+}
+// Copy a zone's flags into the columns; call after every state change
+void ZoneStateIndex::SyncZone(uint32_t zoneSlot, const Zone& zone)
+{
+	if (zoneSlot >= zoneCount) return;
+	SetBit(flagColumns[static_cast<size_t>(ZoneFlag::ARMED)], zoneSlot, zone.isArmed);
+	SetBit(flagColumns[static_cast<size_t>(ZoneFlag::BYPASSED)], zoneSlot, zone.isBypassed);
+	SetBit(flagColumns[static_cast<size_t>(ZoneFlag::ALARMING)], zoneSlot, zone.isAlarming);
+	SetBit(flagColumns[static_cast<size_t>(ZoneFlag::ACTIVE)], zoneSlot, zone.isActive);
+	SetBit(flagColumns[static_cast<size_t>(ZoneFlag::TAMPERED)], zoneSlot, zone.isTampered);
+	SetBit(flagColumns[static_cast<size_t>(ZoneFlag::FAULTED)], zoneSlot, zone.isFaulted);
+}
+void ZoneStateIndex::SetPartitionMember(uint32_t partitionSlot, uint32_t zoneSlot, bool member)
+{
+	if (partitionSlot >= partitionColumns.size() || zoneSlot >= zoneCount) return;
+	SetBit(partitionColumns[partitionSlot], zoneSlot, member);
+}
+const uint64_t* ZoneStateIndex::ColumnFor(const ZoneFilterLiteral& literal) const
+{
+	if (literal.isPartition) {
+		if (literal.partitionSlot >= partitionColumns.size()) return zeroColumn.data();
+		return partitionColumns[literal.partitionSlot].data();
+	}
+	return flagColumns[static_cast<size_t>(literal.flag)].data();
+}
+// Valid bits of a word; the last word may be partially used
+uint64_t ZoneStateIndex::TailMask(size_t word) const
+{
+	size_t usedBits = zoneCount - word * 64;
+	return usedBits >= 64 ? ~0ull : ((1ull << usedBits) - 1);
+}
+template <typename Sink>
+void ZoneStateIndex::Evaluate(const ZoneFilter& filter, Sink&& sink) const
+{
+	uint64_t result[kBlockWords];
+	uint64_t clauseBits[kBlockWords];
+
+	for (size_t base = 0; base < wordCount; base += kBlockWords) {
+		size_t words = std::min(kBlockWords, wordCount - base);
+		std::fill(result, result + words, 0ull);
+
+		for (const auto& clause : filter.clauses) {
+			std::fill(clauseBits, clauseBits + words, ~0ull);
+			for (const auto& literal : clause) {
+				const uint64_t* column = ColumnFor(literal) + base;
+				const uint64_t flip = literal.negated ? ~0ull : 0ull;
+				for (size_t i = 0; i < words; i++) {
+					clauseBits[i] &= column[i] ^ flip;
+				}
+			}
+			for (size_t i = 0; i < words; i++) {
+				result[i] |= clauseBits[i];
+			}
+		}
+		if (base + words == wordCount) {
+			result[words - 1] &= TailMask(wordCount - 1);
+		}
+		sink(base, result, words);
+	}
+}
+void ZoneStateIndex::Select(const ZoneFilter& filter, std::vector<uint32_t>& slots) const
+{
+	slots.clear();
+	Evaluate(filter, [&slots](size_t base, const uint64_t* words, size_t count) {
+		for (size_t i = 0; i < count; i++) {
+			uint64_t bits = words[i];
+			while (bits) {
+				uint32_t bit = static_cast<uint32_t>(std::countr_zero(bits));
+				slots.push_back(static_cast<uint32_t>((base + i) * 64 + bit));
+				bits &= bits - 1;
+			}
+		}
+	});
+}
+size_t ZoneStateIndex::Count(const ZoneFilter& filter) const
+{
+	size_t total = 0;
+	Evaluate(filter, [&total](size_t, const uint64_t* words, size_t count) {
+		for (size_t i = 0; i < count; i++) {
+			total += std::popcount(words[i]);
+		}
+	});
+	return total;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Zone.h"
+
+enum class ZoneFlag {
+	ARMED,
+	BYPASSED,
+	ALARMING,
+	ACTIVE,
+	TAMPERED,
+	FAULTED,
+	COUNT
+};
+
+// One operand of a zone filter: a state flag or partition membership,
+// optionally negated. partitionSlot is resolved by AlarmService.
+struct ZoneFilterLiteral {
+	bool isPartition = false;
+	ZoneFlag flag = ZoneFlag::ARMED;
+	int partitionId = -1;
+	uint32_t partitionSlot = UINT32_MAX;
+	bool negated = false;
+};
+
+// Filter in disjunctive normal form: OR of AND-clauses.
+// Syntax: "armed&!bypassed&partition=2|alarming". Names are case-insensitive,
+// "disarmed" is shorthand for "!armed" and "all" matches every zone.
+struct ZoneFilter {
+	std::vector<std::vector<ZoneFilterLiteral>> clauses;
+
+	static bool Parse(const std::string& text, ZoneFilter& filter, std::string& error);
+};
+
+// Zone state stored as packed bit columns, one bit per zone slot.
+// Filters are evaluated 64 zones per word with plain AND/OR/NOT loops the
+// compiler vectorizes, and counts use popcount, so large queries touch only
+// a few bytes per zone instead of one heap object each.
+//
+// Writers flip bits with atomic read-modify-write because zones of different
+// partitions share words and are updated under different lock stripes.
+// Readers hold every stripe shared, so they see no concurrent writer and
+// scan the columns as ordinary memory.
+class ZoneStateIndex
+{
+private:
+	static constexpr size_t kFlagCount = static_cast<size_t>(ZoneFlag::COUNT);
+
+	size_t zoneCount = 0;
+	size_t wordCount = 0;
+	std::vector<uint64_t> flagColumns[kFlagCount];
+	std::vector<std::vector<uint64_t>> partitionColumns;
+	std::vector<uint64_t> zeroColumn;
+
+	const uint64_t* ColumnFor(const ZoneFilterLiteral& literal) const;
+	static void SetBit(std::vector<uint64_t>& column, uint32_t slot, bool value);
+	uint64_t TailMask(size_t word) const;
+	template <typename Sink>
+	void Evaluate(const ZoneFilter& filter, Sink&& sink) const;
+
+public:
+	void Reset(size_t zones, size_t partitions);
+	void SyncZone(uint32_t zoneSlot, const Zone& zone);
+	void SetPartitionMember(uint32_t partitionSlot, uint32_t zoneSlot, bool member);
+
+	// Slots of matching zones in ascending order
+	void Select(const ZoneFilter& filter, std::vector<uint32_t>& slots) const;
+	size_t Count(const ZoneFilter& filter) const;
+};
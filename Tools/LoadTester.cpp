@@ -0,0 +1,525 @@
+// Open-loop TCP load generator for TcpServer. Opens many persistent
+// connections, sends a weighted command mix at a fixed target rate and
+// reports throughput and latency percentiles. Latency is measured from the
+// time each request was due to be sent, not from when it was actually
+// written, so a server stall is charged to every request it delayed
+// (coordinated-omission correction); the uncorrected figures are shown too.
+//
+// Usage: LoadTester [options]
+//   --host 127.0.0.1 --port 12345      server address
+//   --connections 64 --threads 2       sockets, spread over client threads
+//   --rate 5000                        requests per second, all connections
+//   --duration 30 --warmup 2           measured seconds, after warm-up seconds
+//   --mix polling|trigger-storm|list-flood|NAME=weight,...
+//   --zones 1-100 --partitions 1-2     ids the commands pick from
+//   --json report.json                 write the results as JSON
+//   --baseline report.json --tolerance 10
+//       exit 1 when throughput is more than tolerance % below, or p50, p99
+//       or p99.9 latency more than tolerance % above the baseline report,
+//       or on ERROR replies when the baseline had none
+//
+// Build: the LoadTester target of the top-level CMakeLists.txt
+//   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target LoadTester
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "CommandParser.h"
+#include "LatencyHistogram.h"
+#include "Poller.h"
+#include "SocketApi.h"
+
+using json = nlohmann::json;
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	enum class Target : uint8_t {
+		NONE,
+		ZONE,
+		PARTITION
+	};
+
+	struct MixEntry {
+		std::string command;
+		Target target = Target::NONE;
+		uint64_t weight = 0;
+	};
+
+	struct Options {
+		std::string host = "127.0.0.1";
+		int port = 12345;
+		size_t connections = 64;
+		size_t threads = 2;
+		double rate = 5000.0;
+		double durationSeconds = 30.0;
+		double warmupSeconds = 2.0;
+		std::string mixName = "polling";
+		std::vector<MixEntry> mix;
+		std::vector<int> zones{ 1, 2, 3, 4, 5 };
+		std::vector<int> partitions{ 1, 2 };
+		std::string jsonPath;
+		std::string baselinePath;
+		double tolerancePercent = 10.0;
+	};
+
+	// A request written (or due to be written) and not yet answered
+	struct Outstanding {
+		Clock::time_point due;
+		Clock::time_point sent;
+		uint16_t mixIndex;
+	};
+
+	struct Connection {
+		SocketHandle socket = kInvalidSocket;
+		std::string out;
+		size_t outOffset = 0;
+		std::string in;
+		std::deque<Outstanding> pending;
+		bool waitingToWrite = false;
+		bool closed = false;
+	};
+
+	struct ThreadStats {
+		LatencyHistogram corrected;
+		LatencyHistogram uncorrected;
+		LatencyHistogram sendLag;	// how late the client itself wrote requests
+		std::vector<LatencyHistogram> perCommand;
+		uint64_t sent = 0;
+		uint64_t errors = 0;		// replies with status ERROR
+		uint64_t unanswered = 0;	// lost with a closed connection or still pending at the end
+	};
+
+	constexpr int kMaxIds = 1000000;
+	constexpr auto kDrainTime = std::chrono::seconds(5);
+
+	uint64_t Nanos(Clock::duration duration)
+	{
+		auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+		return nanos > 0 ? static_cast<uint64_t>(nanos) : 0;
+	}
+	double Micros(uint64_t nanos)
+	{
+		return static_cast<double>(nanos) / 1000.0;
+	}
+
+	Target TargetOf(std::string_view command)
+	{
+		static const char* zoneCommands[] = { "ARM", "DISARM", "BYPASS", "UNBYPASS", "STATUS", "TRIGGER", "LIST_ONE_ZONE" };
+		for (const char* name : zoneCommands) {
+			if (command == name) return Target::ZONE;
+		}
+		if (command == "ARM_PARTITION" || command == "DISARM_PARTITION") return Target::PARTITION;
+		return Target::NONE;
+	}
+
+	bool ParseMix(const std::string& text, std::vector<MixEntry>& mix)
+	{
+		// Presets for the usual shapes of traffic
+		if (text == "polling") return ParseMix("STATUS=95,LIST_ALARMING_ZONES=4,LIST_ALL_ZONES=1", mix);
+		if (text == "trigger-storm") return ParseMix("TRIGGER=70,STATUS=20,ARM=5,DISARM=5", mix);
+		if (text == "list-flood") return ParseMix("LIST_ALL_ZONES=90,STATUS=10", mix);
+
+		mix.clear();
+		std::string_view rest = text;
+		while (!rest.empty()) {
+			size_t comma = rest.find(',');
+			std::string_view item = rest.substr(0, comma);
+			rest = comma == std::string_view::npos ? std::string_view() : rest.substr(comma + 1);
+			size_t equals = item.find('=');
+			if (equals == std::string_view::npos) return false;
+			MixEntry entry;
+			entry.command = std::string(item.substr(0, equals));
+			for (char& c : entry.command) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+			if (entry.command.empty() || !CommandParser::ParseUnsigned(item.substr(equals + 1), entry.weight)) return false;
+			if (entry.weight == 0) return false;
+			entry.target = TargetOf(entry.command);
+			mix.push_back(entry);
+		}
+		return !mix.empty() && mix.size() <= UINT16_MAX;
+	}
+
+	bool ParseOptions(int argc, char* argv[], Options& options)
+	{
+		for (int i = 1; i < argc; i++) {
+			std::string argument = argv[i];
+			if (i + 1 >= argc) return false;
+			std::string value = argv[++i];
+			if (argument == "--host") options.host = value;
+			else if (argument == "--port") options.port = std::atoi(value.c_str());
+			else if (argument == "--connections") options.connections = std::strtoul(value.c_str(), nullptr, 10);
+			else if (argument == "--threads") options.threads = std::strtoul(value.c_str(), nullptr, 10);
+			else if (argument == "--rate") options.rate = std::atof(value.c_str());
+			else if (argument == "--duration") options.durationSeconds = std::atof(value.c_str());
+			else if (argument == "--warmup") options.warmupSeconds = std::atof(value.c_str());
+			else if (argument == "--mix") options.mixName = value;
+			else if (argument == "--zones") {
+				if (!CommandParser::ParseIdList(value, options.zones, kMaxIds)) return false;
+			}
+			else if (argument == "--partitions") {
+				if (!CommandParser::ParseIdList(value, options.partitions, kMaxIds)) return false;
+			}
+			else if (argument == "--json") options.jsonPath = value;
+			else if (argument == "--baseline") options.baselinePath = value;
+			else if (argument == "--tolerance") options.tolerancePercent = std::atof(value.c_str());
+			else return false;
+		}
+		if (!ParseMix(options.mixName, options.mix)) return false;
+		options.threads = std::max<size_t>(1, std::min(options.threads, options.connections));
+		return options.connections > 0 && options.rate > 0.0 && options.durationSeconds > 0.0 && options.warmupSeconds >= 0.0;
+	}
+
+	class ClientThread
+	{
+	public:
+		ClientThread(const Options& options, std::vector<Connection>& connections, size_t index)
+			: options(options), connections(connections), random(0x5eed + index), threadIndex(index)
+		{
+			stats.perCommand.resize(options.mix.size());
+			for (const auto& entry : options.mix) totalWeight += entry.weight;
+		}
+
+		void Run(Clock::time_point start, Clock::time_point measureFrom, Clock::time_point sendEnd)
+		{
+			poller = Poller::Create();
+			for (size_t i = 0; i < connections.size(); i++) {
+				poller->Add(connections[i].socket, POLL_READABLE);
+				bySocket[connections[i].socket] = i;
+			}
+			// Even spacing, as a paced client would send; threads are offset
+			// so their requests interleave
+			auto interval = std::chrono::duration_cast<Clock::duration>(
+				std::chrono::duration<double>(static_cast<double>(options.threads) / options.rate));
+			Clock::time_point next = start + interval * threadIndex / options.threads;
+			this->measureFrom = measureFrom;
+			this->sendEnd = sendEnd;
+
+			std::vector<PollResult> ready;
+			while (true) {
+				auto now = Clock::now();
+				if (next < sendEnd) {
+					while (next <= now && next < sendEnd) {
+						Issue(next);
+						next += interval;
+					}
+				}
+				else if (!AnyPending() || now >= sendEnd + kDrainTime) {
+					break;
+				}
+				if (LiveConnections() == 0) break;
+
+				// Wait in whole milliseconds and poll without blocking for
+				// the last one, so requests leave on time
+				int timeoutMs = 10;
+				if (next < sendEnd) {
+					auto untilNext = std::chrono::duration_cast<std::chrono::milliseconds>(next - Clock::now()).count();
+					timeoutMs = static_cast<int>(std::clamp<long long>(untilNext, 0, 10));
+				}
+				int count = poller->Wait(ready, timeoutMs);
+				for (int i = 0; i < count; i++) {
+					Connection* connection = Find(ready[i].socket);
+					if (connection == nullptr || connection->closed) continue;
+					if (ready[i].events & POLL_WRITABLE) Flush(*connection);
+					if (ready[i].events & (POLL_READABLE | POLL_HANGUP)) Read(*connection);
+				}
+			}
+			for (auto& connection : connections) {
+				stats.unanswered += connection.pending.size();
+				connection.pending.clear();
+			}
+		}
+
+		ThreadStats stats;
+
+	private:
+		const Options& options;
+		std::vector<Connection>& connections;
+		std::unique_ptr<Poller> poller;
+		std::unordered_map<SocketHandle, size_t> bySocket;
+		std::mt19937_64 random;
+		size_t threadIndex;
+		uint64_t totalWeight = 0;
+		size_t nextConnection = 0;
+		Clock::time_point measureFrom;
+		Clock::time_point sendEnd;
+
+		void Issue(Clock::time_point due)
+		{
+			Connection* connection = nullptr;
+			for (size_t tries = 0; tries < connections.size() && connection == nullptr; tries++) {
+				Connection& candidate = connections[nextConnection];
+				nextConnection = (nextConnection + 1) % connections.size();
+				if (!candidate.closed) connection = &candidate;
+			}
+			if (connection == nullptr) return;
+
+			uint64_t pick = random() % totalWeight;
+			uint16_t mixIndex = 0;
+			while (pick >= options.mix[mixIndex].weight) {
+				pick -= options.mix[mixIndex].weight;
+				mixIndex++;
+			}
+			const MixEntry& entry = options.mix[mixIndex];
+			connection->out += entry.command;
+			if (entry.target == Target::ZONE) {
+				connection->out += ':' + std::to_string(options.zones[random() % options.zones.size()]);
+			}
+			else if (entry.target == Target::PARTITION) {
+				connection->out += ':' + std::to_string(options.partitions[random() % options.partitions.size()]);
+			}
+			connection->out += '\n';
+
+			auto now = Clock::now();
+			connection->pending.push_back({ due, now, mixIndex });
+			if (due >= measureFrom) stats.sendLag.Record(Nanos(now - due));
+			stats.sent++;
+			if (!connection->waitingToWrite) Flush(*connection);
+		}
+
+		void Flush(Connection& connection)
+		{
+			while (connection.outOffset < connection.out.size()) {
+				int sent = SocketApi::Send(connection.socket, connection.out.data() + connection.outOffset,
+					static_cast<int>(std::min<size_t>(connection.out.size() - connection.outOffset, 1 << 20)));
+				if (sent == SocketApi::kWouldBlock) break;
+				if (sent <= 0) {
+					Lose(connection);
+					return;
+				}
+				connection.outOffset += static_cast<size_t>(sent);
+			}
+			if (connection.outOffset == connection.out.size()) {
+				connection.out.clear();
+				connection.outOffset = 0;
+			}
+			bool waiting = !connection.out.empty();
+			if (waiting != connection.waitingToWrite) {
+				connection.waitingToWrite = waiting;
+				poller->Modify(connection.socket, waiting ? POLL_READABLE | POLL_WRITABLE : POLL_READABLE);
+			}
+		}
+
+		void Read(Connection& connection)
+		{
+			char buffer[64 * 1024];
+			while (true) {
+				int received = SocketApi::Receive(connection.socket, buffer, sizeof(buffer));
+				if (received == SocketApi::kWouldBlock) break;
+				if (received <= 0) {
+					Lose(connection);
+					return;
+				}
+				connection.in.append(buffer, static_cast<size_t>(received));
+			}
+			auto now = Clock::now();
+			size_t lineStart = 0;
+			size_t newline;
+			while ((newline = connection.in.find('\n', lineStart)) != std::string::npos) {
+				std::string_view line(connection.in.data() + lineStart, newline - lineStart);
+				lineStart = newline + 1;
+				// Replies come back in request order
+				if (connection.pending.empty()) continue;
+				Outstanding request = connection.pending.front();
+				connection.pending.pop_front();
+				if (request.due < measureFrom) continue;
+				stats.corrected.Record(Nanos(now - request.due));
+				stats.uncorrected.Record(Nanos(now - request.sent));
+				stats.perCommand[request.mixIndex].Record(Nanos(now - request.due));
+				if (line.find("\"status\":\"ERROR\"") != std::string_view::npos) stats.errors++;
+			}
+			connection.in.erase(0, lineStart);
+		}
+
+		void Lose(Connection& connection)
+		{
+			stats.unanswered += connection.pending.size();
+			connection.pending.clear();
+			connection.closed = true;
+			poller->Remove(connection.socket);
+		}
+
+		Connection* Find(SocketHandle socket)
+		{
+			auto found = bySocket.find(socket);
+			return found == bySocket.end() ? nullptr : &connections[found->second];
+		}
+		bool AnyPending() const
+		{
+			for (const auto& connection : connections) {
+				if (!connection.closed && !connection.pending.empty()) return true;
+			}
+			return false;
+		}
+		size_t LiveConnections() const
+		{
+			size_t live = 0;
+			for (const auto& connection : connections) {
+				if (!connection.closed) live++;
+			}
+			return live;
+		}
+	};
+
+	json Percentiles(const LatencyHistogram& histogram)
+	{
+		return {
+			{ "count", histogram.Count() },
+			{ "mean", histogram.Mean() / 1000.0 },
+			{ "p50", Micros(histogram.Percentile(50.0)) },
+			{ "p90", Micros(histogram.Percentile(90.0)) },
+			{ "p99", Micros(histogram.Percentile(99.0)) },
+			{ "p999", Micros(histogram.Percentile(99.9)) },
+			{ "max", Micros(histogram.Max()) }
+		};
+	}
+	void PrintRow(const char* label, const LatencyHistogram& histogram)
+	{
+		std::printf("%-22s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", label,
+			static_cast<unsigned long long>(histogram.Count()), histogram.Mean() / 1000.0,
+			Micros(histogram.Percentile(50.0)), Micros(histogram.Percentile(90.0)), Micros(histogram.Percentile(99.0)),
+			Micros(histogram.Percentile(99.9)), Micros(histogram.Max()));
+	}
+
+	// Lists every metric that is worse than the baseline by more than the tolerance
+	bool CheckBaseline(const json& report, const std::string& path, double tolerancePercent)
+	{
+		json baseline;
+		try {
+			std::ifstream file(path);
+			baseline = json::parse(file);
+		}
+		catch (const json::exception& e) {
+			std::printf("Cannot read baseline %s: %s\n", path.c_str(), e.what());
+			return false;
+		}
+		double tolerance = tolerancePercent / 100.0;
+		bool passed = true;
+		double throughput = report["throughput"].get<double>();
+		double baseThroughput = baseline.value("throughput", 0.0);
+		if (throughput < baseThroughput * (1.0 - tolerance)) {
+			std::printf("REGRESSION throughput %.1f/s < baseline %.1f/s\n", throughput, baseThroughput);
+			passed = false;
+		}
+		for (const char* key : { "p50", "p99", "p999" }) {
+			double value = report["latencyMicros"][key].get<double>();
+			double base = baseline["latencyMicros"].value(key, 0.0);
+			if (base > 0.0 && value > base * (1.0 + tolerance)) {
+				std::printf("REGRESSION latency %s %.1f us > baseline %.1f us\n", key, value, base);
+				passed = false;
+			}
+		}
+		uint64_t errors = report["errors"].get<uint64_t>();
+		if (errors > 0 && baseline.value("errors", uint64_t(0)) == 0) {
+			std::printf("REGRESSION %llu ERROR replies, baseline had none\n", static_cast<unsigned long long>(errors));
+			passed = false;
+		}
+		if (passed) std::printf("Within %.0f%% of baseline %s\n", tolerancePercent, path.c_str());
+		return passed;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options)) {
+		std::fprintf(stderr, "Invalid arguments; see the top of Tools/LoadTester.cpp for usage\n");
+		return 2;
+	}
+	if (!SocketApi::Startup()) return 2;
+
+	// Connections are dealt out to the threads round-robin
+	std::vector<std::vector<Connection>> groups(options.threads);
+	for (size_t i = 0; i < options.connections; i++) {
+		std::string error;
+		SocketHandle socket = SocketApi::Connect(options.host, options.port, error);
+		if (socket == kInvalidSocket) {
+			std::fprintf(stderr, "%s\n", error.c_str());
+			return 2;
+		}
+		SocketApi::SetNoDelay(socket);
+		SocketApi::SetNonBlocking(socket);
+		Connection connection;
+		connection.socket = socket;
+		groups[i % options.threads].push_back(std::move(connection));
+	}
+
+	std::vector<std::unique_ptr<ClientThread>> clients;
+	for (size_t i = 0; i < options.threads; i++) {
+		clients.push_back(std::make_unique<ClientThread>(options, groups[i], i));
+	}
+	auto start = Clock::now() + std::chrono::milliseconds(100);
+	auto measureFrom = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.warmupSeconds));
+	auto sendEnd = measureFrom + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.durationSeconds));
+	std::vector<std::thread> threads;
+	for (auto& client : clients) {
+		threads.emplace_back(&ClientThread::Run, client.get(), start, measureFrom, sendEnd);
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	for (auto& group : groups) {
+		for (auto& connection : group) SocketApi::Close(connection.socket);
+	}
+	SocketApi::Cleanup();
+
+	ThreadStats total;
+	total.perCommand.resize(options.mix.size());
+	for (const auto& client : clients) {
+		total.corrected.Merge(client->stats.corrected);
+		total.uncorrected.Merge(client->stats.uncorrected);
+		total.sendLag.Merge(client->stats.sendLag);
+		for (size_t i = 0; i < options.mix.size(); i++) total.perCommand[i].Merge(client->stats.perCommand[i]);
+		total.sent += client->stats.sent;
+		total.errors += client->stats.errors;
+		total.unanswered += client->stats.unanswered;
+	}
+	double throughput = static_cast<double>(total.corrected.Count()) / options.durationSeconds;
+
+	std::printf("%s:%d, %zu connections, %zu threads, mix %s, %.0f req/s target for %.0f s (+%.0f s warm-up)\n",
+		options.host.c_str(), options.port, options.connections, options.threads, options.mixName.c_str(),
+		options.rate, options.durationSeconds, options.warmupSeconds);
+	std::printf("Throughput: %.1f responses/s (%.1f%% of target), %llu ERROR replies, %llu unanswered\n\n",
+		throughput, throughput / options.rate * 100.0, static_cast<unsigned long long>(total.errors),
+		static_cast<unsigned long long>(total.unanswered));
+	std::printf("%-22s %10s %10s %10s %10s %10s %10s %10s\n", "Microseconds", "Count", "Mean", "p50", "p90", "p99", "p99.9", "Max");
+	PrintRow("latency (corrected)", total.corrected);
+	PrintRow("latency (uncorrected)", total.uncorrected);
+	PrintRow("client send lag", total.sendLag);
+	for (size_t i = 0; i < options.mix.size(); i++) {
+		PrintRow(options.mix[i].command.c_str(), total.perCommand[i]);
+	}
+
+	json report;
+	report["config"] = { { "host", options.host }, { "port", options.port }, { "connections", options.connections },
+		{ "threads", options.threads }, { "rate", options.rate }, { "durationSeconds", options.durationSeconds },
+		{ "warmupSeconds", options.warmupSeconds }, { "mix", options.mixName } };
+	report["throughput"] = throughput;
+	report["errors"] = total.errors;
+	report["unanswered"] = total.unanswered;
+	report["latencyMicros"] = Percentiles(total.corrected);
+	report["uncorrectedMicros"] = Percentiles(total.uncorrected);
+	report["sendLagMicros"] = Percentiles(total.sendLag);
+	json commands = json::object();
+	for (size_t i = 0; i < options.mix.size(); i++) {
+		commands[options.mix[i].command] = Percentiles(total.perCommand[i]);
+	}
+	report["commands"] = commands;
+	if (!options.jsonPath.empty()) {
+		std::ofstream(options.jsonPath) << report.dump(2) << "\n";
+	}
+
+	bool passed = total.unanswered == 0;
+	if (!passed) std::printf("FAILED: %llu requests unanswered\n", static_cast<unsigned long long>(total.unanswered));
+	if (!options.baselinePath.empty() && !CheckBaseline(report, options.baselinePath, options.tolerancePercent)) passed = false;
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+// Turns a binary log (LogFileFormat::BINARY) back into the text format of
+// applcation.log: "[YYYY-mm-dd HH:MM:SS] [LEVEL] message".
+//
+// Usage: LogDecoder applcation.binlog [output.log]
+//
+// Build (from the repository root):
+//   g++ -std=c++20 -O2 -IHikDriverSimulator Tools/LogDecoder.cpp -o LogDecoder
+//   cl /std:c++20 /O2 /EHsc /IHikDriverSimulator Tools\LogDecoder.cpp
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "LogEncoding.h"
+
+namespace {
+	// Read the format catalog of an 'H' chunk
+	bool ReadHeader(std::string_view payload, std::vector<std::string>& formats) {
+		if (payload.size() < 8) return false;
+		if (LogEncoding::GetBytes(payload.data(), 4) != LogEncoding::kMagic) return false;
+		if (LogEncoding::GetBytes(payload.data() + 4, 2) != LogEncoding::kVersion) return false;
+		size_t count = static_cast<size_t>(LogEncoding::GetBytes(payload.data() + 6, 2));
+		size_t pos = 8;
+
+		formats.clear();
+		for (size_t i = 0; i < count; i++) {
+			if (payload.size() - pos < 2) return false;
+			size_t length = static_cast<size_t>(LogEncoding::GetBytes(payload.data() + pos, 2));
+			pos += 2;
+			if (payload.size() - pos < length) return false;
+			formats.emplace_back(payload.substr(pos, length));
+			pos += length;
+		}
+		return true;
+	}
+
+	bool WriteRecord(std::string_view payload, const std::vector<std::string>& formats, std::string& out) {
+		if (payload.size() < LogEncoding::kRecordHeaderSize) return false;
+		uint8_t level = static_cast<uint8_t>(payload[0]);
+		auto time = static_cast<std::time_t>(LogEncoding::GetBytes(payload.data() + 1, 8));
+		size_t format = static_cast<size_t>(LogEncoding::GetBytes(payload.data() + 9, 2));
+		if (format >= formats.size()) return false;
+
+		out += '[';
+		out += LogEncoding::FormatTime(time);
+		out += "] [";
+		out += LogEncoding::LevelName(level);
+		out += "] ";
+		if (!LogEncoding::Render(formats[format], payload.substr(LogEncoding::kRecordHeaderSize), out)) return false;
+		out += '\n';
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " <binary log> [output file]" << std::endl;
+		return 2;
+	}
+	std::ifstream input(argv[1], std::ios::binary);
+	if (!input.is_open()) {
+		std::cerr << "Cannot open " << argv[1] << std::endl;
+		return 1;
+	}
+	std::string data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+	std::ofstream outputFile;
+	if (argc > 2) {
+		outputFile.open(argv[2], std::ios::binary);
+		if (!outputFile.is_open()) {
+			std::cerr << "Cannot create " << argv[2] << std::endl;
+			return 1;
+		}
+	}
+	std::ostream& output = argc > 2 ? static_cast<std::ostream&>(outputFile) : std::cout;
+
+	std::vector<std::string> formats;
+	bool haveHeader = false;
+	size_t records = 0;
+	size_t pos = 0;
+	std::string text;
+
+	while (pos < data.size()) {
+		if (data.size() - pos < LogEncoding::kChunkHeaderSize) {
+			std::cerr << "Truncated chunk at offset " << pos << std::endl;
+			break;
+		}
+		char kind = data[pos];
+		size_t length = static_cast<size_t>(LogEncoding::GetBytes(data.data() + pos + 1, 4));
+		size_t payloadStart = pos + LogEncoding::kChunkHeaderSize;
+		if (data.size() - payloadStart < length) {
+			// A crash can cut the last chunk short; keep what was decoded
+			std::cerr << "Truncated chunk at offset " << pos << std::endl;
+			break;
+		}
+		std::string_view payload(data.data() + payloadStart, length);
+
+		if (kind == LogEncoding::kHeaderChunk) {
+			haveHeader = ReadHeader(payload, formats);
+			if (!haveHeader) {
+				std::cerr << "Unsupported log header at offset " << pos << std::endl;
+				return 1;
+			}
+		}
+		else if (kind == LogEncoding::kRecordChunk) {
+			if (!haveHeader) {
+				std::cerr << "Record before any header at offset " << pos << std::endl;
+				return 1;
+			}
+			if (!WriteRecord(payload, formats, text)) {
+				std::cerr << "Malformed record at offset " << pos << std::endl;
+			}
+			else {
+				records++;
+			}
+			if (text.size() >= 64 * 1024) {
+				output.write(text.data(), text.size());
+				text.clear();
+			}
+		}
+		// Unknown chunk kinds are skipped
+		pos = payloadStart + length;
+	}
+	output.write(text.data(), text.size());
+	output.flush();
+
+	std::cerr << records << " records decoded" << std::endl;
+	return 0;
+}